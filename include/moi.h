@@ -18,6 +18,21 @@
 /* 最大先読みサンプル数 */
 #define MOI_MAX_SEARCH_DEPTH 8
 
+/* 最大エンコードスレッド数 */
+#define MOI_MAX_NUM_THREADS 64
+
+/* トレリス探索で保持する最大状態数 */
+#define MOI_MAX_TRELLIS_NUM_STATES 32
+
+/* 先読み探索キャッシュの最大サイズ[byte] */
+#define MOI_MAX_SEARCH_CACHE_SIZE (1UL << 24)
+
+/* ブロックキャッシュの最大サイズ[byte] */
+#define MOI_MAX_BLOCK_CACHE_SIZE (1UL << 28)
+
+/* ポートフォリオ符号化で試す最大の探索設定数 */
+#define MOI_MAX_PORTFOLIO_SIZE 4
+
 /* API結果型 */
 typedef enum {
     MOI_APIRESULT_OK = 0,              /* 成功                         */
@@ -29,6 +44,12 @@ typedef enum {
     MOI_APIRESULT_NG                   /* 分類不能な失敗               */
 } MOIApiResult;
 
+/* 符号探索手法 */
+typedef enum {
+    MOI_SEARCH_METHOD_BEAM = 0,        /* 先読み付きビームサーチ       */
+    MOI_SEARCH_METHOD_TRELLIS          /* 状態併合による動的計画法     */
+} MOISearchMethod;
+
 /* IMA-ADPCM形式のwavファイルのヘッダ情報 */
 struct IMAADPCMWAVHeader {
     uint16_t num_channels;          /* チャンネル数                                 */
@@ -44,6 +65,9 @@ struct IMAADPCMWAVHeader {
 /* エンコーダ生成コンフィグ */
 struct MOIEncoderConfig {
     uint16_t max_block_size;        /* 最大ブロックサイズ                           */
+    uint32_t max_num_threads;       /* 最大エンコードスレッド数（0は1として扱う）   */
+    uint32_t max_search_cache_size; /* スレッドあたりの先読み探索キャッシュサイズ[byte]（0で無効） */
+    uint32_t max_block_cache_size;  /* スレッドあたりのブロックキャッシュサイズ[byte]（0で無効、同一内容のブロックの探索結果を再利用） */
 };
 
 /* エンコードパラメータ */
@@ -52,8 +76,59 @@ struct MOIEncodeParameter {
     uint32_t sampling_rate;         /* サンプリングレート                           */
     uint16_t bits_per_sample;       /* サンプルあたりビット数（今の所4で固定）      */
     uint16_t block_size;            /* ブロックサイズ[byte]                         */
+    MOISearchMethod search_method;  /* 符号探索手法                                 */
     uint32_t search_beam_width;     /* 探索ビーム幅                                 */
     uint32_t search_depth;          /* 探索深さ                                     */
+    uint8_t search_use_lower_bound; /* 残りコストの下限による枝刈りを行うか（結果は変わらない） */
+    uint8_t search_adaptive;        /* ブロック毎に探索ビーム幅・深さを適応的に選ぶか */
+    uint32_t min_search_beam_width; /* 適応・時間予算指定時の最小探索ビーム幅（最大はsearch_beam_width） */
+    uint32_t min_search_depth;      /* 適応・時間予算指定時の最小探索深さ（最大はsearch_depth） */
+    uint32_t time_budget;           /* 音声1秒あたりのエンコード時間の予算[ms]（0で無制限、スレッド毎に管理） */
+    uint32_t refine_percent;        /* 2パス符号化: IMA-ADPCMでの誤差が大きい方から探索するブロックの割合[%]（残りはIMA-ADPCMのまま） */
+    uint32_t refine_threshold;      /* 2パス符号化: IMA-ADPCMでの平均二乗誤差がこれを越えるブロックも探索する（0で無効） */
+    uint32_t init_search_window;    /* 初期ステップサイズインデックスを直前ブロック末尾のインデックスの前後この範囲だけ探索する（0で全探索） */
+    uint32_t local_search_sweeps;   /* 探索後の符号列を1符号ずつ変えて改善する局所探索の最大反復回数（0で無効、時間予算とは併用不可） */
+    uint32_t portfolio_size;        /* ポートフォリオ符号化: ブロック毎に試す探索設定の数（0で無効、ビームサーチのみ） */
+    uint32_t portfolio_beam_width[MOI_MAX_PORTFOLIO_SIZE]; /* ポートフォリオ符号化: 各設定の探索ビーム幅（search_beam_widthの代わりに使う） */
+    uint32_t portfolio_depth[MOI_MAX_PORTFOLIO_SIZE]; /* ポートフォリオ符号化: 各設定の探索深さ（search_depthの代わりに使う） */
+    uint32_t trellis_num_states;    /* トレリス探索で保持する状態数                 */
+    uint32_t num_threads;           /* エンコードスレッド数（0は1として扱う）       */
+};
+
+/* エンコード統計情報 */
+struct MOIEncodeStatistics {
+    uint64_t search_num_nodes;      /* 先読み探索で展開したノード数                 */
+    uint64_t search_num_bound_prunes; /* 残りコストの下限により枝刈りした回数       */
+    uint64_t search_cache_hits;     /* 先読み探索キャッシュで探索を省略した回数     */
+    uint64_t search_cache_misses;   /* 先読み探索キャッシュに無く探索した回数       */
+    uint64_t search_num_skipped_expansions; /* 親の先読みスコアが上位の閾値を超え、探索を省略した展開先の数 */
+    uint64_t search_num_selected_candidates; /* ビーム探索で上位選択した候補の延べ数 */
+    uint64_t search_num_reference_prunes; /* 上位選択した候補のうち、スコアがIMA-ADPCMの候補の合計コストを越えて除いた数 */
+    uint64_t num_searched_blocks;   /* ビーム探索したブロック数（チャンネル毎に数える） */
+    uint64_t total_search_beam_width; /* 各ブロックで使った探索ビーム幅の合計       */
+    uint64_t total_search_depth;    /* 各ブロックで使った探索深さの合計             */
+    uint64_t num_deadline_fallbacks; /* 時間切れでIMA-ADPCMの符号化に切り替えたブロック数 */
+    uint64_t num_forced_trace_commits; /* 候補の祖先が一致する前に符号選択記録の窓が溢れ、最良候補で確定した回数 */
+    uint64_t num_constant_blocks;   /* 探索せずに符号化した定数ブロック数（チャンネル毎に数える） */
+    uint64_t num_constant_run_samples; /* ブロック内の定数区間で探索を省略したサンプル数 */
+    uint64_t init_search_num_evaluations; /* 初期ステップサイズインデックスの選択でスコアを計算した回数 */
+    uint64_t block_cache_hits;      /* ブロックキャッシュで探索を省略したブロック数   */
+    uint64_t block_cache_misses;    /* ブロックキャッシュに無く探索したブロック数     */
+    uint64_t num_refined_blocks;    /* 2パス符号化で探索したブロック数                */
+    uint64_t reference_total_cost;  /* 2パス符号化: 全ブロックをIMA-ADPCMで符号化した場合の2乗誤差の合計 */
+    uint64_t reference_num_samples; /* 2パス符号化: 2乗誤差を集計したサンプル数（チャンネル毎に数える） */
+    uint64_t refined_reference_cost; /* 2パス符号化: 探索したブロックをIMA-ADPCMで符号化した場合の2乗誤差の合計 */
+    uint64_t refined_cost;          /* 2パス符号化: 探索したブロックの探索後の2乗誤差の合計 */
+    uint64_t refine_time;           /* 2パス符号化: 探索に要した時間の合計[us]（全スレッドの合計） */
+    uint64_t local_search_num_sweeps; /* 局所探索: 符号列全体を走査した回数         */
+    uint64_t local_search_num_improvements; /* 局所探索: 符号を変更したサンプル数   */
+    uint64_t local_search_num_samples; /* 局所探索: 2乗誤差を集計したサンプル数（チャンネル毎に数える） */
+    uint64_t local_search_initial_cost; /* 局所探索: 局所探索前の2乗誤差の合計      */
+    uint64_t local_search_final_cost; /* 局所探索: 局所探索後の2乗誤差の合計        */
+    uint64_t local_search_time;     /* 局所探索: 所要時間の合計[us]（全スレッドの合計） */
+    uint64_t portfolio_num_runs;    /* ポートフォリオ符号化: 探索を実行した回数     */
+    uint64_t portfolio_num_aborts;  /* ポートフォリオ符号化: 部分コストが既存の最良を越えて打ち切った回数 */
+    uint64_t portfolio_num_wins[MOI_MAX_PORTFOLIO_SIZE]; /* ポートフォリオ符号化: 各設定が最良だったブロック数（チャンネル毎に数える） */
 };
 
 /* デコーダハンドル */
@@ -116,12 +191,19 @@ MOIApiResult MOIEncoder_EncodeBlock(
         const int16_t *const *input, uint32_t num_samples,
         uint8_t *data, uint32_t data_size, uint32_t *output_size);
 
-/* ヘッダ含めファイル全体をエンコード */
+/* ヘッダ含めファイル全体をエンコード
+ * num_threads > 1 の場合はブロック単位で並列にエンコードする（出力は逐次処理と一致）
+ * refine_percent/refine_thresholdを指定した場合は、全体をIMA-ADPCMで符号化した誤差から探索するブロックを選ぶ */
 MOIApiResult MOIEncoder_EncodeWhole(
         struct MOIEncoder *encoder,
         const int16_t *const *input, uint32_t num_samples,
         uint8_t *data, uint32_t data_size, uint32_t *output_size);
 
+/* エンコード統計情報の取得（全スレッドの合計）
+ * 統計情報はエンコードパラメータの設定時にリセットされる */
+MOIApiResult MOIEncoder_GetEncodeStatistics(
+        const struct MOIEncoder *encoder, struct MOIEncodeStatistics *statistics);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
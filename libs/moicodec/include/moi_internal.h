@@ -4,6 +4,19 @@
 /* アラインメント */
 #define MOI_ALIGNMENT 16
 
+/* 静的データのアラインメント指定 */
+#if defined(_MSC_VER)
+#define MOI_ALIGNED(n) __declspec(align(n))
+#elif defined(__GNUC__)
+#define MOI_ALIGNED(n) __attribute__((aligned(n)))
+#else
+#define MOI_ALIGNED(n)
+#endif
+
+/* 量子化した差分の取得: 符号ビットから算術的に符号を付ける（-x == (x ^ -1) + 1） */
+#define MOI_QUANTIZED_DIFF(index, nibble) \
+    (((int32_t)MOI_qdiff_magnitude_table[(index)][(nibble) & 7] ^ -(int32_t)((nibble) >> 3)) + (int32_t)((nibble) >> 3))
+
 /* ステップサイズテーブルサイズ */
 #define MOI_IMAADPCM_STEPSIZE_TABLE_SIZE (sizeof(IMAADPCM_stepsize_table) / sizeof(IMAADPCM_stepsize_table[0]))
 
@@ -63,100 +76,391 @@ static const int16_t IMAADPCM_stepsize_table[89] = {
     32767
 };
 
-/* 量子化誤差計算済みテーブル */
-static const int32_t MOI_qdiff_table[89][16] = {
-    {0,2,4,6,7,9,11,13,0,-2,-4,-6,-7,-9,-11,-13},
-    {1,3,5,7,9,11,13,15,-1,-3,-5,-7,-9,-11,-13,-15},
-    {1,3,5,7,10,12,14,16,-1,-3,-5,-7,-10,-12,-14,-16},
-    {1,3,6,8,11,13,16,18,-1,-3,-6,-8,-11,-13,-16,-18},
-    {1,4,6,9,12,15,17,20,-1,-4,-6,-9,-12,-15,-17,-20},
-    {1,4,7,10,13,16,19,22,-1,-4,-7,-10,-13,-16,-19,-22},
-    {1,4,8,11,14,17,21,24,-1,-4,-8,-11,-14,-17,-21,-24},
-    {1,5,8,12,15,19,22,26,-1,-5,-8,-12,-15,-19,-22,-26},
-    {2,6,10,14,18,22,26,30,-2,-6,-10,-14,-18,-22,-26,-30},
-    {2,6,10,14,19,23,27,31,-2,-6,-10,-14,-19,-23,-27,-31},
-    {2,7,11,16,21,26,30,35,-2,-7,-11,-16,-21,-26,-30,-35},
-    {2,7,13,18,23,28,34,39,-2,-7,-13,-18,-23,-28,-34,-39},
-    {2,8,14,20,25,31,37,43,-2,-8,-14,-20,-25,-31,-37,-43},
-    {3,9,15,21,28,34,40,46,-3,-9,-15,-21,-28,-34,-40,-46},
-    {3,10,17,24,31,38,45,52,-3,-10,-17,-24,-31,-38,-45,-52},
-    {3,11,19,27,34,42,50,58,-3,-11,-19,-27,-34,-42,-50,-58},
-    {4,12,21,29,38,46,55,63,-4,-12,-21,-29,-38,-46,-55,-63},
-    {4,13,23,32,41,50,60,69,-4,-13,-23,-32,-41,-50,-60,-69},
-    {5,15,25,35,46,56,66,76,-5,-15,-25,-35,-46,-56,-66,-76},
-    {5,16,28,39,50,61,73,84,-5,-16,-28,-39,-50,-61,-73,-84},
-    {6,18,31,43,56,68,81,93,-6,-18,-31,-43,-56,-68,-81,-93},
-    {6,20,34,48,61,75,89,103,-6,-20,-34,-48,-61,-75,-89,-103},
-    {7,22,37,52,67,82,97,112,-7,-22,-37,-52,-67,-82,-97,-112},
-    {8,24,41,57,74,90,107,123,-8,-24,-41,-57,-74,-90,-107,-123},
-    {9,27,45,63,82,100,118,136,-9,-27,-45,-63,-82,-100,-118,-136},
-    {10,30,50,70,90,110,130,150,-10,-30,-50,-70,-90,-110,-130,-150},
-    {11,33,55,77,99,121,143,165,-11,-33,-55,-77,-99,-121,-143,-165},
-    {12,36,60,84,109,133,157,181,-12,-36,-60,-84,-109,-133,-157,-181},
-    {13,40,66,93,120,147,173,200,-13,-40,-66,-93,-120,-147,-173,-200},
-    {14,44,73,103,132,162,191,221,-14,-44,-73,-103,-132,-162,-191,-221},
-    {16,48,81,113,146,178,211,243,-16,-48,-81,-113,-146,-178,-211,-243},
-    {17,53,89,125,160,196,232,268,-17,-53,-89,-125,-160,-196,-232,-268},
-    {19,58,98,137,176,215,255,294,-19,-58,-98,-137,-176,-215,-255,-294},
-    {21,64,108,151,194,237,281,324,-21,-64,-108,-151,-194,-237,-281,-324},
-    {23,71,118,166,213,261,308,356,-23,-71,-118,-166,-213,-261,-308,-356},
-    {26,78,130,182,235,287,339,391,-26,-78,-130,-182,-235,-287,-339,-391},
-    {28,86,143,201,258,316,373,431,-28,-86,-143,-201,-258,-316,-373,-431},
-    {31,94,158,221,284,347,411,474,-31,-94,-158,-221,-284,-347,-411,-474},
-    {34,104,174,244,313,383,453,523,-34,-104,-174,-244,-313,-383,-453,-523},
-    {38,115,191,268,345,422,498,575,-38,-115,-191,-268,-345,-422,-498,-575},
-    {42,126,210,294,379,463,547,631,-42,-126,-210,-294,-379,-463,-547,-631},
-    {46,139,231,324,417,510,602,695,-46,-139,-231,-324,-417,-510,-602,-695},
-    {51,153,255,357,459,561,663,765,-51,-153,-255,-357,-459,-561,-663,-765},
-    {56,168,280,392,505,617,729,841,-56,-168,-280,-392,-505,-617,-729,-841},
-    {61,185,308,432,555,679,802,926,-61,-185,-308,-432,-555,-679,-802,-926},
-    {68,204,340,476,612,748,884,1020,-68,-204,-340,-476,-612,-748,-884,-1020},
-    {74,224,373,523,672,822,971,1121,-74,-224,-373,-523,-672,-822,-971,-1121},
-    {82,246,411,575,740,904,1069,1233,-82,-246,-411,-575,-740,-904,-1069,-1233},
-    {90,271,452,633,814,995,1176,1357,-90,-271,-452,-633,-814,-995,-1176,-1357},
-    {99,298,497,696,895,1094,1293,1492,-99,-298,-497,-696,-895,-1094,-1293,-1492},
-    {109,328,547,766,985,1204,1423,1642,-109,-328,-547,-766,-985,-1204,-1423,-1642},
-    {120,361,601,842,1083,1324,1564,1805,-120,-361,-601,-842,-1083,-1324,-1564,-1805},
-    {132,397,662,927,1192,1457,1722,1987,-132,-397,-662,-927,-1192,-1457,-1722,-1987},
-    {145,437,728,1020,1311,1603,1894,2186,-145,-437,-728,-1020,-1311,-1603,-1894,-2186},
-    {160,480,801,1121,1442,1762,2083,2403,-160,-480,-801,-1121,-1442,-1762,-2083,-2403},
-    {176,529,881,1234,1587,1940,2292,2645,-176,-529,-881,-1234,-1587,-1940,-2292,-2645},
-    {194,582,970,1358,1746,2134,2522,2910,-194,-582,-970,-1358,-1746,-2134,-2522,-2910},
-    {213,640,1066,1493,1920,2347,2773,3200,-213,-640,-1066,-1493,-1920,-2347,-2773,-3200},
-    {234,704,1173,1643,2112,2582,3051,3521,-234,-704,-1173,-1643,-2112,-2582,-3051,-3521},
-    {258,774,1291,1807,2324,2840,3357,3873,-258,-774,-1291,-1807,-2324,-2840,-3357,-3873},
-    {284,852,1420,1988,2556,3124,3692,4260,-284,-852,-1420,-1988,-2556,-3124,-3692,-4260},
-    {312,937,1561,2186,2811,3436,4060,4685,-312,-937,-1561,-2186,-2811,-3436,-4060,-4685},
-    {343,1030,1718,2405,3092,3779,4467,5154,-343,-1030,-1718,-2405,-3092,-3779,-4467,-5154},
-    {378,1134,1890,2646,3402,4158,4914,5670,-378,-1134,-1890,-2646,-3402,-4158,-4914,-5670},
-    {415,1247,2079,2911,3742,4574,5406,6238,-415,-1247,-2079,-2911,-3742,-4574,-5406,-6238},
-    {457,1372,2287,3202,4117,5032,5947,6862,-457,-1372,-2287,-3202,-4117,-5032,-5947,-6862},
-    {503,1509,2516,3522,4529,5535,6542,7548,-503,-1509,-2516,-3522,-4529,-5535,-6542,-7548},
-    {553,1660,2767,3874,4981,6088,7195,8302,-553,-1660,-2767,-3874,-4981,-6088,-7195,-8302},
-    {608,1826,3044,4262,5479,6697,7915,9133,-608,-1826,-3044,-4262,-5479,-6697,-7915,-9133},
-    {669,2009,3348,4688,6027,7367,8706,10046,-669,-2009,-3348,-4688,-6027,-7367,-8706,-10046},
-    {736,2210,3683,5157,6630,8104,9577,11051,-736,-2210,-3683,-5157,-6630,-8104,-9577,-11051},
-    {810,2431,4052,5673,7294,8915,10536,12157,-810,-2431,-4052,-5673,-7294,-8915,-10536,-12157},
-    {891,2674,4457,6240,8023,9806,11589,13372,-891,-2674,-4457,-6240,-8023,-9806,-11589,-13372},
-    {980,2941,4903,6864,8825,10786,12748,14709,-980,-2941,-4903,-6864,-8825,-10786,-12748,-14709},
-    {1078,3236,5393,7551,9708,11866,14023,16181,-1078,-3236,-5393,-7551,-9708,-11866,-14023,-16181},
-    {1186,3559,5933,8306,10679,13052,15426,17799,-1186,-3559,-5933,-8306,-10679,-13052,-15426,-17799},
-    {1305,3915,6526,9136,11747,14357,16968,19578,-1305,-3915,-6526,-9136,-11747,-14357,-16968,-19578},
-    {1435,4307,7179,10051,12922,15794,18666,21538,-1435,-4307,-7179,-10051,-12922,-15794,-18666,-21538},
-    {1579,4738,7896,11055,14214,17373,20531,23690,-1579,-4738,-7896,-11055,-14214,-17373,-20531,-23690},
-    {1737,5212,8686,12161,15636,19111,22585,26060,-1737,-5212,-8686,-12161,-15636,-19111,-22585,-26060},
-    {1911,5733,9555,13377,17200,21022,24844,28666,-1911,-5733,-9555,-13377,-17200,-21022,-24844,-28666},
-    {2102,6306,10511,14715,18920,23124,27329,31533,-2102,-6306,-10511,-14715,-18920,-23124,-27329,-31533},
-    {2312,6937,11562,16187,20812,25437,30062,34687,-2312,-6937,-11562,-16187,-20812,-25437,-30062,-34687},
-    {2543,7631,12718,17806,22893,27981,33068,38156,-2543,-7631,-12718,-17806,-22893,-27981,-33068,-38156},
-    {2798,8394,13990,19586,25183,30779,36375,41971,-2798,-8394,-13990,-19586,-25183,-30779,-36375,-41971},
-    {3077,9233,15389,21545,27700,33856,40012,46168,-3077,-9233,-15389,-21545,-27700,-33856,-40012,-46168},
-    {3385,10157,16928,23700,30471,37243,44014,50786,-3385,-10157,-16928,-23700,-30471,-37243,-44014,-50786},
-    {3724,11172,18621,26069,33518,40966,48415,55863,-3724,-11172,-18621,-26069,-33518,-40966,-48415,-55863},
-    {4095,12287,20479,28671,36862,45054,53246,61438,-4095,-12287,-20479,-28671,-36862,-45054,-53246,-61438},
+/* 量子化誤差の絶対値テーブル: [ステップサイズインデックス][符号の絶対値]
+* 負の符号の差分は絶対値の符号反転なので持たない。1行16byteでベクトル1回のロードに収まるよう整列 */
+MOI_ALIGNED(MOI_ALIGNMENT) static const uint16_t MOI_qdiff_magnitude_table[89][8] = {
+    {0,2,4,6,7,9,11,13},
+    {1,3,5,7,9,11,13,15},
+    {1,3,5,7,10,12,14,16},
+    {1,3,6,8,11,13,16,18},
+    {1,4,6,9,12,15,17,20},
+    {1,4,7,10,13,16,19,22},
+    {1,4,8,11,14,17,21,24},
+    {1,5,8,12,15,19,22,26},
+    {2,6,10,14,18,22,26,30},
+    {2,6,10,14,19,23,27,31},
+    {2,7,11,16,21,26,30,35},
+    {2,7,13,18,23,28,34,39},
+    {2,8,14,20,25,31,37,43},
+    {3,9,15,21,28,34,40,46},
+    {3,10,17,24,31,38,45,52},
+    {3,11,19,27,34,42,50,58},
+    {4,12,21,29,38,46,55,63},
+    {4,13,23,32,41,50,60,69},
+    {5,15,25,35,46,56,66,76},
+    {5,16,28,39,50,61,73,84},
+    {6,18,31,43,56,68,81,93},
+    {6,20,34,48,61,75,89,103},
+    {7,22,37,52,67,82,97,112},
+    {8,24,41,57,74,90,107,123},
+    {9,27,45,63,82,100,118,136},
+    {10,30,50,70,90,110,130,150},
+    {11,33,55,77,99,121,143,165},
+    {12,36,60,84,109,133,157,181},
+    {13,40,66,93,120,147,173,200},
+    {14,44,73,103,132,162,191,221},
+    {16,48,81,113,146,178,211,243},
+    {17,53,89,125,160,196,232,268},
+    {19,58,98,137,176,215,255,294},
+    {21,64,108,151,194,237,281,324},
+    {23,71,118,166,213,261,308,356},
+    {26,78,130,182,235,287,339,391},
+    {28,86,143,201,258,316,373,431},
+    {31,94,158,221,284,347,411,474},
+    {34,104,174,244,313,383,453,523},
+    {38,115,191,268,345,422,498,575},
+    {42,126,210,294,379,463,547,631},
+    {46,139,231,324,417,510,602,695},
+    {51,153,255,357,459,561,663,765},
+    {56,168,280,392,505,617,729,841},
+    {61,185,308,432,555,679,802,926},
+    {68,204,340,476,612,748,884,1020},
+    {74,224,373,523,672,822,971,1121},
+    {82,246,411,575,740,904,1069,1233},
+    {90,271,452,633,814,995,1176,1357},
+    {99,298,497,696,895,1094,1293,1492},
+    {109,328,547,766,985,1204,1423,1642},
+    {120,361,601,842,1083,1324,1564,1805},
+    {132,397,662,927,1192,1457,1722,1987},
+    {145,437,728,1020,1311,1603,1894,2186},
+    {160,480,801,1121,1442,1762,2083,2403},
+    {176,529,881,1234,1587,1940,2292,2645},
+    {194,582,970,1358,1746,2134,2522,2910},
+    {213,640,1066,1493,1920,2347,2773,3200},
+    {234,704,1173,1643,2112,2582,3051,3521},
+    {258,774,1291,1807,2324,2840,3357,3873},
+    {284,852,1420,1988,2556,3124,3692,4260},
+    {312,937,1561,2186,2811,3436,4060,4685},
+    {343,1030,1718,2405,3092,3779,4467,5154},
+    {378,1134,1890,2646,3402,4158,4914,5670},
+    {415,1247,2079,2911,3742,4574,5406,6238},
+    {457,1372,2287,3202,4117,5032,5947,6862},
+    {503,1509,2516,3522,4529,5535,6542,7548},
+    {553,1660,2767,3874,4981,6088,7195,8302},
+    {608,1826,3044,4262,5479,6697,7915,9133},
+    {669,2009,3348,4688,6027,7367,8706,10046},
+    {736,2210,3683,5157,6630,8104,9577,11051},
+    {810,2431,4052,5673,7294,8915,10536,12157},
+    {891,2674,4457,6240,8023,9806,11589,13372},
+    {980,2941,4903,6864,8825,10786,12748,14709},
+    {1078,3236,5393,7551,9708,11866,14023,16181},
+    {1186,3559,5933,8306,10679,13052,15426,17799},
+    {1305,3915,6526,9136,11747,14357,16968,19578},
+    {1435,4307,7179,10051,12922,15794,18666,21538},
+    {1579,4738,7896,11055,14214,17373,20531,23690},
+    {1737,5212,8686,12161,15636,19111,22585,26060},
+    {1911,5733,9555,13377,17200,21022,24844,28666},
+    {2102,6306,10511,14715,18920,23124,27329,31533},
+    {2312,6937,11562,16187,20812,25437,30062,34687},
+    {2543,7631,12718,17806,22893,27981,33068,38156},
+    {2798,8394,13990,19586,25183,30779,36375,41971},
+    {3077,9233,15389,21545,27700,33856,40012,46168},
+    {3385,10157,16928,23700,30471,37243,44014,50786},
+    {3724,11172,18621,26069,33518,40966,48415,55863},
+    {4095,12287,20479,28671,36862,45054,53246,61438},
 };
 
 
+/* 次状態テーブルの量子化した差分のバイアス（要素を非負にして、負数の右シフトを避ける） */
+#define MOI_NEXT_STATE_QDIFF_BIAS 65536
+
+/* 次状態テーブルの要素の作成: 上位ビットにバイアスを加えた量子化した差分、下位8bitにクリップ済みの次のインデックス */
+#define MOI_NEXT_STATE(qdiff, index) (((int32_t)(qdiff) + MOI_NEXT_STATE_QDIFF_BIAS) * 256 + (index))
+
+/* 次状態テーブルの要素から符号付きの量子化した差分を取得 */
+#define MOI_NEXT_STATE_QDIFF(entry) (((entry) >> 8) - MOI_NEXT_STATE_QDIFF_BIAS)
+
+/* 次状態テーブルの要素から次のインデックスを取得 */
+#define MOI_NEXT_STATE_INDEX(entry) ((int8_t)((entry) & 0xFF))
+
+/* 次状態テーブル: [ステップサイズインデックス][符号]
+* 1回の参照で量子化した差分とクリップ済みの次のインデックスが得られる */
+static const int32_t MOI_next_state_table[89][16] = {
+    {MOI_NEXT_STATE(0,0),MOI_NEXT_STATE(2,0),MOI_NEXT_STATE(4,0),MOI_NEXT_STATE(6,0),MOI_NEXT_STATE(7,2),MOI_NEXT_STATE(9,4),MOI_NEXT_STATE(11,6),MOI_NEXT_STATE(13,8),
+     MOI_NEXT_STATE(0,0),MOI_NEXT_STATE(-2,0),MOI_NEXT_STATE(-4,0),MOI_NEXT_STATE(-6,0),MOI_NEXT_STATE(-7,2),MOI_NEXT_STATE(-9,4),MOI_NEXT_STATE(-11,6),MOI_NEXT_STATE(-13,8)},
+    {MOI_NEXT_STATE(1,0),MOI_NEXT_STATE(3,0),MOI_NEXT_STATE(5,0),MOI_NEXT_STATE(7,0),MOI_NEXT_STATE(9,3),MOI_NEXT_STATE(11,5),MOI_NEXT_STATE(13,7),MOI_NEXT_STATE(15,9),
+     MOI_NEXT_STATE(-1,0),MOI_NEXT_STATE(-3,0),MOI_NEXT_STATE(-5,0),MOI_NEXT_STATE(-7,0),MOI_NEXT_STATE(-9,3),MOI_NEXT_STATE(-11,5),MOI_NEXT_STATE(-13,7),MOI_NEXT_STATE(-15,9)},
+    {MOI_NEXT_STATE(1,1),MOI_NEXT_STATE(3,1),MOI_NEXT_STATE(5,1),MOI_NEXT_STATE(7,1),MOI_NEXT_STATE(10,4),MOI_NEXT_STATE(12,6),MOI_NEXT_STATE(14,8),MOI_NEXT_STATE(16,10),
+     MOI_NEXT_STATE(-1,1),MOI_NEXT_STATE(-3,1),MOI_NEXT_STATE(-5,1),MOI_NEXT_STATE(-7,1),MOI_NEXT_STATE(-10,4),MOI_NEXT_STATE(-12,6),MOI_NEXT_STATE(-14,8),MOI_NEXT_STATE(-16,10)},
+    {MOI_NEXT_STATE(1,2),MOI_NEXT_STATE(3,2),MOI_NEXT_STATE(6,2),MOI_NEXT_STATE(8,2),MOI_NEXT_STATE(11,5),MOI_NEXT_STATE(13,7),MOI_NEXT_STATE(16,9),MOI_NEXT_STATE(18,11),
+     MOI_NEXT_STATE(-1,2),MOI_NEXT_STATE(-3,2),MOI_NEXT_STATE(-6,2),MOI_NEXT_STATE(-8,2),MOI_NEXT_STATE(-11,5),MOI_NEXT_STATE(-13,7),MOI_NEXT_STATE(-16,9),MOI_NEXT_STATE(-18,11)},
+    {MOI_NEXT_STATE(1,3),MOI_NEXT_STATE(4,3),MOI_NEXT_STATE(6,3),MOI_NEXT_STATE(9,3),MOI_NEXT_STATE(12,6),MOI_NEXT_STATE(15,8),MOI_NEXT_STATE(17,10),MOI_NEXT_STATE(20,12),
+     MOI_NEXT_STATE(-1,3),MOI_NEXT_STATE(-4,3),MOI_NEXT_STATE(-6,3),MOI_NEXT_STATE(-9,3),MOI_NEXT_STATE(-12,6),MOI_NEXT_STATE(-15,8),MOI_NEXT_STATE(-17,10),MOI_NEXT_STATE(-20,12)},
+    {MOI_NEXT_STATE(1,4),MOI_NEXT_STATE(4,4),MOI_NEXT_STATE(7,4),MOI_NEXT_STATE(10,4),MOI_NEXT_STATE(13,7),MOI_NEXT_STATE(16,9),MOI_NEXT_STATE(19,11),MOI_NEXT_STATE(22,13),
+     MOI_NEXT_STATE(-1,4),MOI_NEXT_STATE(-4,4),MOI_NEXT_STATE(-7,4),MOI_NEXT_STATE(-10,4),MOI_NEXT_STATE(-13,7),MOI_NEXT_STATE(-16,9),MOI_NEXT_STATE(-19,11),MOI_NEXT_STATE(-22,13)},
+    {MOI_NEXT_STATE(1,5),MOI_NEXT_STATE(4,5),MOI_NEXT_STATE(8,5),MOI_NEXT_STATE(11,5),MOI_NEXT_STATE(14,8),MOI_NEXT_STATE(17,10),MOI_NEXT_STATE(21,12),MOI_NEXT_STATE(24,14),
+     MOI_NEXT_STATE(-1,5),MOI_NEXT_STATE(-4,5),MOI_NEXT_STATE(-8,5),MOI_NEXT_STATE(-11,5),MOI_NEXT_STATE(-14,8),MOI_NEXT_STATE(-17,10),MOI_NEXT_STATE(-21,12),MOI_NEXT_STATE(-24,14)},
+    {MOI_NEXT_STATE(1,6),MOI_NEXT_STATE(5,6),MOI_NEXT_STATE(8,6),MOI_NEXT_STATE(12,6),MOI_NEXT_STATE(15,9),MOI_NEXT_STATE(19,11),MOI_NEXT_STATE(22,13),MOI_NEXT_STATE(26,15),
+     MOI_NEXT_STATE(-1,6),MOI_NEXT_STATE(-5,6),MOI_NEXT_STATE(-8,6),MOI_NEXT_STATE(-12,6),MOI_NEXT_STATE(-15,9),MOI_NEXT_STATE(-19,11),MOI_NEXT_STATE(-22,13),MOI_NEXT_STATE(-26,15)},
+    {MOI_NEXT_STATE(2,7),MOI_NEXT_STATE(6,7),MOI_NEXT_STATE(10,7),MOI_NEXT_STATE(14,7),MOI_NEXT_STATE(18,10),MOI_NEXT_STATE(22,12),MOI_NEXT_STATE(26,14),MOI_NEXT_STATE(30,16),
+     MOI_NEXT_STATE(-2,7),MOI_NEXT_STATE(-6,7),MOI_NEXT_STATE(-10,7),MOI_NEXT_STATE(-14,7),MOI_NEXT_STATE(-18,10),MOI_NEXT_STATE(-22,12),MOI_NEXT_STATE(-26,14),MOI_NEXT_STATE(-30,16)},
+    {MOI_NEXT_STATE(2,8),MOI_NEXT_STATE(6,8),MOI_NEXT_STATE(10,8),MOI_NEXT_STATE(14,8),MOI_NEXT_STATE(19,11),MOI_NEXT_STATE(23,13),MOI_NEXT_STATE(27,15),MOI_NEXT_STATE(31,17),
+     MOI_NEXT_STATE(-2,8),MOI_NEXT_STATE(-6,8),MOI_NEXT_STATE(-10,8),MOI_NEXT_STATE(-14,8),MOI_NEXT_STATE(-19,11),MOI_NEXT_STATE(-23,13),MOI_NEXT_STATE(-27,15),MOI_NEXT_STATE(-31,17)},
+    {MOI_NEXT_STATE(2,9),MOI_NEXT_STATE(7,9),MOI_NEXT_STATE(11,9),MOI_NEXT_STATE(16,9),MOI_NEXT_STATE(21,12),MOI_NEXT_STATE(26,14),MOI_NEXT_STATE(30,16),MOI_NEXT_STATE(35,18),
+     MOI_NEXT_STATE(-2,9),MOI_NEXT_STATE(-7,9),MOI_NEXT_STATE(-11,9),MOI_NEXT_STATE(-16,9),MOI_NEXT_STATE(-21,12),MOI_NEXT_STATE(-26,14),MOI_NEXT_STATE(-30,16),MOI_NEXT_STATE(-35,18)},
+    {MOI_NEXT_STATE(2,10),MOI_NEXT_STATE(7,10),MOI_NEXT_STATE(13,10),MOI_NEXT_STATE(18,10),MOI_NEXT_STATE(23,13),MOI_NEXT_STATE(28,15),MOI_NEXT_STATE(34,17),MOI_NEXT_STATE(39,19),
+     MOI_NEXT_STATE(-2,10),MOI_NEXT_STATE(-7,10),MOI_NEXT_STATE(-13,10),MOI_NEXT_STATE(-18,10),MOI_NEXT_STATE(-23,13),MOI_NEXT_STATE(-28,15),MOI_NEXT_STATE(-34,17),MOI_NEXT_STATE(-39,19)},
+    {MOI_NEXT_STATE(2,11),MOI_NEXT_STATE(8,11),MOI_NEXT_STATE(14,11),MOI_NEXT_STATE(20,11),MOI_NEXT_STATE(25,14),MOI_NEXT_STATE(31,16),MOI_NEXT_STATE(37,18),MOI_NEXT_STATE(43,20),
+     MOI_NEXT_STATE(-2,11),MOI_NEXT_STATE(-8,11),MOI_NEXT_STATE(-14,11),MOI_NEXT_STATE(-20,11),MOI_NEXT_STATE(-25,14),MOI_NEXT_STATE(-31,16),MOI_NEXT_STATE(-37,18),MOI_NEXT_STATE(-43,20)},
+    {MOI_NEXT_STATE(3,12),MOI_NEXT_STATE(9,12),MOI_NEXT_STATE(15,12),MOI_NEXT_STATE(21,12),MOI_NEXT_STATE(28,15),MOI_NEXT_STATE(34,17),MOI_NEXT_STATE(40,19),MOI_NEXT_STATE(46,21),
+     MOI_NEXT_STATE(-3,12),MOI_NEXT_STATE(-9,12),MOI_NEXT_STATE(-15,12),MOI_NEXT_STATE(-21,12),MOI_NEXT_STATE(-28,15),MOI_NEXT_STATE(-34,17),MOI_NEXT_STATE(-40,19),MOI_NEXT_STATE(-46,21)},
+    {MOI_NEXT_STATE(3,13),MOI_NEXT_STATE(10,13),MOI_NEXT_STATE(17,13),MOI_NEXT_STATE(24,13),MOI_NEXT_STATE(31,16),MOI_NEXT_STATE(38,18),MOI_NEXT_STATE(45,20),MOI_NEXT_STATE(52,22),
+     MOI_NEXT_STATE(-3,13),MOI_NEXT_STATE(-10,13),MOI_NEXT_STATE(-17,13),MOI_NEXT_STATE(-24,13),MOI_NEXT_STATE(-31,16),MOI_NEXT_STATE(-38,18),MOI_NEXT_STATE(-45,20),MOI_NEXT_STATE(-52,22)},
+    {MOI_NEXT_STATE(3,14),MOI_NEXT_STATE(11,14),MOI_NEXT_STATE(19,14),MOI_NEXT_STATE(27,14),MOI_NEXT_STATE(34,17),MOI_NEXT_STATE(42,19),MOI_NEXT_STATE(50,21),MOI_NEXT_STATE(58,23),
+     MOI_NEXT_STATE(-3,14),MOI_NEXT_STATE(-11,14),MOI_NEXT_STATE(-19,14),MOI_NEXT_STATE(-27,14),MOI_NEXT_STATE(-34,17),MOI_NEXT_STATE(-42,19),MOI_NEXT_STATE(-50,21),MOI_NEXT_STATE(-58,23)},
+    {MOI_NEXT_STATE(4,15),MOI_NEXT_STATE(12,15),MOI_NEXT_STATE(21,15),MOI_NEXT_STATE(29,15),MOI_NEXT_STATE(38,18),MOI_NEXT_STATE(46,20),MOI_NEXT_STATE(55,22),MOI_NEXT_STATE(63,24),
+     MOI_NEXT_STATE(-4,15),MOI_NEXT_STATE(-12,15),MOI_NEXT_STATE(-21,15),MOI_NEXT_STATE(-29,15),MOI_NEXT_STATE(-38,18),MOI_NEXT_STATE(-46,20),MOI_NEXT_STATE(-55,22),MOI_NEXT_STATE(-63,24)},
+    {MOI_NEXT_STATE(4,16),MOI_NEXT_STATE(13,16),MOI_NEXT_STATE(23,16),MOI_NEXT_STATE(32,16),MOI_NEXT_STATE(41,19),MOI_NEXT_STATE(50,21),MOI_NEXT_STATE(60,23),MOI_NEXT_STATE(69,25),
+     MOI_NEXT_STATE(-4,16),MOI_NEXT_STATE(-13,16),MOI_NEXT_STATE(-23,16),MOI_NEXT_STATE(-32,16),MOI_NEXT_STATE(-41,19),MOI_NEXT_STATE(-50,21),MOI_NEXT_STATE(-60,23),MOI_NEXT_STATE(-69,25)},
+    {MOI_NEXT_STATE(5,17),MOI_NEXT_STATE(15,17),MOI_NEXT_STATE(25,17),MOI_NEXT_STATE(35,17),MOI_NEXT_STATE(46,20),MOI_NEXT_STATE(56,22),MOI_NEXT_STATE(66,24),MOI_NEXT_STATE(76,26),
+     MOI_NEXT_STATE(-5,17),MOI_NEXT_STATE(-15,17),MOI_NEXT_STATE(-25,17),MOI_NEXT_STATE(-35,17),MOI_NEXT_STATE(-46,20),MOI_NEXT_STATE(-56,22),MOI_NEXT_STATE(-66,24),MOI_NEXT_STATE(-76,26)},
+    {MOI_NEXT_STATE(5,18),MOI_NEXT_STATE(16,18),MOI_NEXT_STATE(28,18),MOI_NEXT_STATE(39,18),MOI_NEXT_STATE(50,21),MOI_NEXT_STATE(61,23),MOI_NEXT_STATE(73,25),MOI_NEXT_STATE(84,27),
+     MOI_NEXT_STATE(-5,18),MOI_NEXT_STATE(-16,18),MOI_NEXT_STATE(-28,18),MOI_NEXT_STATE(-39,18),MOI_NEXT_STATE(-50,21),MOI_NEXT_STATE(-61,23),MOI_NEXT_STATE(-73,25),MOI_NEXT_STATE(-84,27)},
+    {MOI_NEXT_STATE(6,19),MOI_NEXT_STATE(18,19),MOI_NEXT_STATE(31,19),MOI_NEXT_STATE(43,19),MOI_NEXT_STATE(56,22),MOI_NEXT_STATE(68,24),MOI_NEXT_STATE(81,26),MOI_NEXT_STATE(93,28),
+     MOI_NEXT_STATE(-6,19),MOI_NEXT_STATE(-18,19),MOI_NEXT_STATE(-31,19),MOI_NEXT_STATE(-43,19),MOI_NEXT_STATE(-56,22),MOI_NEXT_STATE(-68,24),MOI_NEXT_STATE(-81,26),MOI_NEXT_STATE(-93,28)},
+    {MOI_NEXT_STATE(6,20),MOI_NEXT_STATE(20,20),MOI_NEXT_STATE(34,20),MOI_NEXT_STATE(48,20),MOI_NEXT_STATE(61,23),MOI_NEXT_STATE(75,25),MOI_NEXT_STATE(89,27),MOI_NEXT_STATE(103,29),
+     MOI_NEXT_STATE(-6,20),MOI_NEXT_STATE(-20,20),MOI_NEXT_STATE(-34,20),MOI_NEXT_STATE(-48,20),MOI_NEXT_STATE(-61,23),MOI_NEXT_STATE(-75,25),MOI_NEXT_STATE(-89,27),MOI_NEXT_STATE(-103,29)},
+    {MOI_NEXT_STATE(7,21),MOI_NEXT_STATE(22,21),MOI_NEXT_STATE(37,21),MOI_NEXT_STATE(52,21),MOI_NEXT_STATE(67,24),MOI_NEXT_STATE(82,26),MOI_NEXT_STATE(97,28),MOI_NEXT_STATE(112,30),
+     MOI_NEXT_STATE(-7,21),MOI_NEXT_STATE(-22,21),MOI_NEXT_STATE(-37,21),MOI_NEXT_STATE(-52,21),MOI_NEXT_STATE(-67,24),MOI_NEXT_STATE(-82,26),MOI_NEXT_STATE(-97,28),MOI_NEXT_STATE(-112,30)},
+    {MOI_NEXT_STATE(8,22),MOI_NEXT_STATE(24,22),MOI_NEXT_STATE(41,22),MOI_NEXT_STATE(57,22),MOI_NEXT_STATE(74,25),MOI_NEXT_STATE(90,27),MOI_NEXT_STATE(107,29),MOI_NEXT_STATE(123,31),
+     MOI_NEXT_STATE(-8,22),MOI_NEXT_STATE(-24,22),MOI_NEXT_STATE(-41,22),MOI_NEXT_STATE(-57,22),MOI_NEXT_STATE(-74,25),MOI_NEXT_STATE(-90,27),MOI_NEXT_STATE(-107,29),MOI_NEXT_STATE(-123,31)},
+    {MOI_NEXT_STATE(9,23),MOI_NEXT_STATE(27,23),MOI_NEXT_STATE(45,23),MOI_NEXT_STATE(63,23),MOI_NEXT_STATE(82,26),MOI_NEXT_STATE(100,28),MOI_NEXT_STATE(118,30),MOI_NEXT_STATE(136,32),
+     MOI_NEXT_STATE(-9,23),MOI_NEXT_STATE(-27,23),MOI_NEXT_STATE(-45,23),MOI_NEXT_STATE(-63,23),MOI_NEXT_STATE(-82,26),MOI_NEXT_STATE(-100,28),MOI_NEXT_STATE(-118,30),MOI_NEXT_STATE(-136,32)},
+    {MOI_NEXT_STATE(10,24),MOI_NEXT_STATE(30,24),MOI_NEXT_STATE(50,24),MOI_NEXT_STATE(70,24),MOI_NEXT_STATE(90,27),MOI_NEXT_STATE(110,29),MOI_NEXT_STATE(130,31),MOI_NEXT_STATE(150,33),
+     MOI_NEXT_STATE(-10,24),MOI_NEXT_STATE(-30,24),MOI_NEXT_STATE(-50,24),MOI_NEXT_STATE(-70,24),MOI_NEXT_STATE(-90,27),MOI_NEXT_STATE(-110,29),MOI_NEXT_STATE(-130,31),MOI_NEXT_STATE(-150,33)},
+    {MOI_NEXT_STATE(11,25),MOI_NEXT_STATE(33,25),MOI_NEXT_STATE(55,25),MOI_NEXT_STATE(77,25),MOI_NEXT_STATE(99,28),MOI_NEXT_STATE(121,30),MOI_NEXT_STATE(143,32),MOI_NEXT_STATE(165,34),
+     MOI_NEXT_STATE(-11,25),MOI_NEXT_STATE(-33,25),MOI_NEXT_STATE(-55,25),MOI_NEXT_STATE(-77,25),MOI_NEXT_STATE(-99,28),MOI_NEXT_STATE(-121,30),MOI_NEXT_STATE(-143,32),MOI_NEXT_STATE(-165,34)},
+    {MOI_NEXT_STATE(12,26),MOI_NEXT_STATE(36,26),MOI_NEXT_STATE(60,26),MOI_NEXT_STATE(84,26),MOI_NEXT_STATE(109,29),MOI_NEXT_STATE(133,31),MOI_NEXT_STATE(157,33),MOI_NEXT_STATE(181,35),
+     MOI_NEXT_STATE(-12,26),MOI_NEXT_STATE(-36,26),MOI_NEXT_STATE(-60,26),MOI_NEXT_STATE(-84,26),MOI_NEXT_STATE(-109,29),MOI_NEXT_STATE(-133,31),MOI_NEXT_STATE(-157,33),MOI_NEXT_STATE(-181,35)},
+    {MOI_NEXT_STATE(13,27),MOI_NEXT_STATE(40,27),MOI_NEXT_STATE(66,27),MOI_NEXT_STATE(93,27),MOI_NEXT_STATE(120,30),MOI_NEXT_STATE(147,32),MOI_NEXT_STATE(173,34),MOI_NEXT_STATE(200,36),
+     MOI_NEXT_STATE(-13,27),MOI_NEXT_STATE(-40,27),MOI_NEXT_STATE(-66,27),MOI_NEXT_STATE(-93,27),MOI_NEXT_STATE(-120,30),MOI_NEXT_STATE(-147,32),MOI_NEXT_STATE(-173,34),MOI_NEXT_STATE(-200,36)},
+    {MOI_NEXT_STATE(14,28),MOI_NEXT_STATE(44,28),MOI_NEXT_STATE(73,28),MOI_NEXT_STATE(103,28),MOI_NEXT_STATE(132,31),MOI_NEXT_STATE(162,33),MOI_NEXT_STATE(191,35),MOI_NEXT_STATE(221,37),
+     MOI_NEXT_STATE(-14,28),MOI_NEXT_STATE(-44,28),MOI_NEXT_STATE(-73,28),MOI_NEXT_STATE(-103,28),MOI_NEXT_STATE(-132,31),MOI_NEXT_STATE(-162,33),MOI_NEXT_STATE(-191,35),MOI_NEXT_STATE(-221,37)},
+    {MOI_NEXT_STATE(16,29),MOI_NEXT_STATE(48,29),MOI_NEXT_STATE(81,29),MOI_NEXT_STATE(113,29),MOI_NEXT_STATE(146,32),MOI_NEXT_STATE(178,34),MOI_NEXT_STATE(211,36),MOI_NEXT_STATE(243,38),
+     MOI_NEXT_STATE(-16,29),MOI_NEXT_STATE(-48,29),MOI_NEXT_STATE(-81,29),MOI_NEXT_STATE(-113,29),MOI_NEXT_STATE(-146,32),MOI_NEXT_STATE(-178,34),MOI_NEXT_STATE(-211,36),MOI_NEXT_STATE(-243,38)},
+    {MOI_NEXT_STATE(17,30),MOI_NEXT_STATE(53,30),MOI_NEXT_STATE(89,30),MOI_NEXT_STATE(125,30),MOI_NEXT_STATE(160,33),MOI_NEXT_STATE(196,35),MOI_NEXT_STATE(232,37),MOI_NEXT_STATE(268,39),
+     MOI_NEXT_STATE(-17,30),MOI_NEXT_STATE(-53,30),MOI_NEXT_STATE(-89,30),MOI_NEXT_STATE(-125,30),MOI_NEXT_STATE(-160,33),MOI_NEXT_STATE(-196,35),MOI_NEXT_STATE(-232,37),MOI_NEXT_STATE(-268,39)},
+    {MOI_NEXT_STATE(19,31),MOI_NEXT_STATE(58,31),MOI_NEXT_STATE(98,31),MOI_NEXT_STATE(137,31),MOI_NEXT_STATE(176,34),MOI_NEXT_STATE(215,36),MOI_NEXT_STATE(255,38),MOI_NEXT_STATE(294,40),
+     MOI_NEXT_STATE(-19,31),MOI_NEXT_STATE(-58,31),MOI_NEXT_STATE(-98,31),MOI_NEXT_STATE(-137,31),MOI_NEXT_STATE(-176,34),MOI_NEXT_STATE(-215,36),MOI_NEXT_STATE(-255,38),MOI_NEXT_STATE(-294,40)},
+    {MOI_NEXT_STATE(21,32),MOI_NEXT_STATE(64,32),MOI_NEXT_STATE(108,32),MOI_NEXT_STATE(151,32),MOI_NEXT_STATE(194,35),MOI_NEXT_STATE(237,37),MOI_NEXT_STATE(281,39),MOI_NEXT_STATE(324,41),
+     MOI_NEXT_STATE(-21,32),MOI_NEXT_STATE(-64,32),MOI_NEXT_STATE(-108,32),MOI_NEXT_STATE(-151,32),MOI_NEXT_STATE(-194,35),MOI_NEXT_STATE(-237,37),MOI_NEXT_STATE(-281,39),MOI_NEXT_STATE(-324,41)},
+    {MOI_NEXT_STATE(23,33),MOI_NEXT_STATE(71,33),MOI_NEXT_STATE(118,33),MOI_NEXT_STATE(166,33),MOI_NEXT_STATE(213,36),MOI_NEXT_STATE(261,38),MOI_NEXT_STATE(308,40),MOI_NEXT_STATE(356,42),
+     MOI_NEXT_STATE(-23,33),MOI_NEXT_STATE(-71,33),MOI_NEXT_STATE(-118,33),MOI_NEXT_STATE(-166,33),MOI_NEXT_STATE(-213,36),MOI_NEXT_STATE(-261,38),MOI_NEXT_STATE(-308,40),MOI_NEXT_STATE(-356,42)},
+    {MOI_NEXT_STATE(26,34),MOI_NEXT_STATE(78,34),MOI_NEXT_STATE(130,34),MOI_NEXT_STATE(182,34),MOI_NEXT_STATE(235,37),MOI_NEXT_STATE(287,39),MOI_NEXT_STATE(339,41),MOI_NEXT_STATE(391,43),
+     MOI_NEXT_STATE(-26,34),MOI_NEXT_STATE(-78,34),MOI_NEXT_STATE(-130,34),MOI_NEXT_STATE(-182,34),MOI_NEXT_STATE(-235,37),MOI_NEXT_STATE(-287,39),MOI_NEXT_STATE(-339,41),MOI_NEXT_STATE(-391,43)},
+    {MOI_NEXT_STATE(28,35),MOI_NEXT_STATE(86,35),MOI_NEXT_STATE(143,35),MOI_NEXT_STATE(201,35),MOI_NEXT_STATE(258,38),MOI_NEXT_STATE(316,40),MOI_NEXT_STATE(373,42),MOI_NEXT_STATE(431,44),
+     MOI_NEXT_STATE(-28,35),MOI_NEXT_STATE(-86,35),MOI_NEXT_STATE(-143,35),MOI_NEXT_STATE(-201,35),MOI_NEXT_STATE(-258,38),MOI_NEXT_STATE(-316,40),MOI_NEXT_STATE(-373,42),MOI_NEXT_STATE(-431,44)},
+    {MOI_NEXT_STATE(31,36),MOI_NEXT_STATE(94,36),MOI_NEXT_STATE(158,36),MOI_NEXT_STATE(221,36),MOI_NEXT_STATE(284,39),MOI_NEXT_STATE(347,41),MOI_NEXT_STATE(411,43),MOI_NEXT_STATE(474,45),
+     MOI_NEXT_STATE(-31,36),MOI_NEXT_STATE(-94,36),MOI_NEXT_STATE(-158,36),MOI_NEXT_STATE(-221,36),MOI_NEXT_STATE(-284,39),MOI_NEXT_STATE(-347,41),MOI_NEXT_STATE(-411,43),MOI_NEXT_STATE(-474,45)},
+    {MOI_NEXT_STATE(34,37),MOI_NEXT_STATE(104,37),MOI_NEXT_STATE(174,37),MOI_NEXT_STATE(244,37),MOI_NEXT_STATE(313,40),MOI_NEXT_STATE(383,42),MOI_NEXT_STATE(453,44),MOI_NEXT_STATE(523,46),
+     MOI_NEXT_STATE(-34,37),MOI_NEXT_STATE(-104,37),MOI_NEXT_STATE(-174,37),MOI_NEXT_STATE(-244,37),MOI_NEXT_STATE(-313,40),MOI_NEXT_STATE(-383,42),MOI_NEXT_STATE(-453,44),MOI_NEXT_STATE(-523,46)},
+    {MOI_NEXT_STATE(38,38),MOI_NEXT_STATE(115,38),MOI_NEXT_STATE(191,38),MOI_NEXT_STATE(268,38),MOI_NEXT_STATE(345,41),MOI_NEXT_STATE(422,43),MOI_NEXT_STATE(498,45),MOI_NEXT_STATE(575,47),
+     MOI_NEXT_STATE(-38,38),MOI_NEXT_STATE(-115,38),MOI_NEXT_STATE(-191,38),MOI_NEXT_STATE(-268,38),MOI_NEXT_STATE(-345,41),MOI_NEXT_STATE(-422,43),MOI_NEXT_STATE(-498,45),MOI_NEXT_STATE(-575,47)},
+    {MOI_NEXT_STATE(42,39),MOI_NEXT_STATE(126,39),MOI_NEXT_STATE(210,39),MOI_NEXT_STATE(294,39),MOI_NEXT_STATE(379,42),MOI_NEXT_STATE(463,44),MOI_NEXT_STATE(547,46),MOI_NEXT_STATE(631,48),
+     MOI_NEXT_STATE(-42,39),MOI_NEXT_STATE(-126,39),MOI_NEXT_STATE(-210,39),MOI_NEXT_STATE(-294,39),MOI_NEXT_STATE(-379,42),MOI_NEXT_STATE(-463,44),MOI_NEXT_STATE(-547,46),MOI_NEXT_STATE(-631,48)},
+    {MOI_NEXT_STATE(46,40),MOI_NEXT_STATE(139,40),MOI_NEXT_STATE(231,40),MOI_NEXT_STATE(324,40),MOI_NEXT_STATE(417,43),MOI_NEXT_STATE(510,45),MOI_NEXT_STATE(602,47),MOI_NEXT_STATE(695,49),
+     MOI_NEXT_STATE(-46,40),MOI_NEXT_STATE(-139,40),MOI_NEXT_STATE(-231,40),MOI_NEXT_STATE(-324,40),MOI_NEXT_STATE(-417,43),MOI_NEXT_STATE(-510,45),MOI_NEXT_STATE(-602,47),MOI_NEXT_STATE(-695,49)},
+    {MOI_NEXT_STATE(51,41),MOI_NEXT_STATE(153,41),MOI_NEXT_STATE(255,41),MOI_NEXT_STATE(357,41),MOI_NEXT_STATE(459,44),MOI_NEXT_STATE(561,46),MOI_NEXT_STATE(663,48),MOI_NEXT_STATE(765,50),
+     MOI_NEXT_STATE(-51,41),MOI_NEXT_STATE(-153,41),MOI_NEXT_STATE(-255,41),MOI_NEXT_STATE(-357,41),MOI_NEXT_STATE(-459,44),MOI_NEXT_STATE(-561,46),MOI_NEXT_STATE(-663,48),MOI_NEXT_STATE(-765,50)},
+    {MOI_NEXT_STATE(56,42),MOI_NEXT_STATE(168,42),MOI_NEXT_STATE(280,42),MOI_NEXT_STATE(392,42),MOI_NEXT_STATE(505,45),MOI_NEXT_STATE(617,47),MOI_NEXT_STATE(729,49),MOI_NEXT_STATE(841,51),
+     MOI_NEXT_STATE(-56,42),MOI_NEXT_STATE(-168,42),MOI_NEXT_STATE(-280,42),MOI_NEXT_STATE(-392,42),MOI_NEXT_STATE(-505,45),MOI_NEXT_STATE(-617,47),MOI_NEXT_STATE(-729,49),MOI_NEXT_STATE(-841,51)},
+    {MOI_NEXT_STATE(61,43),MOI_NEXT_STATE(185,43),MOI_NEXT_STATE(308,43),MOI_NEXT_STATE(432,43),MOI_NEXT_STATE(555,46),MOI_NEXT_STATE(679,48),MOI_NEXT_STATE(802,50),MOI_NEXT_STATE(926,52),
+     MOI_NEXT_STATE(-61,43),MOI_NEXT_STATE(-185,43),MOI_NEXT_STATE(-308,43),MOI_NEXT_STATE(-432,43),MOI_NEXT_STATE(-555,46),MOI_NEXT_STATE(-679,48),MOI_NEXT_STATE(-802,50),MOI_NEXT_STATE(-926,52)},
+    {MOI_NEXT_STATE(68,44),MOI_NEXT_STATE(204,44),MOI_NEXT_STATE(340,44),MOI_NEXT_STATE(476,44),MOI_NEXT_STATE(612,47),MOI_NEXT_STATE(748,49),MOI_NEXT_STATE(884,51),MOI_NEXT_STATE(1020,53),
+     MOI_NEXT_STATE(-68,44),MOI_NEXT_STATE(-204,44),MOI_NEXT_STATE(-340,44),MOI_NEXT_STATE(-476,44),MOI_NEXT_STATE(-612,47),MOI_NEXT_STATE(-748,49),MOI_NEXT_STATE(-884,51),MOI_NEXT_STATE(-1020,53)},
+    {MOI_NEXT_STATE(74,45),MOI_NEXT_STATE(224,45),MOI_NEXT_STATE(373,45),MOI_NEXT_STATE(523,45),MOI_NEXT_STATE(672,48),MOI_NEXT_STATE(822,50),MOI_NEXT_STATE(971,52),MOI_NEXT_STATE(1121,54),
+     MOI_NEXT_STATE(-74,45),MOI_NEXT_STATE(-224,45),MOI_NEXT_STATE(-373,45),MOI_NEXT_STATE(-523,45),MOI_NEXT_STATE(-672,48),MOI_NEXT_STATE(-822,50),MOI_NEXT_STATE(-971,52),MOI_NEXT_STATE(-1121,54)},
+    {MOI_NEXT_STATE(82,46),MOI_NEXT_STATE(246,46),MOI_NEXT_STATE(411,46),MOI_NEXT_STATE(575,46),MOI_NEXT_STATE(740,49),MOI_NEXT_STATE(904,51),MOI_NEXT_STATE(1069,53),MOI_NEXT_STATE(1233,55),
+     MOI_NEXT_STATE(-82,46),MOI_NEXT_STATE(-246,46),MOI_NEXT_STATE(-411,46),MOI_NEXT_STATE(-575,46),MOI_NEXT_STATE(-740,49),MOI_NEXT_STATE(-904,51),MOI_NEXT_STATE(-1069,53),MOI_NEXT_STATE(-1233,55)},
+    {MOI_NEXT_STATE(90,47),MOI_NEXT_STATE(271,47),MOI_NEXT_STATE(452,47),MOI_NEXT_STATE(633,47),MOI_NEXT_STATE(814,50),MOI_NEXT_STATE(995,52),MOI_NEXT_STATE(1176,54),MOI_NEXT_STATE(1357,56),
+     MOI_NEXT_STATE(-90,47),MOI_NEXT_STATE(-271,47),MOI_NEXT_STATE(-452,47),MOI_NEXT_STATE(-633,47),MOI_NEXT_STATE(-814,50),MOI_NEXT_STATE(-995,52),MOI_NEXT_STATE(-1176,54),MOI_NEXT_STATE(-1357,56)},
+    {MOI_NEXT_STATE(99,48),MOI_NEXT_STATE(298,48),MOI_NEXT_STATE(497,48),MOI_NEXT_STATE(696,48),MOI_NEXT_STATE(895,51),MOI_NEXT_STATE(1094,53),MOI_NEXT_STATE(1293,55),MOI_NEXT_STATE(1492,57),
+     MOI_NEXT_STATE(-99,48),MOI_NEXT_STATE(-298,48),MOI_NEXT_STATE(-497,48),MOI_NEXT_STATE(-696,48),MOI_NEXT_STATE(-895,51),MOI_NEXT_STATE(-1094,53),MOI_NEXT_STATE(-1293,55),MOI_NEXT_STATE(-1492,57)},
+    {MOI_NEXT_STATE(109,49),MOI_NEXT_STATE(328,49),MOI_NEXT_STATE(547,49),MOI_NEXT_STATE(766,49),MOI_NEXT_STATE(985,52),MOI_NEXT_STATE(1204,54),MOI_NEXT_STATE(1423,56),MOI_NEXT_STATE(1642,58),
+     MOI_NEXT_STATE(-109,49),MOI_NEXT_STATE(-328,49),MOI_NEXT_STATE(-547,49),MOI_NEXT_STATE(-766,49),MOI_NEXT_STATE(-985,52),MOI_NEXT_STATE(-1204,54),MOI_NEXT_STATE(-1423,56),MOI_NEXT_STATE(-1642,58)},
+    {MOI_NEXT_STATE(120,50),MOI_NEXT_STATE(361,50),MOI_NEXT_STATE(601,50),MOI_NEXT_STATE(842,50),MOI_NEXT_STATE(1083,53),MOI_NEXT_STATE(1324,55),MOI_NEXT_STATE(1564,57),MOI_NEXT_STATE(1805,59),
+     MOI_NEXT_STATE(-120,50),MOI_NEXT_STATE(-361,50),MOI_NEXT_STATE(-601,50),MOI_NEXT_STATE(-842,50),MOI_NEXT_STATE(-1083,53),MOI_NEXT_STATE(-1324,55),MOI_NEXT_STATE(-1564,57),MOI_NEXT_STATE(-1805,59)},
+    {MOI_NEXT_STATE(132,51),MOI_NEXT_STATE(397,51),MOI_NEXT_STATE(662,51),MOI_NEXT_STATE(927,51),MOI_NEXT_STATE(1192,54),MOI_NEXT_STATE(1457,56),MOI_NEXT_STATE(1722,58),MOI_NEXT_STATE(1987,60),
+     MOI_NEXT_STATE(-132,51),MOI_NEXT_STATE(-397,51),MOI_NEXT_STATE(-662,51),MOI_NEXT_STATE(-927,51),MOI_NEXT_STATE(-1192,54),MOI_NEXT_STATE(-1457,56),MOI_NEXT_STATE(-1722,58),MOI_NEXT_STATE(-1987,60)},
+    {MOI_NEXT_STATE(145,52),MOI_NEXT_STATE(437,52),MOI_NEXT_STATE(728,52),MOI_NEXT_STATE(1020,52),MOI_NEXT_STATE(1311,55),MOI_NEXT_STATE(1603,57),MOI_NEXT_STATE(1894,59),MOI_NEXT_STATE(2186,61),
+     MOI_NEXT_STATE(-145,52),MOI_NEXT_STATE(-437,52),MOI_NEXT_STATE(-728,52),MOI_NEXT_STATE(-1020,52),MOI_NEXT_STATE(-1311,55),MOI_NEXT_STATE(-1603,57),MOI_NEXT_STATE(-1894,59),MOI_NEXT_STATE(-2186,61)},
+    {MOI_NEXT_STATE(160,53),MOI_NEXT_STATE(480,53),MOI_NEXT_STATE(801,53),MOI_NEXT_STATE(1121,53),MOI_NEXT_STATE(1442,56),MOI_NEXT_STATE(1762,58),MOI_NEXT_STATE(2083,60),MOI_NEXT_STATE(2403,62),
+     MOI_NEXT_STATE(-160,53),MOI_NEXT_STATE(-480,53),MOI_NEXT_STATE(-801,53),MOI_NEXT_STATE(-1121,53),MOI_NEXT_STATE(-1442,56),MOI_NEXT_STATE(-1762,58),MOI_NEXT_STATE(-2083,60),MOI_NEXT_STATE(-2403,62)},
+    {MOI_NEXT_STATE(176,54),MOI_NEXT_STATE(529,54),MOI_NEXT_STATE(881,54),MOI_NEXT_STATE(1234,54),MOI_NEXT_STATE(1587,57),MOI_NEXT_STATE(1940,59),MOI_NEXT_STATE(2292,61),MOI_NEXT_STATE(2645,63),
+     MOI_NEXT_STATE(-176,54),MOI_NEXT_STATE(-529,54),MOI_NEXT_STATE(-881,54),MOI_NEXT_STATE(-1234,54),MOI_NEXT_STATE(-1587,57),MOI_NEXT_STATE(-1940,59),MOI_NEXT_STATE(-2292,61),MOI_NEXT_STATE(-2645,63)},
+    {MOI_NEXT_STATE(194,55),MOI_NEXT_STATE(582,55),MOI_NEXT_STATE(970,55),MOI_NEXT_STATE(1358,55),MOI_NEXT_STATE(1746,58),MOI_NEXT_STATE(2134,60),MOI_NEXT_STATE(2522,62),MOI_NEXT_STATE(2910,64),
+     MOI_NEXT_STATE(-194,55),MOI_NEXT_STATE(-582,55),MOI_NEXT_STATE(-970,55),MOI_NEXT_STATE(-1358,55),MOI_NEXT_STATE(-1746,58),MOI_NEXT_STATE(-2134,60),MOI_NEXT_STATE(-2522,62),MOI_NEXT_STATE(-2910,64)},
+    {MOI_NEXT_STATE(213,56),MOI_NEXT_STATE(640,56),MOI_NEXT_STATE(1066,56),MOI_NEXT_STATE(1493,56),MOI_NEXT_STATE(1920,59),MOI_NEXT_STATE(2347,61),MOI_NEXT_STATE(2773,63),MOI_NEXT_STATE(3200,65),
+     MOI_NEXT_STATE(-213,56),MOI_NEXT_STATE(-640,56),MOI_NEXT_STATE(-1066,56),MOI_NEXT_STATE(-1493,56),MOI_NEXT_STATE(-1920,59),MOI_NEXT_STATE(-2347,61),MOI_NEXT_STATE(-2773,63),MOI_NEXT_STATE(-3200,65)},
+    {MOI_NEXT_STATE(234,57),MOI_NEXT_STATE(704,57),MOI_NEXT_STATE(1173,57),MOI_NEXT_STATE(1643,57),MOI_NEXT_STATE(2112,60),MOI_NEXT_STATE(2582,62),MOI_NEXT_STATE(3051,64),MOI_NEXT_STATE(3521,66),
+     MOI_NEXT_STATE(-234,57),MOI_NEXT_STATE(-704,57),MOI_NEXT_STATE(-1173,57),MOI_NEXT_STATE(-1643,57),MOI_NEXT_STATE(-2112,60),MOI_NEXT_STATE(-2582,62),MOI_NEXT_STATE(-3051,64),MOI_NEXT_STATE(-3521,66)},
+    {MOI_NEXT_STATE(258,58),MOI_NEXT_STATE(774,58),MOI_NEXT_STATE(1291,58),MOI_NEXT_STATE(1807,58),MOI_NEXT_STATE(2324,61),MOI_NEXT_STATE(2840,63),MOI_NEXT_STATE(3357,65),MOI_NEXT_STATE(3873,67),
+     MOI_NEXT_STATE(-258,58),MOI_NEXT_STATE(-774,58),MOI_NEXT_STATE(-1291,58),MOI_NEXT_STATE(-1807,58),MOI_NEXT_STATE(-2324,61),MOI_NEXT_STATE(-2840,63),MOI_NEXT_STATE(-3357,65),MOI_NEXT_STATE(-3873,67)},
+    {MOI_NEXT_STATE(284,59),MOI_NEXT_STATE(852,59),MOI_NEXT_STATE(1420,59),MOI_NEXT_STATE(1988,59),MOI_NEXT_STATE(2556,62),MOI_NEXT_STATE(3124,64),MOI_NEXT_STATE(3692,66),MOI_NEXT_STATE(4260,68),
+     MOI_NEXT_STATE(-284,59),MOI_NEXT_STATE(-852,59),MOI_NEXT_STATE(-1420,59),MOI_NEXT_STATE(-1988,59),MOI_NEXT_STATE(-2556,62),MOI_NEXT_STATE(-3124,64),MOI_NEXT_STATE(-3692,66),MOI_NEXT_STATE(-4260,68)},
+    {MOI_NEXT_STATE(312,60),MOI_NEXT_STATE(937,60),MOI_NEXT_STATE(1561,60),MOI_NEXT_STATE(2186,60),MOI_NEXT_STATE(2811,63),MOI_NEXT_STATE(3436,65),MOI_NEXT_STATE(4060,67),MOI_NEXT_STATE(4685,69),
+     MOI_NEXT_STATE(-312,60),MOI_NEXT_STATE(-937,60),MOI_NEXT_STATE(-1561,60),MOI_NEXT_STATE(-2186,60),MOI_NEXT_STATE(-2811,63),MOI_NEXT_STATE(-3436,65),MOI_NEXT_STATE(-4060,67),MOI_NEXT_STATE(-4685,69)},
+    {MOI_NEXT_STATE(343,61),MOI_NEXT_STATE(1030,61),MOI_NEXT_STATE(1718,61),MOI_NEXT_STATE(2405,61),MOI_NEXT_STATE(3092,64),MOI_NEXT_STATE(3779,66),MOI_NEXT_STATE(4467,68),MOI_NEXT_STATE(5154,70),
+     MOI_NEXT_STATE(-343,61),MOI_NEXT_STATE(-1030,61),MOI_NEXT_STATE(-1718,61),MOI_NEXT_STATE(-2405,61),MOI_NEXT_STATE(-3092,64),MOI_NEXT_STATE(-3779,66),MOI_NEXT_STATE(-4467,68),MOI_NEXT_STATE(-5154,70)},
+    {MOI_NEXT_STATE(378,62),MOI_NEXT_STATE(1134,62),MOI_NEXT_STATE(1890,62),MOI_NEXT_STATE(2646,62),MOI_NEXT_STATE(3402,65),MOI_NEXT_STATE(4158,67),MOI_NEXT_STATE(4914,69),MOI_NEXT_STATE(5670,71),
+     MOI_NEXT_STATE(-378,62),MOI_NEXT_STATE(-1134,62),MOI_NEXT_STATE(-1890,62),MOI_NEXT_STATE(-2646,62),MOI_NEXT_STATE(-3402,65),MOI_NEXT_STATE(-4158,67),MOI_NEXT_STATE(-4914,69),MOI_NEXT_STATE(-5670,71)},
+    {MOI_NEXT_STATE(415,63),MOI_NEXT_STATE(1247,63),MOI_NEXT_STATE(2079,63),MOI_NEXT_STATE(2911,63),MOI_NEXT_STATE(3742,66),MOI_NEXT_STATE(4574,68),MOI_NEXT_STATE(5406,70),MOI_NEXT_STATE(6238,72),
+     MOI_NEXT_STATE(-415,63),MOI_NEXT_STATE(-1247,63),MOI_NEXT_STATE(-2079,63),MOI_NEXT_STATE(-2911,63),MOI_NEXT_STATE(-3742,66),MOI_NEXT_STATE(-4574,68),MOI_NEXT_STATE(-5406,70),MOI_NEXT_STATE(-6238,72)},
+    {MOI_NEXT_STATE(457,64),MOI_NEXT_STATE(1372,64),MOI_NEXT_STATE(2287,64),MOI_NEXT_STATE(3202,64),MOI_NEXT_STATE(4117,67),MOI_NEXT_STATE(5032,69),MOI_NEXT_STATE(5947,71),MOI_NEXT_STATE(6862,73),
+     MOI_NEXT_STATE(-457,64),MOI_NEXT_STATE(-1372,64),MOI_NEXT_STATE(-2287,64),MOI_NEXT_STATE(-3202,64),MOI_NEXT_STATE(-4117,67),MOI_NEXT_STATE(-5032,69),MOI_NEXT_STATE(-5947,71),MOI_NEXT_STATE(-6862,73)},
+    {MOI_NEXT_STATE(503,65),MOI_NEXT_STATE(1509,65),MOI_NEXT_STATE(2516,65),MOI_NEXT_STATE(3522,65),MOI_NEXT_STATE(4529,68),MOI_NEXT_STATE(5535,70),MOI_NEXT_STATE(6542,72),MOI_NEXT_STATE(7548,74),
+     MOI_NEXT_STATE(-503,65),MOI_NEXT_STATE(-1509,65),MOI_NEXT_STATE(-2516,65),MOI_NEXT_STATE(-3522,65),MOI_NEXT_STATE(-4529,68),MOI_NEXT_STATE(-5535,70),MOI_NEXT_STATE(-6542,72),MOI_NEXT_STATE(-7548,74)},
+    {MOI_NEXT_STATE(553,66),MOI_NEXT_STATE(1660,66),MOI_NEXT_STATE(2767,66),MOI_NEXT_STATE(3874,66),MOI_NEXT_STATE(4981,69),MOI_NEXT_STATE(6088,71),MOI_NEXT_STATE(7195,73),MOI_NEXT_STATE(8302,75),
+     MOI_NEXT_STATE(-553,66),MOI_NEXT_STATE(-1660,66),MOI_NEXT_STATE(-2767,66),MOI_NEXT_STATE(-3874,66),MOI_NEXT_STATE(-4981,69),MOI_NEXT_STATE(-6088,71),MOI_NEXT_STATE(-7195,73),MOI_NEXT_STATE(-8302,75)},
+    {MOI_NEXT_STATE(608,67),MOI_NEXT_STATE(1826,67),MOI_NEXT_STATE(3044,67),MOI_NEXT_STATE(4262,67),MOI_NEXT_STATE(5479,70),MOI_NEXT_STATE(6697,72),MOI_NEXT_STATE(7915,74),MOI_NEXT_STATE(9133,76),
+     MOI_NEXT_STATE(-608,67),MOI_NEXT_STATE(-1826,67),MOI_NEXT_STATE(-3044,67),MOI_NEXT_STATE(-4262,67),MOI_NEXT_STATE(-5479,70),MOI_NEXT_STATE(-6697,72),MOI_NEXT_STATE(-7915,74),MOI_NEXT_STATE(-9133,76)},
+    {MOI_NEXT_STATE(669,68),MOI_NEXT_STATE(2009,68),MOI_NEXT_STATE(3348,68),MOI_NEXT_STATE(4688,68),MOI_NEXT_STATE(6027,71),MOI_NEXT_STATE(7367,73),MOI_NEXT_STATE(8706,75),MOI_NEXT_STATE(10046,77),
+     MOI_NEXT_STATE(-669,68),MOI_NEXT_STATE(-2009,68),MOI_NEXT_STATE(-3348,68),MOI_NEXT_STATE(-4688,68),MOI_NEXT_STATE(-6027,71),MOI_NEXT_STATE(-7367,73),MOI_NEXT_STATE(-8706,75),MOI_NEXT_STATE(-10046,77)},
+    {MOI_NEXT_STATE(736,69),MOI_NEXT_STATE(2210,69),MOI_NEXT_STATE(3683,69),MOI_NEXT_STATE(5157,69),MOI_NEXT_STATE(6630,72),MOI_NEXT_STATE(8104,74),MOI_NEXT_STATE(9577,76),MOI_NEXT_STATE(11051,78),
+     MOI_NEXT_STATE(-736,69),MOI_NEXT_STATE(-2210,69),MOI_NEXT_STATE(-3683,69),MOI_NEXT_STATE(-5157,69),MOI_NEXT_STATE(-6630,72),MOI_NEXT_STATE(-8104,74),MOI_NEXT_STATE(-9577,76),MOI_NEXT_STATE(-11051,78)},
+    {MOI_NEXT_STATE(810,70),MOI_NEXT_STATE(2431,70),MOI_NEXT_STATE(4052,70),MOI_NEXT_STATE(5673,70),MOI_NEXT_STATE(7294,73),MOI_NEXT_STATE(8915,75),MOI_NEXT_STATE(10536,77),MOI_NEXT_STATE(12157,79),
+     MOI_NEXT_STATE(-810,70),MOI_NEXT_STATE(-2431,70),MOI_NEXT_STATE(-4052,70),MOI_NEXT_STATE(-5673,70),MOI_NEXT_STATE(-7294,73),MOI_NEXT_STATE(-8915,75),MOI_NEXT_STATE(-10536,77),MOI_NEXT_STATE(-12157,79)},
+    {MOI_NEXT_STATE(891,71),MOI_NEXT_STATE(2674,71),MOI_NEXT_STATE(4457,71),MOI_NEXT_STATE(6240,71),MOI_NEXT_STATE(8023,74),MOI_NEXT_STATE(9806,76),MOI_NEXT_STATE(11589,78),MOI_NEXT_STATE(13372,80),
+     MOI_NEXT_STATE(-891,71),MOI_NEXT_STATE(-2674,71),MOI_NEXT_STATE(-4457,71),MOI_NEXT_STATE(-6240,71),MOI_NEXT_STATE(-8023,74),MOI_NEXT_STATE(-9806,76),MOI_NEXT_STATE(-11589,78),MOI_NEXT_STATE(-13372,80)},
+    {MOI_NEXT_STATE(980,72),MOI_NEXT_STATE(2941,72),MOI_NEXT_STATE(4903,72),MOI_NEXT_STATE(6864,72),MOI_NEXT_STATE(8825,75),MOI_NEXT_STATE(10786,77),MOI_NEXT_STATE(12748,79),MOI_NEXT_STATE(14709,81),
+     MOI_NEXT_STATE(-980,72),MOI_NEXT_STATE(-2941,72),MOI_NEXT_STATE(-4903,72),MOI_NEXT_STATE(-6864,72),MOI_NEXT_STATE(-8825,75),MOI_NEXT_STATE(-10786,77),MOI_NEXT_STATE(-12748,79),MOI_NEXT_STATE(-14709,81)},
+    {MOI_NEXT_STATE(1078,73),MOI_NEXT_STATE(3236,73),MOI_NEXT_STATE(5393,73),MOI_NEXT_STATE(7551,73),MOI_NEXT_STATE(9708,76),MOI_NEXT_STATE(11866,78),MOI_NEXT_STATE(14023,80),MOI_NEXT_STATE(16181,82),
+     MOI_NEXT_STATE(-1078,73),MOI_NEXT_STATE(-3236,73),MOI_NEXT_STATE(-5393,73),MOI_NEXT_STATE(-7551,73),MOI_NEXT_STATE(-9708,76),MOI_NEXT_STATE(-11866,78),MOI_NEXT_STATE(-14023,80),MOI_NEXT_STATE(-16181,82)},
+    {MOI_NEXT_STATE(1186,74),MOI_NEXT_STATE(3559,74),MOI_NEXT_STATE(5933,74),MOI_NEXT_STATE(8306,74),MOI_NEXT_STATE(10679,77),MOI_NEXT_STATE(13052,79),MOI_NEXT_STATE(15426,81),MOI_NEXT_STATE(17799,83),
+     MOI_NEXT_STATE(-1186,74),MOI_NEXT_STATE(-3559,74),MOI_NEXT_STATE(-5933,74),MOI_NEXT_STATE(-8306,74),MOI_NEXT_STATE(-10679,77),MOI_NEXT_STATE(-13052,79),MOI_NEXT_STATE(-15426,81),MOI_NEXT_STATE(-17799,83)},
+    {MOI_NEXT_STATE(1305,75),MOI_NEXT_STATE(3915,75),MOI_NEXT_STATE(6526,75),MOI_NEXT_STATE(9136,75),MOI_NEXT_STATE(11747,78),MOI_NEXT_STATE(14357,80),MOI_NEXT_STATE(16968,82),MOI_NEXT_STATE(19578,84),
+     MOI_NEXT_STATE(-1305,75),MOI_NEXT_STATE(-3915,75),MOI_NEXT_STATE(-6526,75),MOI_NEXT_STATE(-9136,75),MOI_NEXT_STATE(-11747,78),MOI_NEXT_STATE(-14357,80),MOI_NEXT_STATE(-16968,82),MOI_NEXT_STATE(-19578,84)},
+    {MOI_NEXT_STATE(1435,76),MOI_NEXT_STATE(4307,76),MOI_NEXT_STATE(7179,76),MOI_NEXT_STATE(10051,76),MOI_NEXT_STATE(12922,79),MOI_NEXT_STATE(15794,81),MOI_NEXT_STATE(18666,83),MOI_NEXT_STATE(21538,85),
+     MOI_NEXT_STATE(-1435,76),MOI_NEXT_STATE(-4307,76),MOI_NEXT_STATE(-7179,76),MOI_NEXT_STATE(-10051,76),MOI_NEXT_STATE(-12922,79),MOI_NEXT_STATE(-15794,81),MOI_NEXT_STATE(-18666,83),MOI_NEXT_STATE(-21538,85)},
+    {MOI_NEXT_STATE(1579,77),MOI_NEXT_STATE(4738,77),MOI_NEXT_STATE(7896,77),MOI_NEXT_STATE(11055,77),MOI_NEXT_STATE(14214,80),MOI_NEXT_STATE(17373,82),MOI_NEXT_STATE(20531,84),MOI_NEXT_STATE(23690,86),
+     MOI_NEXT_STATE(-1579,77),MOI_NEXT_STATE(-4738,77),MOI_NEXT_STATE(-7896,77),MOI_NEXT_STATE(-11055,77),MOI_NEXT_STATE(-14214,80),MOI_NEXT_STATE(-17373,82),MOI_NEXT_STATE(-20531,84),MOI_NEXT_STATE(-23690,86)},
+    {MOI_NEXT_STATE(1737,78),MOI_NEXT_STATE(5212,78),MOI_NEXT_STATE(8686,78),MOI_NEXT_STATE(12161,78),MOI_NEXT_STATE(15636,81),MOI_NEXT_STATE(19111,83),MOI_NEXT_STATE(22585,85),MOI_NEXT_STATE(26060,87),
+     MOI_NEXT_STATE(-1737,78),MOI_NEXT_STATE(-5212,78),MOI_NEXT_STATE(-8686,78),MOI_NEXT_STATE(-12161,78),MOI_NEXT_STATE(-15636,81),MOI_NEXT_STATE(-19111,83),MOI_NEXT_STATE(-22585,85),MOI_NEXT_STATE(-26060,87)},
+    {MOI_NEXT_STATE(1911,79),MOI_NEXT_STATE(5733,79),MOI_NEXT_STATE(9555,79),MOI_NEXT_STATE(13377,79),MOI_NEXT_STATE(17200,82),MOI_NEXT_STATE(21022,84),MOI_NEXT_STATE(24844,86),MOI_NEXT_STATE(28666,88),
+     MOI_NEXT_STATE(-1911,79),MOI_NEXT_STATE(-5733,79),MOI_NEXT_STATE(-9555,79),MOI_NEXT_STATE(-13377,79),MOI_NEXT_STATE(-17200,82),MOI_NEXT_STATE(-21022,84),MOI_NEXT_STATE(-24844,86),MOI_NEXT_STATE(-28666,88)},
+    {MOI_NEXT_STATE(2102,80),MOI_NEXT_STATE(6306,80),MOI_NEXT_STATE(10511,80),MOI_NEXT_STATE(14715,80),MOI_NEXT_STATE(18920,83),MOI_NEXT_STATE(23124,85),MOI_NEXT_STATE(27329,87),MOI_NEXT_STATE(31533,88),
+     MOI_NEXT_STATE(-2102,80),MOI_NEXT_STATE(-6306,80),MOI_NEXT_STATE(-10511,80),MOI_NEXT_STATE(-14715,80),MOI_NEXT_STATE(-18920,83),MOI_NEXT_STATE(-23124,85),MOI_NEXT_STATE(-27329,87),MOI_NEXT_STATE(-31533,88)},
+    {MOI_NEXT_STATE(2312,81),MOI_NEXT_STATE(6937,81),MOI_NEXT_STATE(11562,81),MOI_NEXT_STATE(16187,81),MOI_NEXT_STATE(20812,84),MOI_NEXT_STATE(25437,86),MOI_NEXT_STATE(30062,88),MOI_NEXT_STATE(34687,88),
+     MOI_NEXT_STATE(-2312,81),MOI_NEXT_STATE(-6937,81),MOI_NEXT_STATE(-11562,81),MOI_NEXT_STATE(-16187,81),MOI_NEXT_STATE(-20812,84),MOI_NEXT_STATE(-25437,86),MOI_NEXT_STATE(-30062,88),MOI_NEXT_STATE(-34687,88)},
+    {MOI_NEXT_STATE(2543,82),MOI_NEXT_STATE(7631,82),MOI_NEXT_STATE(12718,82),MOI_NEXT_STATE(17806,82),MOI_NEXT_STATE(22893,85),MOI_NEXT_STATE(27981,87),MOI_NEXT_STATE(33068,88),MOI_NEXT_STATE(38156,88),
+     MOI_NEXT_STATE(-2543,82),MOI_NEXT_STATE(-7631,82),MOI_NEXT_STATE(-12718,82),MOI_NEXT_STATE(-17806,82),MOI_NEXT_STATE(-22893,85),MOI_NEXT_STATE(-27981,87),MOI_NEXT_STATE(-33068,88),MOI_NEXT_STATE(-38156,88)},
+    {MOI_NEXT_STATE(2798,83),MOI_NEXT_STATE(8394,83),MOI_NEXT_STATE(13990,83),MOI_NEXT_STATE(19586,83),MOI_NEXT_STATE(25183,86),MOI_NEXT_STATE(30779,88),MOI_NEXT_STATE(36375,88),MOI_NEXT_STATE(41971,88),
+     MOI_NEXT_STATE(-2798,83),MOI_NEXT_STATE(-8394,83),MOI_NEXT_STATE(-13990,83),MOI_NEXT_STATE(-19586,83),MOI_NEXT_STATE(-25183,86),MOI_NEXT_STATE(-30779,88),MOI_NEXT_STATE(-36375,88),MOI_NEXT_STATE(-41971,88)},
+    {MOI_NEXT_STATE(3077,84),MOI_NEXT_STATE(9233,84),MOI_NEXT_STATE(15389,84),MOI_NEXT_STATE(21545,84),MOI_NEXT_STATE(27700,87),MOI_NEXT_STATE(33856,88),MOI_NEXT_STATE(40012,88),MOI_NEXT_STATE(46168,88),
+     MOI_NEXT_STATE(-3077,84),MOI_NEXT_STATE(-9233,84),MOI_NEXT_STATE(-15389,84),MOI_NEXT_STATE(-21545,84),MOI_NEXT_STATE(-27700,87),MOI_NEXT_STATE(-33856,88),MOI_NEXT_STATE(-40012,88),MOI_NEXT_STATE(-46168,88)},
+    {MOI_NEXT_STATE(3385,85),MOI_NEXT_STATE(10157,85),MOI_NEXT_STATE(16928,85),MOI_NEXT_STATE(23700,85),MOI_NEXT_STATE(30471,88),MOI_NEXT_STATE(37243,88),MOI_NEXT_STATE(44014,88),MOI_NEXT_STATE(50786,88),
+     MOI_NEXT_STATE(-3385,85),MOI_NEXT_STATE(-10157,85),MOI_NEXT_STATE(-16928,85),MOI_NEXT_STATE(-23700,85),MOI_NEXT_STATE(-30471,88),MOI_NEXT_STATE(-37243,88),MOI_NEXT_STATE(-44014,88),MOI_NEXT_STATE(-50786,88)},
+    {MOI_NEXT_STATE(3724,86),MOI_NEXT_STATE(11172,86),MOI_NEXT_STATE(18621,86),MOI_NEXT_STATE(26069,86),MOI_NEXT_STATE(33518,88),MOI_NEXT_STATE(40966,88),MOI_NEXT_STATE(48415,88),MOI_NEXT_STATE(55863,88),
+     MOI_NEXT_STATE(-3724,86),MOI_NEXT_STATE(-11172,86),MOI_NEXT_STATE(-18621,86),MOI_NEXT_STATE(-26069,86),MOI_NEXT_STATE(-33518,88),MOI_NEXT_STATE(-40966,88),MOI_NEXT_STATE(-48415,88),MOI_NEXT_STATE(-55863,88)},
+    {MOI_NEXT_STATE(4095,87),MOI_NEXT_STATE(12287,87),MOI_NEXT_STATE(20479,87),MOI_NEXT_STATE(28671,87),MOI_NEXT_STATE(36862,88),MOI_NEXT_STATE(45054,88),MOI_NEXT_STATE(53246,88),MOI_NEXT_STATE(61438,88),
+     MOI_NEXT_STATE(-4095,87),MOI_NEXT_STATE(-12287,87),MOI_NEXT_STATE(-20479,87),MOI_NEXT_STATE(-28671,87),MOI_NEXT_STATE(-36862,88),MOI_NEXT_STATE(-45054,88),MOI_NEXT_STATE(-53246,88),MOI_NEXT_STATE(-61438,88)},
+};
+
+
+/* 最大変位テーブル: [ステップサイズインデックス][ステップ数]
+* 指定インデックスから指定ステップ数（0〜8）で予測値が動きうる距離の最大値 */
+static const int32_t MOI_max_displacement_table[89][9] = {
+    {0,13,43,106,242,536,1167,2524,5434},
+    {0,15,46,115,265,589,1284,2776,5976},
+    {0,16,51,127,292,648,1413,3055,6576},
+    {0,18,57,141,322,713,1554,3359,7232},
+    {0,20,63,156,356,787,1713,3700,7960},
+    {0,22,68,171,392,866,1886,4072,8757},
+    {0,24,76,188,431,954,2075,4478,9632},
+    {0,26,84,207,475,1050,2283,4928,10598},
+    {0,30,93,229,523,1154,2511,5421,11659},
+    {0,31,100,250,574,1269,2761,5961,12823},
+    {0,35,111,276,632,1397,3039,6560,14108},
+    {0,39,123,304,695,1536,3341,7214,15516},
+    {0,43,136,336,767,1693,3680,7940,17073},
+    {0,46,149,370,844,1864,4050,8735,18781},
+    {0,52,164,407,930,2051,4454,9608,20659},
+    {0,58,181,449,1024,2257,4902,10572,22729},
+    {0,63,199,493,1124,2481,5391,11629,25001},
+    {0,69,219,543,1238,2730,5930,12792,27501},
+    {0,76,241,597,1362,3004,6525,14073,30254},
+    {0,84,265,656,1497,3302,7175,15477,33276},
+    {0,93,293,724,1650,3637,7897,17030,36608},
+    {0,103,324,798,1818,4004,8689,18735,40273},
+    {0,112,355,878,1999,4402,9556,20607,44297},
+    {0,123,391,966,2199,4844,10514,22671,48731},
+    {0,136,430,1061,2418,5328,11566,24938,53604},
+    {0,150,474,1169,2661,5861,12723,27432,58965},
+    {0,165,521,1286,2928,6449,13997,30178,64865},
+    {0,181,572,1413,3218,7091,15393,33192,71348},
+    {0,200,631,1557,3544,7804,16937,36515,78486},
+    {0,221,695,1715,3901,8586,18632,40170,86338},
+    {0,243,766,1887,4290,9444,20495,44185,94971},
+    {0,268,843,2076,4721,10391,22548,48608,104471},
+    {0,294,925,2282,5192,11430,24802,53468,114906},
+    {0,324,1019,2511,5711,12573,27282,58815,120253},
+    {0,356,1121,2763,6284,13832,30013,64700,126138},
+    {0,391,1232,3037,6910,15212,33011,71167,132605},
+    {0,431,1357,3344,7604,16737,36315,78286,139724},
+    {0,474,1494,3680,8365,18411,39949,86117,147555},
+    {0,523,1644,4047,9201,20252,43942,94728,156166},
+    {0,575,1808,4453,10123,22280,48340,104203,165641},
+    {0,631,1988,4898,11136,24508,53174,114612,176050},
+    {0,695,2187,5387,12249,26958,58491,119929,181367},
+    {0,765,2407,5928,13476,29657,64344,125782,187220},
+    {0,841,2646,6519,14821,32620,70776,132214,193652},
+    {0,926,2913,7173,16306,35884,77855,139293,200731},
+    {0,1020,3206,7891,17937,39475,85643,147081,208519},
+    {0,1121,3524,8678,19729,43419,94205,155643,217081},
+    {0,1233,3878,9548,21705,47765,103628,165066,226504},
+    {0,1357,4267,10505,23877,52543,113981,175419,236857},
+    {0,1492,4692,11554,26263,57796,119234,180672,242110},
+    {0,1642,5163,12711,28892,63579,125017,186455,247893},
+    {0,1805,5678,13980,31779,69935,131373,192811,254249},
+    {0,1987,6247,15380,34958,76929,138367,199805,261243},
+    {0,2186,6871,16917,38455,84623,146061,207499,268937},
+    {0,2403,7557,18608,42298,93084,154522,215960,277398},
+    {0,2645,8315,20472,46532,102395,163833,225271,286709},
+    {0,2910,9148,22520,51186,112624,174062,235500,296938},
+    {0,3200,10062,24771,56304,117742,179180,240618,302056},
+    {0,3521,11069,27250,61937,123375,184813,246251,307689},
+    {0,3873,12175,29974,68130,129568,191006,252444,313882},
+    {0,4260,13393,32971,74942,136380,197818,259256,320694},
+    {0,4685,14731,36269,82437,143875,205313,266751,328189},
+    {0,5154,16205,39895,90681,152119,213557,274995,336433},
+    {0,5670,17827,43887,99750,161188,222626,284064,345502},
+    {0,6238,19610,48276,109714,171152,232590,294028,355466},
+    {0,6862,21571,53104,114542,175980,237418,298856,360294},
+    {0,7548,23729,58416,119854,181292,242730,304168,365606},
+    {0,8302,26101,64257,125695,187133,248571,310009,371447},
+    {0,9133,28711,70682,132120,193558,254996,316434,377872},
+    {0,10046,31584,77752,139190,200628,262066,323504,384942},
+    {0,11051,34741,85527,146965,208403,269841,331279,392717},
+    {0,12157,38217,94080,155518,216956,278394,339832,401270},
+    {0,13372,42038,103476,164914,226352,287790,349228,410666},
+    {0,14709,46242,107680,169118,230556,291994,353432,414870},
+    {0,16181,50868,112306,173744,235182,296620,358058,419496},
+    {0,17799,55955,117393,178831,240269,301707,363145,424583},
+    {0,19578,61549,122987,184425,245863,307301,368739,430177},
+    {0,21538,67706,129144,190582,252020,313458,374896,436334},
+    {0,23690,74476,135914,197352,258790,320228,381666,443104},
+    {0,26060,81923,143361,204799,266237,327675,389113,450551},
+    {0,28666,90104,151542,212980,274418,335856,397294,458732},
+    {0,31533,92971,154409,215847,277285,338723,400161,461599},
+    {0,34687,96125,157563,219001,280439,341877,403315,464753},
+    {0,38156,99594,161032,222470,283908,345346,406784,468222},
+    {0,41971,103409,164847,226285,287723,349161,410599,472037},
+    {0,46168,107606,169044,230482,291920,353358,414796,476234},
+    {0,50786,112224,173662,235100,296538,357976,419414,480852},
+    {0,55863,117301,178739,240177,301615,363053,424491,485929},
+    {0,61438,122876,184314,245752,307190,368628,430066,491504},
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -206,42 +206,23 @@ MOIApiResult MOIDecoder_DecodeHeader(
 static int16_t MOICoreDecoder_DecodeSample(
         struct MOICoreDecoder *decoder, uint8_t nibble)
 {
-    int8_t  idx;
-    int32_t predict, qdiff, delta, stepsize;
+    int32_t predict, next_state;
 
     MOI_ASSERT(decoder != NULL);
+    MOI_ASSERT(nibble < 16);
 
-    /* 頻繁に参照する変数をオート変数に受ける */
-    predict = decoder->sample_val;
-    idx = decoder->stepsize_index;
-
-    /* ステップサイズの取得 */
-    stepsize = IMAADPCM_stepsize_table[idx];
-
-    /* インデックス更新 */
-    idx = (int8_t)(idx + IMAADPCM_index_table[nibble]);
-    idx = MOI_INNER_VAL(idx, 0, (int8_t)MOI_IMAADPCM_STEPSIZE_TABLE_SIZE - 1);
-
-    /* 差分算出 */
-    /* diff = stepsize * (delta * 2 + 1) / 8 */
+    /* 符号付きの差分 stepsize * (delta * 2 + 1) / 8 とクリップ済みの次のインデックスを1回の参照で取得 */
     /* memo:ffmpegを参考に、よくある分岐多用の実装はしない。
     * 分岐多用の実装は近似で結果がおかしいし、分岐ミスの方が負荷が大きいと判断 */
-    delta = nibble & 7;
-    qdiff = (stepsize * ((delta << 1) + 1)) >> 3;
-
-    /* 差分を加える 符号ビットで加算/減算を切り替え */
-    if (nibble & 8) {
-        predict -= qdiff;
-    } else {
-        predict += qdiff;
-    }
+    next_state = MOI_next_state_table[decoder->stepsize_index][nibble];
 
-    /* 16bit幅にクリップ */
+    /* 差分を加えて16bit幅にクリップ */
+    predict = decoder->sample_val + MOI_NEXT_STATE_QDIFF(next_state);
     predict = MOI_INNER_VAL(predict, INT16_MIN, INT16_MAX);
 
     /* 計算結果の反映 */
     decoder->sample_val = (int16_t)predict;
-    decoder->stepsize_index = idx;
+    decoder->stepsize_index = MOI_NEXT_STATE_INDEX(next_state);
 
     return decoder->sample_val;
 }
@@ -277,6 +258,11 @@ static MOIError MOIDecoder_DecodeBlockMono(
     if (u8buf != 0) {
         return MOI_ERROR_INVALID_FORMAT;
     }
+    /* 範囲外のインデックスは次状態テーブルの範囲外を参照するので不正 */
+    if ((core_decoder->stepsize_index < 0)
+            || (core_decoder->stepsize_index >= (int8_t)MOI_IMAADPCM_STEPSIZE_TABLE_SIZE)) {
+        return MOI_ERROR_INVALID_FORMAT;
+    }
 
     /* 先頭サンプルはヘッダに入っている */
     buffer[0][0] = core_decoder->sample_val;
@@ -337,6 +323,11 @@ static MOIError MOIDecoder_DecodeBlockStereo(
         if (reserved != 0) {
             return MOI_ERROR_INVALID_FORMAT;
         }
+        /* 範囲外のインデックスは次状態テーブルの範囲外を参照するので不正 */
+        if ((core_decoder[ch].stepsize_index < 0)
+                || (core_decoder[ch].stepsize_index >= (int8_t)MOI_IMAADPCM_STEPSIZE_TABLE_SIZE)) {
+            return MOI_ERROR_INVALID_FORMAT;
+        }
     }
 
     /* 最初のサンプルの取得 */
@@ -1,12 +1,45 @@
+/* clock_gettimeを使うためPOSIXの機能を有効にする */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
 #include "moi.h"
 
 #include <stdlib.h>
 #include <string.h>
-#include <float.h>
 
 #include "moi_internal.h"
 #include "byte_array.h"
 
+/* スレッド */
+#if defined(MOI_WITHOUT_THREADS)
+/* スレッドを使わない: 呼び出し元で逐次実行 */
+#elif defined(_WIN32)
+#include <windows.h>
+typedef HANDLE MOIThread;
+#else
+#include <pthread.h>
+typedef pthread_t MOIThread;
+#endif
+
+/* 時刻計測（時間予算の管理に使用） */
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* SIMD命令（コンパイラが対象命令セットを有効にしている場合のみ使用） */
+#if defined(MOI_WITHOUT_SIMD)
+/* SIMDを使わない: スカラ実装 */
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define MOIENCODER_USE_AVX2
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define MOIENCODER_USE_SSE41
+#endif
+
 /* エンコード時に書き出すヘッダサイズ（データブロック直前までのファイルサイズ） */
 #define MOIENCODER_HEADER_SIZE 60
 
@@ -17,36 +50,225 @@
 /* 符号語の個数 */
 #define MOIENCODER_NUM_CODES (1 << MOI_BITS_PER_SAMPLE)
 
+/* 符号選択記録の幅（1サンプルあたりの最大候補数） */
+#define MOIENCODER_TRACE_WIDTH MOI_MAX_VAL(MOI_MAX_SEARCH_BEAM_WIDTH, MOI_MAX_TRELLIS_NUM_STATES)
+
+/* 符号選択記録を保持するサンプル数（2の冪、リングバッファで使い回す） */
+#define MOIENCODER_TRACE_WINDOW_SIZE 1024
+
+/* 全候補の祖先が一致した符号を確定するサンプル間隔 */
+#define MOIENCODER_TRACE_COMMIT_INTERVAL 64
+
+/* 符号選択記録の参照（widthは1サンプルあたりの候補数） */
+#define MOIENCODER_TRACE_ENTRY(trace, smpl, width, index)\
+    (&(trace)[((smpl) & (MOIENCODER_TRACE_WINDOW_SIZE - 1)) * (width) + (index)])
+
+/* トレリス探索で保持する最大状態数（初期状態は全ステップサイズインデックス） */
+#define MOITRELLIS_MAX_NUM_STATES MOI_MAX_VAL(MOI_MAX_TRELLIS_NUM_STATES, MOI_IMAADPCM_STEPSIZE_TABLE_SIZE)
+
+/* 1サンプルあたりに展開する最大状態数 */
+#define MOIENCODER_MAX_NUM_EXPANSIONS \
+    (MOI_MAX_VAL(MOITRELLIS_MAX_NUM_STATES, MOI_MAX_SEARCH_BEAM_WIDTH) * (MOIENCODER_NUM_CODES / 2))
+
+/* 状態併合用ハッシュテーブルサイズ（2の冪） */
+#define MOIENCODER_STATE_HASH_TABLE_BITS 11
+#define MOIENCODER_STATE_HASH_TABLE_SIZE (1 << MOIENCODER_STATE_HASH_TABLE_BITS)
+
+/* トレリス探索の状態併合幅: ステップサイズの1/2^MOITRELLIS_MERGE_SHIFT以内のサンプル値は同一状態とみなす */
+#define MOITRELLIS_MERGE_SHIFT 4
+
+/* 先読み探索キャッシュに登録する最小の探索深さ（これより浅い探索は再計算の方が速い）
+* 32bit演算で探索する深さ（MOIENCODER_SATURATED_SEARCH_MAX_DEPTH以下）はキャッシュを参照する前に
+* 探索を終えるので、それより深くする */
+#define MOISEARCHCACHE_MIN_DEPTH 4
+
+/* 32bit飽和演算で先読みする最大の探索深さ */
+#define MOIENCODER_SATURATED_SEARCH_MAX_DEPTH 3
+
+/* 残りコストの下限による枝刈りを行う最小の探索深さ（浅い探索は下限計算の方が高コスト） */
+#define MOIENCODER_LOWER_BOUND_MIN_DEPTH 3
+
+/* 局所探索で符号を変更した後、元の符号列の状態に戻るまで補修する最大サンプル数 */
+#define MOIENCODER_LOCAL_SEARCH_HORIZON 32
+
+/* 親の先読みスコアで展開先の探索を省略する最小の探索深さ（浅い探索は並べ替えの方が高コスト） */
+#define MOIENCODER_SKIP_EXPANSION_MIN_DEPTH 4
+
+/* 適応探索: IMA-ADPCM符号化の平均二乗誤差のビット長がこの範囲で、探索幅・深さを最小から最大へ線形に増やす */
+#define MOIENCODER_ADAPTIVE_MIN_COST_BITS 4
+#define MOIENCODER_ADAPTIVE_MAX_COST_BITS 20
+
+/* 探索の労力の段階数（0で最小、最大で指定の探索幅・深さ） */
+#define MOIENCODER_NUM_EFFORT_LEVELS (MOIENCODER_ADAPTIVE_MAX_COST_BITS - MOIENCODER_ADAPTIVE_MIN_COST_BITS)
+
+/* 時間予算: 期限を確認するサンプル間隔 */
+#define MOIENCODER_DEADLINE_CHECK_INTERVAL 16
+
+/* 初期ステップサイズインデックスを直前ブロックから絞り込む場合の、連続して処理するブロック数
+* セグメントの先頭ブロックは全探索するので、スレッド数に依らず出力は一致する */
+#define MOIENCODER_SEGMENT_NUM_BLOCKS 8
+
+/* 探索を省略する定数区間の最小サンプル数 */
+#define MOIENCODER_CONSTANT_RUN_MIN_LENGTH 32
+
+/* 2パス符号化: 参照誤差のヒストグラムの階級（誤差のビット長毎に2^MOIENCODER_REFINE_FRACTION_BITS等分） */
+#define MOIENCODER_REFINE_FRACTION_BITS 3
+#define MOIENCODER_REFINE_NUM_BUCKETS (64 << MOIENCODER_REFINE_FRACTION_BITS)
+
+/* 2パス符号化を行うか */
+#define MOIENCODER_IS_TWO_PASS(parameter) (((parameter)->refine_percent > 0) || ((parameter)->refine_threshold > 0))
+
+/* コストの最大値 */
+#define MOICOST_MAX INT64_MAX
+
 /* 量子化誤差の計算 */
-#define MOICoreEncoder_CalculateQuantizedDiff(encoder, nibble) MOI_qdiff_table[(encoder)->stepsize_index][(nibble)]
+#define MOICoreEncoder_CalculateQuantizedDiff(encoder, nibble) MOI_QUANTIZED_DIFF((encoder)->stepsize_index, (nibble))
+
+/* コスト型（誤差の2乗和は整数なので整数で正確に計算） */
+typedef int64_t MOICost;
 
 /* コア処理エンコーダ */
 struct MOICoreEncoder {
     int16_t prev_sample; /* サンプル値 */
     int8_t stepsize_index; /* ステップサイズテーブルの参照インデックス */
-    double total_cost; /* これまでのコスト */
+    MOICost total_cost; /* これまでのコスト */
 };
 
-/* エンコーダ候補 */
-struct MOICoreEncoderCandidate {
-    int8_t init_stepsize_index;
-    struct MOICoreEncoder encoder;
-    uint8_t *code;
+/* エンコーダ候補の集合（候補毎の要素を別々の配列に連続配置し、一括更新をしやすくする） */
+struct MOICoreEncoderCandidates {
+    int16_t prev_sample[MOIENCODER_MAX_NUM_EXPANSIONS]; /* サンプル値 */
+    int8_t stepsize_index[MOIENCODER_MAX_NUM_EXPANSIONS]; /* ステップサイズテーブルの参照インデックス */
+    int8_t init_stepsize_index[MOIENCODER_MAX_NUM_EXPANSIONS]; /* ブロック先頭のステップサイズインデックス */
+    MOICost total_cost[MOIENCODER_MAX_NUM_EXPANSIONS]; /* これまでのコスト */
+    MOICost lookahead_score[MOIENCODER_MAX_NUM_EXPANSIONS]; /* 選択時の先読みスコア（次のサンプルでの子のスコアの下限） */
+};
+
+/* 全候補を1サンプル展開した状態（候補iから符号の絶対値absで遷移した状態はi * 8 + abs番目） */
+struct MOICoreEncoderChildren {
+    int32_t prev_sample[MOIENCODER_MAX_NUM_EXPANSIONS]; /* サンプル値 */
+    int32_t abs_err[MOIENCODER_MAX_NUM_EXPANSIONS]; /* 予測誤差の絶対値 */
+    int8_t stepsize_index[MOIENCODER_MAX_NUM_EXPANSIONS]; /* ステップサイズテーブルの参照インデックス */
+    MOICost total_cost[MOIENCODER_MAX_NUM_EXPANSIONS]; /* これまでのコスト */
+    uint8_t sign[MOITRELLIS_MAX_NUM_STATES]; /* 展開元候補毎の符号ビット */
+};
+
+/* 符号選択の記録（ブロック末尾でトレースバックして符号列を復元） */
+struct MOICoreEncoderTrace {
+    uint8_t parent; /* 直前サンプルでの候補インデックス */
+    uint8_t nibble; /* 選択した符号 */
+};
+
+/* 状態併合用ハッシュテーブルエントリ */
+struct MOIStateHashEntry {
+    uint32_t key; /* 状態のキー */
+    uint32_t stamp; /* 登録時のスタンプ（現在のスタンプと異なれば空きとみなす） */
+    uint32_t index; /* 展開先状態のインデックス */
+};
+
+/* 先読み探索キャッシュエントリ */
+struct MOISearchCacheEntry {
+    MOICost future_cost; /* 先読みで加算されるコスト（exactが0の場合は下限値） */
+    uint32_t key; /* 状態のキー */
+    uint32_t stamp; /* 登録時のスタンプ（現在のスタンプと異なれば空きとみなす） */
+    uint32_t position; /* ブロック内のサンプル位置 */
+    uint8_t depth; /* 残り探索深さ */
+    uint8_t exact; /* future_costが正確な値か否か */
+};
+
+/* 先読み探索キャッシュ（置換表） */
+struct MOISearchCache {
+    struct MOISearchCacheEntry *entry; /* エントリ配列（NULLの場合はキャッシュ無効） */
+    uint32_t num_entries; /* エントリ数（2の冪） */
+    uint32_t stamp; /* 現在のスタンプ */
+    const int16_t *sample_base; /* ブロック先頭サンプル（サンプル位置の計算に使用） */
+};
+
+/* ブロックキャッシュエントリ */
+struct MOIBlockCacheEntry {
+    uint32_t hash; /* ブロックのハッシュ値 */
+    uint32_t stamp; /* 登録時のスタンプ（現在のスタンプと異なれば空きとみなす） */
+    uint32_t num_samples; /* チャンネルあたりサンプル数 */
+    uint16_t num_channels; /* チャンネル数 */
+    uint8_t reference_only; /* IMA-ADPCMで符号化したブロックか */
+    int8_t init_seed[MOI_MAX_NUM_CHANNELS]; /* 初期ステップサイズインデックスの探索の中心（負で全探索） */
+    int8_t init_stepsize_index[MOI_MAX_NUM_CHANNELS]; /* 初期ステップサイズインデックス */
+};
+
+/* ブロックキャッシュ（同一内容のブロックの探索結果を再利用） */
+struct MOIBlockCache {
+    struct MOIBlockCacheEntry *entry; /* エントリ配列（NULLの場合はキャッシュ無効） */
+    int16_t *sample; /* エントリ毎のサンプル（一致の確認用） [エントリ][チャンネル][サンプル] */
+    uint8_t *code; /* エントリ毎の符号列 [エントリ][チャンネル][サンプル] */
+    uint32_t num_entries; /* エントリ数（2の冪） */
+    uint32_t slot_size; /* エントリあたりのサンプル・符号の領域（全チャンネル合計のサンプル数） */
+    uint32_t stamp; /* 現在のスタンプ */
+};
+
+/* 先読み探索の設定 */
+struct MOISearchContext {
+    struct MOISearchCache *cache; /* 先読み探索キャッシュ */
+    struct MOIEncodeStatistics *statistics; /* 統計情報の記録先 */
+    uint8_t use_lower_bound; /* 残りコストの下限による枝刈りを行うか */
 };
 
 /* エンコーダ */
 struct MOIEncoder {
     struct MOIEncodeParameter encode_parameter;
+    uint32_t search_beam_width; /* 現在のブロックで使う探索ビーム幅 */
+    uint32_t search_depth; /* 現在のブロックで使う探索深さ */
+    uint32_t budget_effort; /* 時間予算から決めた探索の労力（0からMOIENCODER_NUM_EFFORT_LEVELS） */
+    uint64_t deadline; /* 現在のチャンネルの探索期限[us]（0で無制限） */
+    MOICost cost_bound; /* 最小の部分コストがこれに達したら探索を打ち切る（MOICOST_MAXで無効） */
+    uint8_t search_aborted; /* 部分コストにより探索を打ち切ったか */
+    MOICost search_cost; /* 直前の探索で選んだ符号列の合計コスト（打ち切った場合は不定） */
+    uint8_t reference_only; /* 現在のブロックを探索せずIMA-ADPCMで符号化するか */
+    int32_t init_seed; /* 現在のチャンネルの初期ステップサイズインデックスの探索の中心（負で全探索） */
+    int8_t last_stepsize_index[MOI_MAX_NUM_CHANNELS]; /* 直前ブロック末尾のステップサイズインデックス（負で無効） */
     uint16_t max_block_size;
     uint8_t set_parameter;
     uint8_t *best_code[MOI_MAX_NUM_CHANNELS];
     int8_t best_init_stepsize_index[MOI_MAX_NUM_CHANNELS];
-    struct MOICoreEncoderCandidate candidate[MOI_MAX_SEARCH_BEAM_WIDTH];
-    struct MOICoreEncoderCandidate backup[MOI_MAX_SEARCH_BEAM_WIDTH];
-    struct MOICoreEncoderCandidate default_candidate;
+    struct MOICoreEncoder *local_search_state; /* 局所探索: 各サンプルを符号化する直前の状態 */
+    uint8_t *portfolio_code; /* ポートフォリオ符号化: 2つ目以降の設定の符号列 */
+    struct MOICoreEncoderCandidates candidate; /* ビーム探索の候補 */
+    struct MOICoreEncoder default_encoder; /* デフォルト候補（IMA-ADPCMの符号化） */
+    int8_t default_init_stepsize_index; /* デフォルト候補の初期ステップサイズインデックス */
+    uint8_t *default_code; /* デフォルト候補の符号列 */
+    struct MOICoreEncoderTrace *trace; /* 候補の符号選択記録 [サンプル（リングバッファ）][候補] */
+    struct MOICoreEncoderCandidates trellis_state; /* トレリス探索の状態 */
+    struct MOICoreEncoderCandidates expansion; /* 展開先状態 */
+    struct MOICoreEncoderChildren children; /* 候補を展開した状態（併合前） */
+    struct MOICoreEncoderTrace expansion_trace[MOIENCODER_MAX_NUM_EXPANSIONS]; /* 展開先状態への遷移 */
+    MOICost expansion_score[MOIENCODER_MAX_NUM_EXPANSIONS]; /* 展開先状態のスコア */
+    uint32_t selected_index[MOIENCODER_TRACE_WIDTH]; /* 上位選択した展開先のインデックス */
+    uint32_t expansion_order[MOIENCODER_MAX_NUM_EXPANSIONS]; /* 展開先の先読み順序 */
+    struct MOIStateHashEntry state_hash[MOIENCODER_STATE_HASH_TABLE_SIZE]; /* 状態併合用ハッシュテーブル */
+    uint32_t state_hash_stamp; /* ハッシュテーブルのスタンプ */
+    struct MOISearchCache search_cache; /* 先読み探索キャッシュ */
+    struct MOIBlockCache block_cache; /* ブロックキャッシュ */
+    struct MOIEncodeStatistics statistics; /* 統計情報 */
+    uint32_t max_num_threads;
+    struct MOIEncoder **thread_encoder; /* スレッド毎のエンコーダ（先頭は自分自身） */
     void *work;
 };
 
+/* 複数ブロックエンコードスレッドの引数 */
+struct MOIEncodeBlocksThreadArgument {
+    struct MOIEncoder *encoder; /* 使用するエンコーダ */
+    const int16_t *const *input; /* 入力サンプル */
+    uint32_t num_samples; /* 入力サンプル数 */
+    const struct IMAADPCMWAVHeader *header; /* ヘッダ */
+    uint8_t *data; /* 出力先（データブロック先頭） */
+    uint32_t data_size; /* 出力先サイズ */
+    uint32_t start_segment; /* 最初にエンコードするセグメント番号 */
+    uint32_t segment_stride; /* エンコードするセグメント番号の間隔 */
+    uint32_t segment_num_blocks; /* セグメントあたりのブロック数（セグメント内のブロックは順にエンコード） */
+    uint32_t refine_min_bucket; /* 2パス符号化: 参照誤差の階級がこれ以上のブロックを探索する */
+    uint8_t reference_cost_stored; /* 2パス符号化: 1パス目の参照誤差が各ブロックの出力先に置かれているか */
+    uint32_t output_size; /* 書き出したサイズ */
+    MOIApiResult result; /* 処理結果 */
+};
+
 /* ヘッダエンコード */
 MOIApiResult MOIEncoder_EncodeHeader(
         const struct IMAADPCMWAVHeader *header, uint8_t *data, uint32_t data_size)
@@ -148,29 +370,147 @@ MOIApiResult MOIEncoder_EncodeHeader(
     return MOI_APIRESULT_OK;
 }
 
+/* 先読み探索キャッシュのエントリ数（2の冪）を計算 0ならばキャッシュ無効 */
+static uint32_t MOIEncoder_CalculateSearchCacheNumEntries(uint32_t cache_size)
+{
+    uint32_t num_entries;
+
+    /* 1エントリも確保できなければ無効 */
+    if (cache_size < sizeof(struct MOISearchCacheEntry)) {
+        return 0;
+    }
+
+    /* サイズに収まる最大の2の冪 */
+    num_entries = 1;
+    while ((2 * num_entries * sizeof(struct MOISearchCacheEntry)) <= cache_size) {
+        num_entries *= 2;
+    }
+
+    return num_entries;
+}
+
+/* ブロックキャッシュのエントリあたりのサンプル数（全チャンネル合計）
+* 1バイトあたり2サンプル入りうるので、最大ブロックサイズの2倍 */
+#define MOIBLOCKCACHE_SLOT_SIZE(max_block_size) (2 * (uint32_t)(max_block_size))
+
+/* ブロックキャッシュのエントリあたりのサイズ[byte] */
+#define MOIBLOCKCACHE_ENTRY_SIZE(max_block_size)\
+    (sizeof(struct MOIBlockCacheEntry) + (sizeof(int16_t) + sizeof(uint8_t)) * MOIBLOCKCACHE_SLOT_SIZE(max_block_size))
+
+/* ブロックキャッシュのエントリ数を計算 */
+static uint32_t MOIEncoder_CalculateBlockCacheNumEntries(uint32_t cache_size, uint16_t max_block_size)
+{
+    uint32_t num_entries;
+
+    /* 1エントリも確保できなければ無効 */
+    if (cache_size < MOIBLOCKCACHE_ENTRY_SIZE(max_block_size)) {
+        return 0;
+    }
+
+    /* サイズに収まる最大の2の冪 */
+    num_entries = 1;
+    while ((2 * num_entries * MOIBLOCKCACHE_ENTRY_SIZE(max_block_size)) <= cache_size) {
+        num_entries *= 2;
+    }
+
+    return num_entries;
+}
+
+/* 直前ブロックの情報を無効化（次のブロックは初期ステップサイズインデックスを全探索） */
+static void MOIEncoder_ResetInitSeed(struct MOIEncoder *encoder)
+{
+    uint32_t ch;
+
+    MOI_ASSERT(encoder != NULL);
+
+    encoder->init_seed = -1;
+    for (ch = 0; ch < MOI_MAX_NUM_CHANNELS; ch++) {
+        encoder->last_stepsize_index[ch] = -1;
+    }
+}
+
+/* エンコーダワークサイズ計算（64bit、コンフィグは検査済み）
+* スレッド数とブロックキャッシュを最大にすると32bitを越えるので64bitで積算する */
+static uint64_t MOIEncoder_CalculateWorkSize64(const struct MOIEncoderConfig *config)
+{
+    uint64_t work_size;
+
+    MOI_ASSERT(config != NULL);
+    MOI_ASSERT(config->max_num_threads > 0);
+
+    /* ハンドルサイズ */
+    work_size = MOI_ALIGNMENT + sizeof(struct MOIEncoder);
+
+    /* 符号領域 チャンネル数 + デフォルト候補分 + ポートフォリオ符号化分 */
+    /* 1バイトあたり2サンプル入りうるので2倍確保 */
+    work_size += (MOI_MAX_NUM_CHANNELS + 2) * (MOI_ALIGNMENT + (2 * (uint64_t)config->max_block_size));
+
+    /* 局所探索の状態領域 */
+    work_size += MOI_ALIGNMENT + sizeof(struct MOICoreEncoder) * (2 * (uint64_t)config->max_block_size + 1);
+
+    /* 候補の符号選択記録領域 */
+    work_size += MOI_ALIGNMENT + (uint64_t)sizeof(struct MOICoreEncoderTrace) * MOIENCODER_TRACE_WIDTH * MOIENCODER_TRACE_WINDOW_SIZE;
+
+    /* 先読み探索キャッシュ領域 */
+    {
+        const uint32_t num_entries = MOIEncoder_CalculateSearchCacheNumEntries(config->max_search_cache_size);
+        if (num_entries > 0) {
+            work_size += MOI_ALIGNMENT + (uint64_t)sizeof(struct MOISearchCacheEntry) * num_entries;
+        }
+    }
+
+    /* ブロックキャッシュ領域 */
+    {
+        const uint32_t num_entries
+            = MOIEncoder_CalculateBlockCacheNumEntries(config->max_block_cache_size, config->max_block_size);
+        if (num_entries > 0) {
+            work_size += 3 * MOI_ALIGNMENT + (uint64_t)MOIBLOCKCACHE_ENTRY_SIZE(config->max_block_size) * num_entries;
+        }
+    }
+
+    /* スレッド毎のエンコーダハンドル（先頭は自分自身を使うので1つ少なく確保） */
+    work_size += MOI_ALIGNMENT + (uint64_t)sizeof(struct MOIEncoder *) * config->max_num_threads;
+    if (config->max_num_threads > 1) {
+        struct MOIEncoderConfig thread_config = (*config);
+        thread_config.max_num_threads = 1;
+        work_size += (uint64_t)(config->max_num_threads - 1) * MOIEncoder_CalculateWorkSize64(&thread_config);
+    }
+
+    return work_size;
+}
+
 /* エンコーダワークサイズ計算 */
 int32_t MOIEncoder_CalculateWorkSize(const struct MOIEncoderConfig *config)
 {
-    int32_t work_size;
+    uint64_t work_size;
 
     /* 引数チェック */
     if (config == NULL) {
         return -1;
     }
 
+    /* 最大スレッド数0は1として扱う（スレッド数の指定が無かった頃のコンフィグとの互換のため） */
+    if (config->max_num_threads == 0) {
+        struct MOIEncoderConfig compat_config = (*config);
+        compat_config.max_num_threads = 1;
+        return MOIEncoder_CalculateWorkSize(&compat_config);
+    }
+
     /* コンフィグチェック */
-    if (config->max_block_size == 0) {
+    if ((config->max_block_size == 0)
+            || (config->max_num_threads > MOI_MAX_NUM_THREADS)
+            || (config->max_search_cache_size > MOI_MAX_SEARCH_CACHE_SIZE)
+            || (config->max_block_cache_size > MOI_MAX_BLOCK_CACHE_SIZE)) {
         return -1;
     }
 
-    /* ハンドルサイズ */
-    work_size = MOI_ALIGNMENT + sizeof(struct MOIEncoder);
-
-    /* 符号領域 チャンネル数 + 候補 + 候補バックアップ + デフォルト候補分 */
-    /* 1バイトあたり2サンプル入りうるので2倍確保 */
-    work_size += (MOI_MAX_NUM_CHANNELS + (2 * MOI_MAX_SEARCH_BEAM_WIDTH) + 1) * (MOI_ALIGNMENT + (2 * config->max_block_size));
+    /* ワークサイズはint32_tで返すので、表せないサイズのコンフィグは受け付けない */
+    work_size = MOIEncoder_CalculateWorkSize64(config);
+    if (work_size > INT32_MAX) {
+        return -1;
+    }
 
-    return work_size;
+    return (int32_t)work_size;
 }
 
 /* エンコーダハンドル作成 */
@@ -181,6 +521,13 @@ struct MOIEncoder *MOIEncoder_Create(
     uint8_t *work_ptr;
     uint32_t i, alloced_by_malloc = 0;
 
+    /* 最大スレッド数0は1として扱う（スレッド数の指定が無かった頃のコンフィグとの互換のため） */
+    if ((config != NULL) && (config->max_num_threads == 0)) {
+        struct MOIEncoderConfig compat_config = (*config);
+        compat_config.max_num_threads = 1;
+        return MOIEncoder_Create(&compat_config, work, work_size);
+    }
+
     /* 領域自前確保の場合 */
     if ((work == NULL) && (work_size == 0)) {
         if ((work_size = MOIEncoder_CalculateWorkSize(config)) < 0) {
@@ -190,14 +537,18 @@ struct MOIEncoder *MOIEncoder_Create(
         alloced_by_malloc = 1;
     }
 
-    /* 引数チェック */
+    /* 引数チェック（ワークサイズを計算できないコンフィグも弾く） */
     if ((config == NULL) || (work == NULL)
+            || (MOIEncoder_CalculateWorkSize(config) < 0)
             || (work_size < MOIEncoder_CalculateWorkSize(config))) {
         return NULL;
     }
 
     /* コンフィグチェック */
-    if (config->max_block_size == 0) {
+    if ((config->max_block_size == 0)
+            || (config->max_num_threads > MOI_MAX_NUM_THREADS)
+            || (config->max_search_cache_size > MOI_MAX_SEARCH_CACHE_SIZE)
+            || (config->max_block_cache_size > MOI_MAX_BLOCK_CACHE_SIZE)) {
         return NULL;
     }
 
@@ -211,27 +562,92 @@ struct MOIEncoder *MOIEncoder_Create(
     /* ハンドルの中身を0初期化 */
     memset(encoder, 0, sizeof(struct MOIEncoder));
 
-    /* 符号領域の割当て */
-    for (i = 0; i < MOI_MAX_SEARCH_BEAM_WIDTH; i++) {
-        work_ptr = (uint8_t *)MOI_ROUND_UP((uintptr_t)work_ptr, MOI_ALIGNMENT);
-        encoder->candidate[i].code = (uint8_t *)work_ptr;
-        work_ptr += 2 * config->max_block_size;
-        work_ptr = (uint8_t *)MOI_ROUND_UP((uintptr_t)work_ptr, MOI_ALIGNMENT);
-        encoder->backup[i].code = (uint8_t *)work_ptr;
-        work_ptr += 2 * config->max_block_size;
+    /* 符号選択記録領域の割当て */
+    work_ptr = (uint8_t *)MOI_ROUND_UP((uintptr_t)work_ptr, MOI_ALIGNMENT);
+    encoder->trace = (struct MOICoreEncoderTrace *)work_ptr;
+    work_ptr += sizeof(struct MOICoreEncoderTrace) * MOIENCODER_TRACE_WIDTH * MOIENCODER_TRACE_WINDOW_SIZE;
+
+    /* 先読み探索キャッシュ領域の割当て */
+    {
+        const uint32_t num_entries = MOIEncoder_CalculateSearchCacheNumEntries(config->max_search_cache_size);
+        if (num_entries > 0) {
+            work_ptr = (uint8_t *)MOI_ROUND_UP((uintptr_t)work_ptr, MOI_ALIGNMENT);
+            encoder->search_cache.entry = (struct MOISearchCacheEntry *)work_ptr;
+            encoder->search_cache.num_entries = num_entries;
+            memset(encoder->search_cache.entry, 0, sizeof(struct MOISearchCacheEntry) * num_entries);
+            work_ptr += sizeof(struct MOISearchCacheEntry) * num_entries;
+        }
+    }
+
+    /* ブロックキャッシュ領域の割当て */
+    {
+        const uint32_t num_entries
+            = MOIEncoder_CalculateBlockCacheNumEntries(config->max_block_cache_size, config->max_block_size);
+        if (num_entries > 0) {
+            struct MOIBlockCache *cache = &(encoder->block_cache);
+            cache->num_entries = num_entries;
+            cache->slot_size = MOIBLOCKCACHE_SLOT_SIZE(config->max_block_size);
+            work_ptr = (uint8_t *)MOI_ROUND_UP((uintptr_t)work_ptr, MOI_ALIGNMENT);
+            cache->entry = (struct MOIBlockCacheEntry *)work_ptr;
+            memset(cache->entry, 0, sizeof(struct MOIBlockCacheEntry) * num_entries);
+            work_ptr += sizeof(struct MOIBlockCacheEntry) * num_entries;
+            work_ptr = (uint8_t *)MOI_ROUND_UP((uintptr_t)work_ptr, MOI_ALIGNMENT);
+            cache->sample = (int16_t *)work_ptr;
+            work_ptr += sizeof(int16_t) * cache->slot_size * num_entries;
+            work_ptr = (uint8_t *)MOI_ROUND_UP((uintptr_t)work_ptr, MOI_ALIGNMENT);
+            cache->code = (uint8_t *)work_ptr;
+            work_ptr += sizeof(uint8_t) * cache->slot_size * num_entries;
+            cache->stamp = 1;
+        }
     }
+
+    /* 符号領域の割当て */
     work_ptr = (uint8_t*)MOI_ROUND_UP((uintptr_t)work_ptr, MOI_ALIGNMENT);
-    encoder->default_candidate.code = (uint8_t *)work_ptr;
+    encoder->default_code = (uint8_t *)work_ptr;
     work_ptr += 2 * config->max_block_size;
     for (i = 0; i < MOI_MAX_NUM_CHANNELS; i++) {
         work_ptr = (uint8_t *)MOI_ROUND_UP((uintptr_t)work_ptr, MOI_ALIGNMENT);
         encoder->best_code[i] = (uint8_t *)work_ptr;
         work_ptr += 2 * config->max_block_size;
     }
+    work_ptr = (uint8_t *)MOI_ROUND_UP((uintptr_t)work_ptr, MOI_ALIGNMENT);
+    encoder->portfolio_code = (uint8_t *)work_ptr;
+    work_ptr += 2 * config->max_block_size;
+
+    /* 局所探索の状態領域の割当て */
+    work_ptr = (uint8_t *)MOI_ROUND_UP((uintptr_t)work_ptr, MOI_ALIGNMENT);
+    encoder->local_search_state = (struct MOICoreEncoder *)work_ptr;
+    work_ptr += sizeof(struct MOICoreEncoder) * (2 * (uint32_t)config->max_block_size + 1);
+
+    /* スレッド毎のエンコーダハンドルの割当て */
+    work_ptr = (uint8_t *)MOI_ROUND_UP((uintptr_t)work_ptr, MOI_ALIGNMENT);
+    encoder->thread_encoder = (struct MOIEncoder **)work_ptr;
+    work_ptr += sizeof(struct MOIEncoder *) * config->max_num_threads;
+    encoder->thread_encoder[0] = encoder;
+    if (config->max_num_threads > 1) {
+        int32_t thread_work_size;
+        struct MOIEncoderConfig thread_config = (*config);
+        thread_config.max_num_threads = 1;
+        thread_work_size = MOIEncoder_CalculateWorkSize(&thread_config);
+        for (i = 1; i < config->max_num_threads; i++) {
+            encoder->thread_encoder[i] = MOIEncoder_Create(&thread_config, work_ptr, thread_work_size);
+            MOI_ASSERT(encoder->thread_encoder[i] != NULL);
+            work_ptr += thread_work_size;
+        }
+    }
+
+    /* 直前ブロックの情報は無効 */
+    MOIEncoder_ResetInitSeed(encoder);
+
+    /* 部分コストによる打ち切りは無効 */
+    encoder->cost_bound = MOICOST_MAX;
 
     /* 最大ブロックサイズの設定 */
     encoder->max_block_size = config->max_block_size;
 
+    /* 最大スレッド数の設定 */
+    encoder->max_num_threads = config->max_num_threads;
+
     /* パラメータは未セット状態に */
     encoder->set_parameter = 0;
 
@@ -256,10 +672,10 @@ void MOIEncoder_Destroy(struct MOIEncoder *encoder)
 }
 
 /* 符号語のコストを計算 */
-static double MOICoreEncoder_CalculateCost(
+static MOICost MOICoreEncoder_CalculateCost(
         const struct MOICoreEncoder *encoder, const int32_t sample, const uint8_t nibble)
 {
-    double err;
+    int32_t err;
 
     MOI_ASSERT(encoder != NULL);
     MOI_ASSERT(nibble < MOIENCODER_NUM_CODES);
@@ -271,6 +687,26 @@ static double MOICoreEncoder_CalculateCost(
     err += encoder->prev_sample - sample;
 
     /* 差の2乗をコストとする */
+    return (MOICost)err * err;
+}
+
+/* 符号語のコストを32bitで計算（INT32_MAXで飽和） */
+static int32_t MOICoreEncoder_CalculateCost32(
+        const struct MOICoreEncoder *encoder, const int32_t sample, const uint8_t nibble)
+{
+    int32_t err;
+
+    MOI_ASSERT(encoder != NULL);
+    MOI_ASSERT(nibble < MOIENCODER_NUM_CODES);
+
+    /* 量子化した差分により次の値を予測し、真のサンプルとの差をとる */
+    err = MOICoreEncoder_CalculateQuantizedDiff(encoder, nibble) + encoder->prev_sample - sample;
+
+    /* 2乗がINT32_MAXを越えるなら飽和 */
+    if ((err > 46340) || (err < -46340)) {
+        return INT32_MAX;
+    }
+
     return err * err;
 }
 
@@ -278,24 +714,23 @@ static double MOICoreEncoder_CalculateCost(
 static void MOICoreEncoder_Update(
         struct MOICoreEncoder *encoder, const int16_t sample, const uint8_t nibble)
 {
-    int32_t qdiff;
+    int32_t next_state, err;
 
     MOI_ASSERT(encoder != NULL);
     MOI_ASSERT(nibble < MOIENCODER_NUM_CODES);
 
-    /* 量子化した差分を計算 */
-    qdiff = MOICoreEncoder_CalculateQuantizedDiff(encoder, nibble);
+    /* 量子化した差分と次のインデックスを1回の参照で取得 */
+    next_state = MOI_next_state_table[encoder->stepsize_index][nibble];
+    err = MOI_NEXT_STATE_QDIFF(next_state) + encoder->prev_sample;
 
     /* 合計コストの更新 */
-    encoder->total_cost += MOICoreEncoder_CalculateCost(encoder, sample, nibble);
+    encoder->total_cost += (MOICost)(err - sample) * (err - sample);
 
     /* 直前サンプルの更新 */
-    encoder->prev_sample
-        = (int16_t)MOI_INNER_VAL(encoder->prev_sample + qdiff, INT16_MIN, INT16_MAX);
+    encoder->prev_sample = (int16_t)MOI_INNER_VAL(err, INT16_MIN, INT16_MAX);
 
     /* テーブルインデックスの更新 */
-    encoder->stepsize_index
-        = (int8_t)MOI_INNER_VAL(encoder->stepsize_index + IMAADPCM_index_table[nibble], 0, (int8_t)MOI_IMAADPCM_STEPSIZE_TABLE_SIZE - 1);
+    encoder->stepsize_index = MOI_NEXT_STATE_INDEX(next_state);
 }
 
 /* IMA-ADPCMの符号計算 */
@@ -338,255 +773,1682 @@ static uint8_t MOICoreEncoder_CalculateIMAADPCMNibble(
 #endif
 }
 
-/* 深さdepthでの最小スコア探索 */
-static double MOICoreEncoder_SearchMinScore(
-        const struct MOICoreEncoder *encoder, const int16_t *sample, uint32_t depth, double min)
+/* 状態のキーを計算 */
+static uint32_t MOICoreEncoder_CalculateStateKey(const struct MOICoreEncoder *encoder)
 {
-    uint8_t abs, killer_nibble;
-    double score, killer_cost;
-    struct MOICoreEncoder next;
-
     MOI_ASSERT(encoder != NULL);
-    MOI_ASSERT(sample != NULL);
-    MOI_ASSERT(depth <= MOI_MAX_SEARCH_DEPTH);
+    return ((uint32_t)encoder->stepsize_index << 16) | (uint32_t)(encoder->prev_sample - INT16_MIN);
+}
 
-    /* 先読みの打ち切り */
-    if (depth == 0) {
-        return encoder->total_cost;
-    }
+/* 先読み探索キャッシュを空にする（sample_baseはブロック先頭サンプル） */
+static void MOISearchCache_Clear(struct MOISearchCache *cache, const int16_t *sample_base)
+{
+    MOI_ASSERT(cache != NULL);
 
-    /* 先にIMA-ADPCMの符号とコストを計算
-    * 最も良い可能性が高いため、これ以降の枝刈り増加を期待 */
-    killer_nibble = MOICoreEncoder_CalculateIMAADPCMNibble(encoder, sample[0]);
-    killer_cost = encoder->total_cost + MOICoreEncoder_CalculateCost(encoder, sample[0], killer_nibble);
+    cache->sample_base = sample_base;
 
-    /* 深さ1の場合はIMA-ADPCMの符号が最善 */
-    if (depth == 1) {
-        return killer_cost;
+    if (cache->entry == NULL) {
+        return;
     }
 
-    /* 更新した時点のコストがこれまでの最小を越えていたら探索しない（コストはdepthに関して単調に増加するため） */
-    if (killer_cost < min) {
-        next = (*encoder);
-        MOICoreEncoder_Update(&next, sample[0], killer_nibble);
-        score = MOICoreEncoder_SearchMinScore(&next, sample + 1, depth - 1, min);
-        min = MOI_MIN_VAL(score, min);
+    /* スタンプ更新により全エントリを無効化 */
+    cache->stamp++;
+    if (cache->stamp == 0) {
+        memset(cache->entry, 0, sizeof(struct MOISearchCacheEntry) * cache->num_entries);
+        cache->stamp = 1;
     }
+}
 
-    /* 符号候補で探索 */
-    for (abs = 0; abs <= 0x7; abs++) {
-        const uint8_t nibble = (uint8_t)(abs | (killer_nibble & 0x8));
-        if (nibble != killer_nibble) {
-            if ((encoder->total_cost + MOICoreEncoder_CalculateCost(encoder, sample[0], nibble)) < min) {
-                next = (*encoder);
-                MOICoreEncoder_Update(&next, sample[0], nibble);
-                score = MOICoreEncoder_SearchMinScore(&next, sample + 1, depth - 1, min);
-                min = MOI_MIN_VAL(score, min);
-            }
-        }
-    }
+/* 先読み探索キャッシュの参照先エントリを取得 */
+static struct MOISearchCacheEntry *MOISearchCache_GetEntry(
+        const struct MOISearchCache *cache, uint32_t key, uint32_t position, uint32_t depth)
+{
+    uint32_t hash;
+
+    MOI_ASSERT((cache != NULL) && (cache->entry != NULL));
 
-    return min;
+    /* 状態・位置・深さを混ぜてハッシュ値を計算 */
+    hash = (key * 2654435761U) ^ ((position * MOI_MAX_SEARCH_DEPTH + depth) * 2246822519U);
+    hash ^= hash >> 15;
+
+    /* 直接写像（衝突時は上書き） */
+    return &(cache->entry[hash & (cache->num_entries - 1)]);
 }
 
-/* nibbleの評価値を計算 */
-static double MOICoreEncoder_EvaluateScore(
-        const struct MOICoreEncoder *encoder, const int16_t *sample, uint32_t depth, uint8_t nibble)
+#if defined(MOIENCODER_USE_AVX2) || defined(MOIENCODER_USE_SSE41)
+/* 予測誤差が負（sign == 0）/正（sign == 8）のレーンのマスクから誤差最小の符号の絶対値を求める
+* 予測誤差は符号の絶対値について狭義単調なので、マスクは先頭から連続する。
+* 誤差最小の符号は符号が反転する境界の前後いずれか（同値の場合は小さい方） */
+static int32_t MOICoreEncoder_ArgminFromSignMask(const int32_t *abs_err, uint32_t mask)
 {
-    struct MOICoreEncoder next = (*encoder);
+    static const uint8_t popcount_table[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+    const int32_t count = popcount_table[mask & 0xF] + popcount_table[(mask >> 4) & 0xF];
 
-    /* 評価対象のnibbleで更新 */
-    MOICoreEncoder_Update(&next, sample[0], nibble);
+    MOI_ASSERT(abs_err != NULL);
 
-    /* スコア評価 */
-    return MOICoreEncoder_SearchMinScore(&next, sample + 1, depth - 1, FLT_MAX);
+    if (count == 0) {
+        return 0;
+    } else if (count == MOIENCODER_NUM_CODES / 2) {
+        return MOIENCODER_NUM_CODES / 2 - 1;
+    }
+    return (abs_err[count - 1] <= abs_err[count]) ? (count - 1) : count;
 }
+#endif
 
-/* 小さい方から数えてk番目の要素を取得（配列は破壊される） */
-static double MOICoreEncoder_SelectTopK(double *data, uint32_t n, uint32_t k)
+/* 同一符号の各符号の予測誤差の絶対値を計算し、誤差最小の符号の絶対値を返す
+* next_sampleがNULLでなければ各符号で復号される（クリップ済みの）サンプル値も計算する */
+static int32_t MOICoreEncoder_CalculateAbsErrors(
+        const struct MOICoreEncoder *encoder, const int32_t sample, uint8_t sign,
+        int32_t *abs_err, int32_t *next_sample)
 {
-    uint32_t i, j, left, right;
-    double x, t;
+    /* 差分の絶対値の行を読み、符号ビットが立っていれば符号反転する（-x == (x ^ -1) + 1） */
+    const uint16_t *magnitude = MOI_qdiff_magnitude_table[encoder->stepsize_index];
+    const int32_t neg = -(int32_t)(sign >> 3);
+#if defined(MOIENCODER_USE_AVX2)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i vneg = _mm256_set1_epi32(neg);
+    const __m256i vqdiff = _mm256_sub_epi32(_mm256_xor_si256(
+                _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)magnitude)), vneg), vneg);
+    const __m256i verr = _mm256_add_epi32(vqdiff, _mm256_set1_epi32(encoder->prev_sample - sample));
+    const __m256i vmask = (sign == 0) ? _mm256_cmpgt_epi32(zero, verr) : _mm256_cmpgt_epi32(verr, zero);
+
+    MOI_ASSERT(abs_err != NULL);
+
+    _mm256_storeu_si256((__m256i *)abs_err, _mm256_abs_epi32(verr));
+    if (next_sample != NULL) {
+        __m256i vnext = _mm256_add_epi32(vqdiff, _mm256_set1_epi32(encoder->prev_sample));
+        vnext = _mm256_max_epi32(vnext, _mm256_set1_epi32(INT16_MIN));
+        vnext = _mm256_min_epi32(vnext, _mm256_set1_epi32(INT16_MAX));
+        _mm256_storeu_si256((__m256i *)next_sample, vnext);
+    }
+
+    return MOICoreEncoder_ArgminFromSignMask(abs_err,
+            (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(vmask)));
+#elif defined(MOIENCODER_USE_SSE41)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i voffset = _mm_set1_epi32(encoder->prev_sample - sample);
+    const __m128i vneg = _mm_set1_epi32(neg);
+    const __m128i vmagnitude = _mm_loadu_si128((const __m128i *)magnitude);
+    const __m128i vqdiff_lo = _mm_sub_epi32(_mm_xor_si128(_mm_cvtepu16_epi32(vmagnitude), vneg), vneg);
+    const __m128i vqdiff_hi = _mm_sub_epi32(_mm_xor_si128(_mm_cvtepu16_epi32(_mm_srli_si128(vmagnitude, 8)), vneg), vneg);
+    const __m128i verr_lo = _mm_add_epi32(vqdiff_lo, voffset);
+    const __m128i verr_hi = _mm_add_epi32(vqdiff_hi, voffset);
+    const __m128i vmask_lo = (sign == 0) ? _mm_cmplt_epi32(verr_lo, zero) : _mm_cmpgt_epi32(verr_lo, zero);
+    const __m128i vmask_hi = (sign == 0) ? _mm_cmplt_epi32(verr_hi, zero) : _mm_cmpgt_epi32(verr_hi, zero);
+
+    MOI_ASSERT(abs_err != NULL);
+
+    _mm_storeu_si128((__m128i *)&abs_err[0], _mm_abs_epi32(verr_lo));
+    _mm_storeu_si128((__m128i *)&abs_err[4], _mm_abs_epi32(verr_hi));
+    if (next_sample != NULL) {
+        const __m128i vprev = _mm_set1_epi32(encoder->prev_sample);
+        const __m128i vmin = _mm_set1_epi32(INT16_MIN), vmax = _mm_set1_epi32(INT16_MAX);
+        _mm_storeu_si128((__m128i *)&next_sample[0],
+                _mm_min_epi32(_mm_max_epi32(_mm_add_epi32(vqdiff_lo, vprev), vmin), vmax));
+        _mm_storeu_si128((__m128i *)&next_sample[4],
+                _mm_min_epi32(_mm_max_epi32(_mm_add_epi32(vqdiff_hi, vprev), vmin), vmax));
+    }
 
-    left = 0; right = n - 1;
-    while (left < right) {
-        x = data[k];  i = left;  j = right;
-        for ( ; ; ) {
-            while (data[i] < x) { i++; }
-            while (x < data[j]) { j--; }
-            if (i >= j) { break; }
-            t = data[i]; data[i] = data[j];  data[j] = t;
-            i++;  j--;
+    return MOICoreEncoder_ArgminFromSignMask(abs_err,
+            (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(vmask_lo))
+            | ((uint32_t)_mm_movemask_ps(_mm_castsi128_ps(vmask_hi)) << 4));
+#else
+    int32_t i, argmin, min;
+
+    MOI_ASSERT(encoder != NULL);
+    MOI_ASSERT(abs_err != NULL);
+
+    argmin = 0; min = INT32_MAX;
+    for (i = 0; i < MOIENCODER_NUM_CODES / 2; i++) {
+        const int32_t err = ((magnitude[i] ^ neg) - neg) + encoder->prev_sample - sample;
+        abs_err[i] = (err < 0) ? -err : err;
+        if (abs_err[i] < min) {
+            min = abs_err[i];
+            argmin = i;
+        }
+    }
+
+    if (next_sample != NULL) {
+        for (i = 0; i < MOIENCODER_NUM_CODES / 2; i++) {
+            next_sample[i] = MOI_INNER_VAL(encoder->prev_sample + ((magnitude[i] ^ neg) - neg), INT16_MIN, INT16_MAX);
         }
-        if (i <= k) { left = j + 1; }
-        if (k <= j) { right = i - 1; }
     }
 
-    return data[k];
+    return argmin;
+#endif
 }
 
-/* モノラルブロックのエンコード */
-static MOIError MOIEncoder_EncodeSamples(
-    struct MOIEncoder *encoder, const int16_t *input, uint32_t num_samples,
-    uint8_t *code_seq, int8_t *best_init_stepsize_index)
+/* 候補集合のi番目の状態を取得 */
+static void MOICoreEncoderCandidates_Get(
+        const struct MOICoreEncoderCandidates *candidates, uint32_t i, struct MOICoreEncoder *encoder)
 {
-#define HALF_NUM_CODES (MOIENCODER_NUM_CODES / 2)
-#define SCORE_SIZE MOI_MAX_VAL(MOI_MAX_SEARCH_BEAM_WIDTH * HALF_NUM_CODES, MOI_IMAADPCM_STEPSIZE_TABLE_SIZE)
-    uint32_t i, smpl, beam_width, depth;
-    double threshold;
-    double score[SCORE_SIZE];
-    double score_work[SCORE_SIZE];
-    struct MOICoreEncoderCandidate *candidate, *backup, *defalut_enc;
+    MOI_ASSERT(candidates != NULL);
+    MOI_ASSERT(encoder != NULL);
 
-    /* 引数チェック */
-    if ((encoder == NULL) || (input == NULL) || (code_seq == NULL) || (num_samples == 0)) {
-        return MOI_ERROR_INVALID_ARGUMENT;
+    encoder->prev_sample = candidates->prev_sample[i];
+    encoder->stepsize_index = candidates->stepsize_index[i];
+    encoder->total_cost = candidates->total_cost[i];
+}
+
+/* 候補集合間で1候補分コピー */
+static void MOICoreEncoderCandidates_Copy(
+        struct MOICoreEncoderCandidates *dst, uint32_t dst_index,
+        const struct MOICoreEncoderCandidates *src, uint32_t src_index)
+{
+    MOI_ASSERT(dst != NULL);
+    MOI_ASSERT(src != NULL);
+
+    dst->prev_sample[dst_index] = src->prev_sample[src_index];
+    dst->stepsize_index[dst_index] = src->stepsize_index[src_index];
+    dst->init_stepsize_index[dst_index] = src->init_stepsize_index[src_index];
+    dst->total_cost[dst_index] = src->total_cost[src_index];
+    dst->lookahead_score[dst_index] = src->lookahead_score[src_index];
+}
+
+/* 全候補について同一符号の全符号で1サンプル分更新した状態を一括で計算
+* 結果は各候補・各符号でMOICoreEncoder_Updateを呼んだものと一致する */
+static void MOICoreEncoder_ExpandCandidates(
+        const struct MOICoreEncoderCandidates *candidates, uint32_t num_candidates,
+        const int16_t sample, struct MOICoreEncoderChildren *children)
+{
+#define HALF_NUM_CODES (MOIENCODER_NUM_CODES / 2)
+    uint32_t i;
+
+    MOI_ASSERT(candidates != NULL);
+    MOI_ASSERT(children != NULL);
+    MOI_ASSERT(num_candidates <= MOITRELLIS_MAX_NUM_STATES);
+
+    /* 予測誤差と復号サンプル: 候補毎に8符号をまとめて計算 */
+    for (i = 0; i < num_candidates; i++) {
+        struct MOICoreEncoder encoder;
+        encoder.prev_sample = candidates->prev_sample[i];
+        encoder.stepsize_index = candidates->stepsize_index[i];
+        encoder.total_cost = 0;
+        children->sign[i] = ((sample - encoder.prev_sample) < 0) ? 8 : 0;
+        (void)MOICoreEncoder_CalculateAbsErrors(&encoder, sample, children->sign[i],
+                &children->abs_err[i * HALF_NUM_CODES], &children->prev_sample[i * HALF_NUM_CODES]);
     }
 
-    /* オート変数に受ける */
-    candidate = encoder->candidate;
-    backup = encoder->backup;
-    beam_width = encoder->encode_parameter.search_beam_width;
-    depth = encoder->encode_parameter.search_depth;
-    defalut_enc = &(encoder->default_candidate);
+    /* コストとインデックス: 全展開先を1ループで更新
+    * インデックスの変化量は符号の絶対値だけで決まるので符号ビットは参照しない
+    * 差分は量子化誤差の絶対値テーブルから得ているので、次状態テーブルは引かずに小さなインデックス変化量テーブルを使う */
+    for (i = 0; i < num_candidates * HALF_NUM_CODES; i++) {
+        const uint32_t parent = i / HALF_NUM_CODES;
+        children->total_cost[i]
+            = candidates->total_cost[parent] + (MOICost)children->abs_err[i] * children->abs_err[i];
+        children->stepsize_index[i] = (int8_t)MOI_INNER_VAL(
+                candidates->stepsize_index[parent] + IMAADPCM_index_table[i % HALF_NUM_CODES],
+                0, (int32_t)MOI_IMAADPCM_STEPSIZE_TABLE_SIZE - 1);
+    }
+#undef HALF_NUM_CODES
+}
 
-    MOI_ASSERT((beam_width > 0) && (beam_width <= MOI_MAX_SEARCH_BEAM_WIDTH));
-    MOI_ASSERT((depth > 0) && (depth <= MOI_MAX_SEARCH_DEPTH));
+/* 予測誤差が次に小さい符号の絶対値を取得
+* 予測誤差は符号の絶対値について単調なので、誤差最小の符号から両側へ広げれば昇順に取り出せる
+* lo, hiは初回呼び出し時に誤差最小の符号の絶対値, その+1とする */
+static int32_t MOICoreEncoder_GetNextNibble(const int32_t *abs_err, int32_t *lo, int32_t *hi)
+{
+    MOI_ASSERT((abs_err != NULL) && (lo != NULL) && (hi != NULL));
+    MOI_ASSERT(((*lo) >= 0) || ((*hi) < MOIENCODER_NUM_CODES / 2));
 
-    /* 初期ステップサイズインデックスの選択 */
-    {
-        struct MOICoreEncoder init;
+    if (((*hi) >= MOIENCODER_NUM_CODES / 2) || (((*lo) >= 0) && (abs_err[*lo] <= abs_err[*hi]))) {
+        return (*lo)--;
+    }
+    return (*hi)++;
+}
 
-        /* 各ステップサイズでスコア計算 */
-        init.prev_sample = input[0]; init.total_cost = 0.0;
-        for (i = 0; i < MOI_IMAADPCM_STEPSIZE_TABLE_SIZE; i++) {
-            init.stepsize_index = (int8_t)i;
-            score[i] = MOICoreEncoder_SearchMinScore(&init,
-                    input + 1, MOI_MIN_VAL(depth, num_samples - 1), FLT_MAX);
-        }
+/* 残りdepthサンプルで加算されるコストの下限を計算（bound以上になった時点で打ち切る）
+* 予測値はkステップでMOI_max_displacement_table以上動けないので、それより遠いサンプルとの誤差は避けられない */
+static MOICost MOICoreEncoder_CalculateLowerBound(
+        const struct MOICoreEncoder *encoder, const int16_t *sample, uint32_t depth, MOICost bound)
+{
+    uint32_t i;
+    MOICost lower_bound = 0;
+    const int32_t *max_displacement;
 
-        /* 上位選択の閾値 */
-        memcpy(score_work, score, sizeof(double) * MOI_IMAADPCM_STEPSIZE_TABLE_SIZE);
-        threshold = MOICoreEncoder_SelectTopK(score_work, MOI_IMAADPCM_STEPSIZE_TABLE_SIZE, beam_width);
+    MOI_ASSERT(encoder != NULL);
+    MOI_ASSERT(sample != NULL);
+    MOI_ASSERT(depth <= MOI_MAX_SEARCH_DEPTH);
 
-        /* 上位選択 */
-        {
-            uint32_t n = 0, argmin = beam_width;
-            double min = FLT_MAX;
-            for (i = 0; i < MOI_IMAADPCM_STEPSIZE_TABLE_SIZE; i++) {
-                if (score[i] <= threshold) {
-                    candidate[n].encoder.prev_sample = input[0];
-                    candidate[n].encoder.total_cost = 0.0;
-                    candidate[n].encoder.stepsize_index = (int8_t)i;
-                    candidate[n].init_stepsize_index = (int8_t)i;
-                    if (min > score[i]) {
-                        min = score[i];
-                        argmin = n;
-                    }
-                    n++;
-                    if (n == beam_width) {
-                        break;
-                    }
-                }
+    max_displacement = MOI_max_displacement_table[encoder->stepsize_index];
+    for (i = 0; i < depth; i++) {
+        const int32_t diff = sample[i] - encoder->prev_sample;
+        const int32_t err = ((diff < 0) ? -diff : diff) - max_displacement[i + 1];
+        if (err > 0) {
+            lower_bound += (MOICost)err * err;
+            if (lower_bound >= bound) {
+                break;
             }
-            MOI_ASSERT(n == beam_width);
-            MOI_ASSERT(argmin < beam_width);
-
-            /* デフォルト候補の初期化 */
-            defalut_enc->encoder = candidate[argmin].encoder;
-            defalut_enc->init_stepsize_index = candidate[argmin].init_stepsize_index;
         }
     }
 
-    /* ブロックデータエンコード */
-    for (smpl = 1; smpl < num_samples; smpl++) {
-        /* コスト計算 */
-        for (i = 0; i < beam_width; i++) {
-            const struct MOICoreEncoder *core = &(candidate[i].encoder);
-            const uint32_t init_depth = MOI_MIN_VAL(depth, num_samples - smpl);
-            const uint8_t sign = ((input[smpl] - core->prev_sample) < 0) ? 8 : 0;
-            uint8_t abs;
-            for (abs = 0; abs < HALF_NUM_CODES; abs++) {
-                /* 同一符号の中でコスト計算 */
-                score[i * HALF_NUM_CODES + abs]
-                    = MOICoreEncoder_EvaluateScore(core, &input[smpl], init_depth, abs | sign);
-            }
-        }
+    return lower_bound;
+}
 
-        /* 上位選択の閾値 */
-        memcpy(score_work, score, sizeof(double) * beam_width * HALF_NUM_CODES);
-        threshold = MOICoreEncoder_SelectTopK(score_work, beam_width * HALF_NUM_CODES, beam_width);
-        /* 最大値が小さい場合の対策 */
-        if (threshold < FLT_MIN) {
-            threshold = FLT_MIN;
-        }
+/* 深さ別の探索関数の型 */
+typedef MOICost (*MOISearchFunction)(
+        const struct MOICoreEncoder *encoder, const int16_t *sample, MOICost min,
+        struct MOISearchContext *context);
 
-        /* 上位選択 */
-        /* 符号列（状態遷移記録）と候補エンコーダのバックアップ */
-        for (i = 0; i < beam_width; i++) {
-            memcpy(backup[i].code, candidate[i].code, sizeof(uint8_t) * smpl);
-            backup[i].encoder = candidate[i].encoder;
-            backup[i].init_stepsize_index = candidate[i].init_stepsize_index;
-        }
-        /* 閾値未満のコストを持つエンコーダを次の候補に選択 */
-        {
-            uint32_t n = 0;
-            uint8_t abs;
-            for (i = 0; i < beam_width; i++) {
-                for (abs = 0; abs < HALF_NUM_CODES; abs++) {
-                    if (score[i * HALF_NUM_CODES + abs] <= threshold) {
-                        struct MOICoreEncoder entry = backup[i].encoder;
-                        const uint8_t nibble = ((input[smpl] - entry.prev_sample) < 0) ? (abs | 0x8) : abs;
-                        MOICoreEncoder_Update(&entry, input[smpl], nibble);
-                        candidate[n].encoder = entry;
-                        candidate[n].init_stepsize_index = backup[i].init_stepsize_index;
-                        memcpy(candidate[n].code, backup[i].code, sizeof(uint8_t) * smpl);
-                        candidate[n].code[smpl] = nibble;
-                        n++;
-                        if (n == beam_width) {
-                            goto SELECT_END;
-                        }
-                    }
-                }
-            }
-SELECT_END:
-            MOI_ASSERT(n == beam_width);
-        }
+/* 32bit飽和演算による深さ別の探索関数の型 */
+typedef int32_t (*MOISearch32Function)(
+        const struct MOICoreEncoder *encoder, const int16_t *sample, int32_t bound,
+        struct MOISearchContext *context);
 
-        /* デフォルト候補の符号作成 */
-        {
-            const uint8_t nibble = MOICoreEncoder_CalculateIMAADPCMNibble(&(defalut_enc->encoder), input[smpl]);
-            MOICoreEncoder_Update(&(defalut_enc->encoder), input[smpl], nibble);
-            defalut_enc->code[smpl] = nibble;
-        }
-    }
+/* 32bit飽和演算による深さ1での最小将来コスト探索: IMA-ADPCMの符号が最善 */
+static int32_t MOICoreEncoder_SearchMinFutureCost32_1(
+        const struct MOICoreEncoder *encoder, const int16_t *sample, int32_t bound,
+        struct MOISearchContext *context)
+{
+    MOI_ASSERT(encoder != NULL);
+    MOI_ASSERT(sample != NULL);
+    (void)bound;
+    (void)context;
+    return MOICoreEncoder_CalculateCost32(encoder, sample[0],
+            MOICoreEncoder_CalculateIMAADPCMNibble(encoder, sample[0]));
+}
 
-    {
-        /* 最小コストのインデックス探索 */
-        double min = FLT_MAX;
-        uint32_t best_index = beam_width;
-        for (i = 0; i < beam_width; i++) {
-            if (min > candidate[i].encoder.total_cost) {
-                min = candidate[i].encoder.total_cost;
-                best_index = i;
-            }
-        }
-        MOI_ASSERT(best_index < beam_width);
+/* 32bit飽和演算による深さdepthでの最小将来コスト探索関数の定義
+* 現在の状態から加算されるコストの最小値を返す（bound以上の部分木は探索しない）
+* 深さ毎に関数を生成し、子の探索はchild_depthの関数を直接呼ぶ（深さの判定は定数畳み込みで消える）
+* 飽和したコストはbound以上として枝刈りされるので、bound < INT32_MAXならば
+* 結果はMOICoreEncoder_SearchMinScoreの加算コスト（bound以上ならbound）と一致する */
+#define MOICOREENCODER_DEFINE_SEARCH32(kernel_depth, child_depth)                                       \
+static int32_t MOICoreEncoder_SearchMinFutureCost32_##kernel_depth(                                     \
+        const struct MOICoreEncoder *encoder, const int16_t *sample, int32_t bound,                     \
+        struct MOISearchContext *context)                                                               \
+{                                                                                                       \
+    uint32_t i;                                                                                         \
+    uint8_t sign;                                                                                       \
+    int32_t lo, hi, abs, cost, score;                                                                   \
+    int32_t abs_err[MOIENCODER_NUM_CODES / 2];                                                          \
+    struct MOICoreEncoder next;                                                                         \
+                                                                                                        \
+    MOI_ASSERT(encoder != NULL);                                                                        \
+    MOI_ASSERT(sample != NULL);                                                                         \
+    MOI_ASSERT(context != NULL);                                                                        \
+                                                                                                        \
+    /* 下限がboundに達していれば探索しても更新されない */                                                                    \
+    if (context->use_lower_bound && ((kernel_depth) >= MOIENCODER_LOWER_BOUND_MIN_DEPTH)                \
+            && (MOICoreEncoder_CalculateLowerBound(encoder, sample, (kernel_depth), bound) >= bound)) { \
+        context->statistics->search_num_bound_prunes++;                                                 \
+        return bound;                                                                                   \
+    }                                                                                                   \
+                                                                                                        \
+    /* 直後のコストが小さい符号から探索 */                                                                              \
+    sign = ((sample[0] - encoder->prev_sample) < 0) ? 8 : 0;                                            \
+    lo = MOICoreEncoder_CalculateAbsErrors(encoder, sample[0], sign, abs_err, NULL);                    \
+    hi = lo + 1;                                                                                        \
+    for (i = 0; i < MOIENCODER_NUM_CODES / 2; i++) {                                                    \
+        abs = MOICoreEncoder_GetNextNibble(abs_err, &lo, &hi);                                          \
+        cost = (abs_err[abs] > 46340) ? INT32_MAX : (abs_err[abs] * abs_err[abs]);                      \
+        /* 以降の符号のコストはこれ以上なので打ち切り */                                                                     \
+        if (cost >= bound) {                                                                            \
+            break;                                                                                      \
+        }                                                                                               \
+        next = (*encoder);                                                                              \
+        MOICoreEncoder_Update(&next, sample[0], (uint8_t)(abs | sign));                                 \
+        context->statistics->search_num_nodes++;                                                        \
+        score = MOICoreEncoder_SearchMinFutureCost32_##child_depth(                                     \
+                &next, sample + 1, bound - cost, context);                                              \
+        score = (score > INT32_MAX - cost) ? INT32_MAX : (cost + score);                                \
+        bound = MOI_MIN_VAL(score, bound);                                                              \
+    }                                                                                                   \
+                                                                                                        \
+    return bound;                                                                                       \
+}
 
-        /* デフォルト候補の方がコストが小さければそちらを使う */
-        if (defalut_enc->encoder.total_cost < candidate[best_index].encoder.total_cost) {
-            memcpy(code_seq, defalut_enc->code, sizeof(uint8_t) * num_samples);
-            (*best_init_stepsize_index) = defalut_enc->init_stepsize_index;
-        } else {
-            memcpy(code_seq, candidate[best_index].code, sizeof(uint8_t) * num_samples);
-            (*best_init_stepsize_index) = candidate[best_index].init_stepsize_index;
-        }
-    }
+MOICOREENCODER_DEFINE_SEARCH32(2, 1)
+MOICOREENCODER_DEFINE_SEARCH32(3, 2)
 
-    return MOI_ERROR_OK;
-#undef SCORE_SIZE
-#undef HALF_NUM_CODES
-}
+/* 32bit飽和演算による深さ別探索関数のディスパッチテーブル
+* 32bit演算はコストの上限がINT32_MAX未満の浅い探索でしか使わないので、
+* MOIENCODER_SATURATED_SEARCH_MAX_DEPTHまでの深さだけ定義 */
+static const MOISearch32Function MOICoreEncoder_search32_function_table[MOIENCODER_SATURATED_SEARCH_MAX_DEPTH + 1] = {
+    NULL,
+    MOICoreEncoder_SearchMinFutureCost32_1, MOICoreEncoder_SearchMinFutureCost32_2,
+    MOICoreEncoder_SearchMinFutureCost32_3,
+};
+
+/* 32bit飽和演算による深さdepthでの最小将来コスト探索 */
+static int32_t MOICoreEncoder_SearchMinFutureCost32(
+        const struct MOICoreEncoder *encoder, const int16_t *sample, uint32_t depth, int32_t bound,
+        struct MOISearchContext *context)
+{
+    /* 深さ別関数は深さ3まで定義 */
+    MOI_STATIC_ASSERT(MOIENCODER_SATURATED_SEARCH_MAX_DEPTH == 3);
+    MOI_ASSERT((depth > 0) && (depth <= MOIENCODER_SATURATED_SEARCH_MAX_DEPTH));
+    return MOICoreEncoder_search32_function_table[depth](encoder, sample, bound, context);
+}
+
+/* 深さ0での最小スコア探索: 先読みの打ち切り */
+static MOICost MOICoreEncoder_SearchMinScore_0(
+        const struct MOICoreEncoder *encoder, const int16_t *sample, MOICost min,
+        struct MOISearchContext *context)
+{
+    MOI_ASSERT(encoder != NULL);
+    (void)sample;
+    (void)min;
+    (void)context;
+    return encoder->total_cost;
+}
+
+/* 深さ1での最小スコア探索: IMA-ADPCMの符号が最善 */
+static MOICost MOICoreEncoder_SearchMinScore_1(
+        const struct MOICoreEncoder *encoder, const int16_t *sample, MOICost min,
+        struct MOISearchContext *context)
+{
+    MOI_ASSERT(encoder != NULL);
+    MOI_ASSERT(sample != NULL);
+    (void)min;
+    (void)context;
+    return encoder->total_cost + MOICoreEncoder_CalculateCost(encoder, sample[0],
+            MOICoreEncoder_CalculateIMAADPCMNibble(encoder, sample[0]));
+}
+
+/* 深さdepthでの最小スコア探索関数の定義
+* 深さ毎に関数を生成し、子の探索はchild_depthの関数を直接呼ぶ（深さの判定は定数畳み込みで消える） */
+#define MOICOREENCODER_DEFINE_SEARCH(kernel_depth, child_depth)                                         \
+static MOICost MOICoreEncoder_SearchMinScore_##kernel_depth(                                            \
+        const struct MOICoreEncoder *encoder, const int16_t *sample, MOICost min,                       \
+        struct MOISearchContext *context)                                                               \
+{                                                                                                       \
+    uint32_t i;                                                                                         \
+    uint8_t sign;                                                                                       \
+    int32_t lo, hi, abs;                                                                                \
+    int32_t abs_err[MOIENCODER_NUM_CODES / 2];                                                          \
+    MOICost score, cost, init_min;                                                                      \
+    struct MOICoreEncoder next;                                                                         \
+    struct MOISearchCache *cache;                                                                       \
+    struct MOIEncodeStatistics *statistics;                                                             \
+    struct MOISearchCacheEntry *entry = NULL;                                                           \
+    uint32_t key = 0, position = 0;                                                                     \
+                                                                                                        \
+    MOI_ASSERT(encoder != NULL);                                                                        \
+    MOI_ASSERT(sample != NULL);                                                                         \
+    MOI_ASSERT(context != NULL);                                                                        \
+                                                                                                        \
+    /* 浅い探索は32bit演算で行う                                                                        \
+    * 加算コストの上限がINT32_MAX未満ならば、飽和する部分木は上限以上なので                             \
+    * 必ず枝刈りされ、結果は64bit演算と一致する                                                         \
+    * 上限が無い場合は飽和した部分木同士が同点になるので64bit演算で探索する */                          \
+    if (((kernel_depth) <= MOIENCODER_SATURATED_SEARCH_MAX_DEPTH)                                       \
+            && ((min - encoder->total_cost) < INT32_MAX)) {                                             \
+        const MOICost bound = MOI_MAX_VAL(min - encoder->total_cost, 0);                                \
+        return encoder->total_cost                                                                      \
+            + MOICoreEncoder_SearchMinFutureCost32(encoder, sample, (kernel_depth), (int32_t)bound, context); \
+    }                                                                                                   \
+                                                                                                        \
+    cache = context->cache;                                                                             \
+    statistics = context->statistics;                                                                   \
+                                                                                                        \
+    /* 下限がこれまでの最小以上ならば探索しても更新されない */                                                                    \
+    if (context->use_lower_bound && ((kernel_depth) >= MOIENCODER_LOWER_BOUND_MIN_DEPTH)                \
+            && (MOICoreEncoder_CalculateLowerBound(encoder, sample, (kernel_depth), min - encoder->total_cost) \
+                >= (min - encoder->total_cost))) {                                                      \
+        statistics->search_num_bound_prunes++;                                                          \
+        return min;                                                                                     \
+    }                                                                                                   \
+                                                                                                        \
+    /* キャッシュの参照: 同じ位置・状態・深さの探索結果があれば再利用 */                                \
+    if ((cache->entry != NULL) && ((kernel_depth) >= MOISEARCHCACHE_MIN_DEPTH)) {                       \
+        key = MOICoreEncoder_CalculateStateKey(encoder);                                                \
+        position = (uint32_t)(sample - cache->sample_base);                                             \
+        entry = MOISearchCache_GetEntry(cache, key, position, (kernel_depth));                          \
+        if ((entry->stamp == cache->stamp) && (entry->key == key)                                       \
+                && (entry->position == position) && (entry->depth == (kernel_depth))) {                 \
+            /* 正確な値 */                                                                                  \
+            if (entry->exact) {                                                                         \
+                statistics->search_cache_hits++;                                                        \
+                return MOI_MIN_VAL(encoder->total_cost + entry->future_cost, min);                      \
+            }                                                                                           \
+            /* 下限値がこれまでの最小以上ならば探索しても更新されない */                                                           \
+            if (entry->future_cost >= (min - encoder->total_cost)) {                                    \
+                statistics->search_cache_hits++;                                                        \
+                return min;                                                                             \
+            }                                                                                           \
+        }                                                                                               \
+        statistics->search_cache_misses++;                                                              \
+    }                                                                                                   \
+                                                                                                        \
+    init_min = min;                                                                                     \
+                                                                                                        \
+    /* 直後のコストが小さい符号から探索し、早期に最小値を下げて枝刈りを増やす */                                                           \
+    sign = ((sample[0] - encoder->prev_sample) < 0) ? 8 : 0;                                            \
+    lo = MOICoreEncoder_CalculateAbsErrors(encoder, sample[0], sign, abs_err, NULL);                    \
+    hi = lo + 1;                                                                                        \
+    for (i = 0; i < MOIENCODER_NUM_CODES / 2; i++) {                                                    \
+        abs = MOICoreEncoder_GetNextNibble(abs_err, &lo, &hi);                                          \
+        cost = encoder->total_cost + (MOICost)abs_err[abs] * abs_err[abs];                              \
+        /* 更新した時点のコストがこれまでの最小を越えていたら探索しない                                                               \
+        * 以降の符号のコストはこれ以上なので打ち切り */                                                                      \
+        if (cost >= min) {                                                                              \
+            break;                                                                                      \
+        }                                                                                               \
+        next = (*encoder);                                                                              \
+        MOICoreEncoder_Update(&next, sample[0], (uint8_t)(abs | sign));                                 \
+        statistics->search_num_nodes++;                                                                 \
+        score = MOICoreEncoder_SearchMinScore_##child_depth(&next, sample + 1, min, context);           \
+        min = MOI_MIN_VAL(score, min);                                                                  \
+    }                                                                                                   \
+                                                                                                        \
+    /* キャッシュに登録                                                                                         \
+    * 初期の最小値を下回れば正確な最小値、そうでなければ（枝刈りで打ち切られたため）下限値 */                                                     \
+    if (entry != NULL) {                                                                                \
+        entry->future_cost = min - encoder->total_cost;                                                 \
+        entry->key = key;                                                                               \
+        entry->stamp = cache->stamp;                                                                    \
+        entry->position = position;                                                                     \
+        entry->depth = (uint8_t)(kernel_depth);                                                         \
+        entry->exact = (min < init_min) ? 1 : 0;                                                        \
+    }                                                                                                   \
+                                                                                                        \
+    return min;                                                                                         \
+}
+
+MOICOREENCODER_DEFINE_SEARCH(2, 1)
+MOICOREENCODER_DEFINE_SEARCH(3, 2)
+MOICOREENCODER_DEFINE_SEARCH(4, 3)
+MOICOREENCODER_DEFINE_SEARCH(5, 4)
+MOICOREENCODER_DEFINE_SEARCH(6, 5)
+MOICOREENCODER_DEFINE_SEARCH(7, 6)
+MOICOREENCODER_DEFINE_SEARCH(8, 7)
+
+/* 深さ別探索関数のディスパッチテーブル */
+static const MOISearchFunction MOICoreEncoder_search_function_table[MOI_MAX_SEARCH_DEPTH + 1] = {
+    MOICoreEncoder_SearchMinScore_0,
+    MOICoreEncoder_SearchMinScore_1, MOICoreEncoder_SearchMinScore_2,
+    MOICoreEncoder_SearchMinScore_3, MOICoreEncoder_SearchMinScore_4,
+    MOICoreEncoder_SearchMinScore_5, MOICoreEncoder_SearchMinScore_6,
+    MOICoreEncoder_SearchMinScore_7, MOICoreEncoder_SearchMinScore_8,
+};
+
+/* 深さdepthでの最小スコア探索 */
+static MOICost MOICoreEncoder_SearchMinScore(
+        const struct MOICoreEncoder *encoder, const int16_t *sample, uint32_t depth, MOICost min,
+        struct MOISearchContext *context)
+{
+    /* 深さ別関数は最大深さ8まで定義 */
+    MOI_STATIC_ASSERT(MOI_MAX_SEARCH_DEPTH == 8);
+    /* 32bit演算で探索する深さはキャッシュを参照しない */
+    MOI_STATIC_ASSERT(MOISEARCHCACHE_MIN_DEPTH > MOIENCODER_SATURATED_SEARCH_MAX_DEPTH);
+    MOI_ASSERT(depth <= MOI_MAX_SEARCH_DEPTH);
+    return MOICoreEncoder_search_function_table[depth](encoder, sample, min, context);
+}
+
+/* スコアの順序比較: スコアが同じ場合はインデックスが小さい方を優先 */
+#define MOICoreEncoder_IsWorseScore(score, a, b) \
+    (((score)[a] > (score)[b]) || (((score)[a] == (score)[b]) && ((a) > (b))))
+
+/* スコアが小さい順にk個のインデックスを選択し、インデックスの昇順でselectedに格納
+* 同点の場合はインデックスが小さい方を選ぶので結果は入力順だけで決まる */
+static void MOICoreEncoder_SelectTopKIndices(
+        const MOICost *score, uint32_t n, uint32_t k, uint32_t *selected)
+{
+    uint32_t i, j;
+
+    MOI_ASSERT(score != NULL);
+    MOI_ASSERT(selected != NULL);
+    MOI_ASSERT((k > 0) && (k <= n));
+
+    /* 先頭k個で最大ヒープ（根が最も悪い候補）を構築 */
+    for (i = 0; i < k; i++) {
+        j = i;
+        while (j > 0) {
+            const uint32_t parent = (j - 1) / 2;
+            if (!MOICoreEncoder_IsWorseScore(score, i, selected[parent])) {
+                break;
+            }
+            selected[j] = selected[parent];
+            j = parent;
+        }
+        selected[j] = i;
+    }
+
+    /* 残りは根より良い場合のみ入れ替え
+    * 後から来る要素はインデックスが大きいので、同点なら根を優先して捨てる */
+    for (i = k; i < n; i++) {
+        if (score[i] >= score[selected[0]]) {
+            continue;
+        }
+        j = 0;
+        for (;;) {
+            uint32_t child = 2 * j + 1;
+            if (child >= k) {
+                break;
+            }
+            if (((child + 1) < k) && MOICoreEncoder_IsWorseScore(score, selected[child + 1], selected[child])) {
+                child++;
+            }
+            if (!MOICoreEncoder_IsWorseScore(score, selected[child], i)) {
+                break;
+            }
+            selected[j] = selected[child];
+            j = child;
+        }
+        selected[j] = i;
+    }
+
+    /* 候補の並びを入力順に保つためインデックスの昇順に整列（kは小さいので挿入ソート） */
+    for (i = 1; i < k; i++) {
+        const uint32_t index = selected[i];
+        for (j = i; (j > 0) && (selected[j - 1] > index); j--) {
+            selected[j] = selected[j - 1];
+        }
+        selected[j] = index;
+    }
+}
+
+#undef MOICoreEncoder_IsWorseScore
+
+/* 状態併合用ハッシュテーブルを空にする */
+static void MOIEncoder_ClearStateHash(struct MOIEncoder *encoder)
+{
+    MOI_ASSERT(encoder != NULL);
+
+    /* スタンプ更新により全エントリを無効化 */
+    encoder->state_hash_stamp++;
+    if (encoder->state_hash_stamp == 0) {
+        memset(encoder->state_hash, 0, sizeof(struct MOIStateHashEntry) * MOIENCODER_STATE_HASH_TABLE_SIZE);
+        encoder->state_hash_stamp = 1;
+    }
+}
+
+/* 状態併合用ハッシュテーブルを探索 登録済みなら1を返し、未登録ならnew_indexで登録して0を返す */
+static uint8_t MOIEncoder_FindOrInsertState(
+        struct MOIEncoder *encoder, uint32_t key, uint32_t new_index, uint32_t *index)
+{
+    uint32_t pos;
+    struct MOIStateHashEntry *hash;
+
+    MOI_ASSERT((encoder != NULL) && (index != NULL));
+
+    hash = encoder->state_hash;
+
+    /* 開番地法で探索 */
+    pos = (uint32_t)(key * 2654435761U) >> (32 - MOIENCODER_STATE_HASH_TABLE_BITS);
+    while ((hash[pos].stamp == encoder->state_hash_stamp) && (hash[pos].key != key)) {
+        pos = (pos + 1) & (MOIENCODER_STATE_HASH_TABLE_SIZE - 1);
+    }
+
+    /* 登録済み */
+    if (hash[pos].stamp == encoder->state_hash_stamp) {
+        (*index) = hash[pos].index;
+        return 1;
+    }
+
+    /* 新規登録 */
+    hash[pos].key = key;
+    hash[pos].stamp = encoder->state_hash_stamp;
+    hash[pos].index = new_index;
+    (*index) = new_index;
+    return 0;
+}
+
+/* 現在時刻[us]を取得（時間予算の管理用で、差分のみ意味を持つ） */
+static uint64_t MOIEncoder_GetTimeMicroseconds(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000
+        + (uint64_t)((counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart);
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+#else
+    /* 単調時計が無い環境ではプロセスのCPU時間で代用 */
+    return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+/* 符号選択記録から確定した符号列を書き出す
+* smplでindex番目の候補の祖先を辿り、smplからend_smplまで（降順）の符号をcode_seqに書く */
+static void MOIEncoder_TraceBackCodes(
+        const struct MOICoreEncoderTrace *trace, uint32_t width,
+        uint32_t smpl, uint32_t index, uint32_t end_smpl, uint8_t *code_seq)
+{
+    MOI_ASSERT(trace != NULL);
+    MOI_ASSERT(code_seq != NULL);
+    MOI_ASSERT(end_smpl > 0);
+
+    for (; smpl >= end_smpl; smpl--) {
+        const struct MOICoreEncoderTrace *entry = MOIENCODER_TRACE_ENTRY(trace, smpl, width, index);
+        code_seq[smpl] = entry->nibble;
+        index = entry->parent;
+    }
+}
+
+/* 全候補の祖先が一致した位置までの符号を確定
+* latestは記録済みの最新サンプル、(*committed)は未確定の先頭サンプルで、確定した分だけ進める
+* 記録の窓が溢れそうな場合は最小コストの候補の祖先で確定し、その子孫でない候補を除いた候補数を返す */
+static uint32_t MOIEncoder_CommitConvergedCodes(
+        struct MOICoreEncoderTrace *trace, uint32_t width, uint32_t latest, uint32_t *committed,
+        struct MOICoreEncoderCandidates *candidates, uint32_t num_candidates, uint8_t *code_seq,
+        struct MOIEncodeStatistics *statistics)
+{
+    uint32_t i, smpl, mask;
+
+    MOI_STATIC_ASSERT(MOIENCODER_TRACE_WIDTH <= 32);
+    MOI_ASSERT((trace != NULL) && (committed != NULL));
+    MOI_ASSERT((candidates != NULL) && (code_seq != NULL) && (statistics != NULL));
+    MOI_ASSERT((num_candidates > 0) && (num_candidates <= width));
+    MOI_ASSERT(latest >= (*committed));
+
+    /* 生存候補の祖先の集合を遡り、1つにまとまった位置を探す */
+    mask = (num_candidates == 32) ? 0xFFFFFFFFU : ((1U << num_candidates) - 1);
+    for (smpl = latest; smpl > (*committed); smpl--) {
+        uint32_t parent_mask = 0;
+        for (i = 0; i < width; i++) {
+            if (mask & (1U << i)) {
+                parent_mask |= 1U << MOIENCODER_TRACE_ENTRY(trace, smpl, width, i)->parent;
+            }
+        }
+        mask = parent_mask;
+        /* smpl - 1以前は全候補で共通 */
+        if ((mask & (mask - 1)) == 0) {
+            for (i = 0; (mask & (1U << i)) == 0; i++) { ; }
+            MOIEncoder_TraceBackCodes(trace, width, smpl - 1, i, (*committed), code_seq);
+            (*committed) = smpl;
+            return num_candidates;
+        }
+    }
+
+    /* 記録の窓に余裕があれば確定を待つ */
+    if ((latest - (*committed) + 1) < (MOIENCODER_TRACE_WINDOW_SIZE - MOIENCODER_TRACE_COMMIT_INTERVAL)) {
+        return num_candidates;
+    }
+
+    /* 窓が溢れそうなので、最小コストの候補の祖先で窓の前半を確定 */
+    {
+        const uint32_t cut = latest - MOIENCODER_TRACE_WINDOW_SIZE / 2;
+        uint32_t best = 0, ancestor, n;
+        statistics->num_forced_trace_commits++;
+        for (i = 1; i < num_candidates; i++) {
+            if (candidates->total_cost[i] < candidates->total_cost[best]) {
+                best = i;
+            }
+        }
+        ancestor = best;
+        for (smpl = latest; smpl > cut; smpl--) {
+            ancestor = MOIENCODER_TRACE_ENTRY(trace, smpl, width, ancestor)->parent;
+        }
+        MOIEncoder_TraceBackCodes(trace, width, cut, ancestor, (*committed), code_seq);
+        (*committed) = cut + 1;
+
+        /* 確定した祖先の子孫を辿る */
+        mask = 1U << ancestor;
+        for (smpl = cut + 1; smpl <= latest; smpl++) {
+            uint32_t child_mask = 0;
+            for (i = 0; i < width; i++) {
+                /* 未使用の記録は参照されないので、範囲外の値だけ除けばよい */
+                const uint32_t parent = MOIENCODER_TRACE_ENTRY(trace, smpl, width, i)->parent;
+                if ((parent < width) && (mask & (1U << parent))) {
+                    child_mask |= 1U << i;
+                }
+            }
+            mask = child_mask;
+        }
+
+        /* 子孫でない候補を除いて詰める */
+        n = 0;
+        for (i = 0; i < num_candidates; i++) {
+            if (mask & (1U << i)) {
+                MOICoreEncoderCandidates_Copy(candidates, n, candidates, i);
+                *MOIENCODER_TRACE_ENTRY(trace, latest, width, n)
+                    = *MOIENCODER_TRACE_ENTRY(trace, latest, width, i);
+                n++;
+            }
+        }
+        MOI_ASSERT(n > 0);
+        return n;
+    }
+}
+
+/* 指定位置から同じ値が続くサンプル数を数える */
+static uint32_t MOIEncoder_CountConstantRun(const int16_t *input, uint32_t num_samples)
+{
+    uint32_t smpl;
+
+    MOI_ASSERT(input != NULL);
+    MOI_ASSERT(num_samples > 0);
+
+    for (smpl = 1; smpl < num_samples; smpl++) {
+        if (input[smpl] != input[0]) {
+            break;
+        }
+    }
+
+    return smpl;
+}
+
+/* 展開先のスコア計算
+* 子のスコアは親の選択時の先読みスコア以上（コストは非負で、先読みの窓は1サンプル先に伸びるだけ）
+* なので、親の先読みスコアが小さい順に展開先を評価し、上位num_select個の閾値を超える親の子は探索しない
+* 閾値以下のスコアは正確に求まるため、上位選択の結果は全展開先を探索した場合と一致する
+* スコアがupper_boundを越える展開先は選ばれないので、閾値はupper_bound以下とする（越えたスコアは正確でない） */
+static void MOIEncoder_ScoreExpansions(
+    struct MOIEncoder *encoder, uint32_t num_parents, uint32_t num_expansions, uint32_t num_select,
+    uint32_t depth, const int16_t *sample, MOICost upper_bound, struct MOISearchContext *context)
+{
+    uint32_t i, j, k, num_top;
+    uint32_t parent_rank[MOIENCODER_TRACE_WIDTH];
+    uint32_t rank_start[MOIENCODER_TRACE_WIDTH + 1];
+    MOICost top[MOIENCODER_TRACE_WIDTH];
+    MOICost threshold;
+    const struct MOICoreEncoderCandidates *parent = &(encoder->candidate);
+    const struct MOICoreEncoderCandidates *expansion = &(encoder->expansion);
+    uint32_t *order = encoder->expansion_order;
+    MOICost *score = encoder->expansion_score;
+    const MOISearchFunction search = MOICoreEncoder_search_function_table[depth - 1];
+
+    MOI_ASSERT((num_parents > 0) && (num_parents <= MOIENCODER_TRACE_WIDTH));
+    MOI_ASSERT((num_select > 0) && (num_select <= num_expansions));
+    MOI_ASSERT(num_select <= MOIENCODER_TRACE_WIDTH);
+    MOI_ASSERT((depth > 0) && (depth <= MOI_MAX_SEARCH_DEPTH));
+
+    /* 浅い探索は全展開先を探索 */
+    if (depth < MOIENCODER_SKIP_EXPANSION_MIN_DEPTH) {
+        for (i = 0; i < num_expansions; i++) {
+            struct MOICoreEncoder entry;
+            MOICoreEncoderCandidates_Get(expansion, i, &entry);
+            score[i] = search(&entry, sample, (upper_bound == MOICOST_MAX) ? MOICOST_MAX : (upper_bound + 1), context);
+        }
+        return;
+    }
+
+    /* 親を先読みスコアの昇順に並べる（同スコアはインデックス順） */
+    for (i = 0; i < num_parents; i++) {
+        parent_rank[i] = 0;
+        for (j = 0; j < num_parents; j++) {
+            if ((parent->lookahead_score[j] < parent->lookahead_score[i])
+                    || ((parent->lookahead_score[j] == parent->lookahead_score[i]) && (j < i))) {
+                parent_rank[i]++;
+            }
+        }
+    }
+
+    /* 展開先を親の順位で分布数え上げソート */
+    memset(rank_start, 0, sizeof(uint32_t) * (num_parents + 1));
+    for (i = 0; i < num_expansions; i++) {
+        rank_start[parent_rank[encoder->expansion_trace[i].parent] + 1]++;
+    }
+    for (i = 0; i < num_parents; i++) {
+        rank_start[i + 1] += rank_start[i];
+    }
+    for (i = 0; i < num_expansions; i++) {
+        order[rank_start[parent_rank[encoder->expansion_trace[i].parent]]++] = i;
+    }
+
+    /* 上位num_select個のスコアを昇順で保持し、その最大値（upper_bound以下）を閾値とする */
+    num_top = 0;
+    threshold = upper_bound;
+    for (k = 0; k < num_expansions; k++) {
+        const uint32_t index = order[k];
+        struct MOICoreEncoder entry;
+
+        /* 以降の親の先読みスコアは全て閾値を超えるので、子は選ばれない */
+        if (parent->lookahead_score[encoder->expansion_trace[index].parent] > threshold) {
+            encoder->statistics.search_num_skipped_expansions += num_expansions - k;
+            for (; k < num_expansions; k++) {
+                score[order[k]] = MOICOST_MAX;
+            }
+            break;
+        }
+
+        /* 閾値以下のスコアだけ正確に求めればよい */
+        MOICoreEncoderCandidates_Get(expansion, index, &entry);
+        score[index] = search(&entry, sample,
+                (threshold == MOICOST_MAX) ? MOICOST_MAX : (threshold + 1), context);
+
+        /* 上位スコアの更新 */
+        if ((num_top < num_select) || (score[index] < top[num_top - 1])) {
+            j = (num_top < num_select) ? num_top++ : (num_top - 1);
+            for (; (j > 0) && (top[j - 1] > score[index]); j--) {
+                top[j] = top[j - 1];
+            }
+            top[j] = score[index];
+            if (num_top == num_select) {
+                threshold = MOI_MIN_VAL(top[num_top - 1], upper_bound);
+            }
+        }
+    }
+}
+
+/* モノラルブロックのエンコード */
+static MOIError MOIEncoder_EncodeSamples(
+    struct MOIEncoder *encoder, const int16_t *input, uint32_t num_samples,
+    uint8_t *code_seq, int8_t *best_init_stepsize_index)
+{
+#define HALF_NUM_CODES (MOIENCODER_NUM_CODES / 2)
+    uint32_t i, smpl, beam_width, depth, num_candidates, committed, run_end;
+    uint32_t *selected;
+    MOICost *score, upper_bound;
+    struct MOICoreEncoderCandidates *candidate, *expansion;
+    struct MOICoreEncoderChildren *children;
+    struct MOICoreEncoder *defalut_enc;
+    struct MOICoreEncoderTrace *trace, *expansion_trace;
+    struct MOISearchContext context;
+
+    /* 引数チェック */
+    if ((encoder == NULL) || (input == NULL) || (code_seq == NULL) || (num_samples == 0)) {
+        return MOI_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* オート変数に受ける */
+    candidate = &(encoder->candidate);
+    expansion = &(encoder->expansion);
+    children = &(encoder->children);
+    expansion_trace = encoder->expansion_trace;
+    score = encoder->expansion_score;
+    selected = encoder->selected_index;
+    beam_width = encoder->search_beam_width;
+    depth = encoder->search_depth;
+    defalut_enc = &(encoder->default_encoder);
+    trace = encoder->trace;
+
+    MOI_ASSERT((beam_width > 0) && (beam_width <= MOI_MAX_SEARCH_BEAM_WIDTH));
+    MOI_ASSERT((depth > 0) && (depth <= MOI_MAX_SEARCH_DEPTH));
+
+    /* 先読み探索の設定 キャッシュはブロック毎に空にする */
+    MOISearchCache_Clear(&(encoder->search_cache), input);
+    context.cache = &(encoder->search_cache);
+    context.statistics = &(encoder->statistics);
+    context.use_lower_bound = encoder->encode_parameter.search_use_lower_bound;
+
+    /* 初期ステップサイズインデックスの選択 */
+    {
+#define MAX_STEPSIZE_INDEX (MOI_IMAADPCM_STEPSIZE_TABLE_SIZE - 1)
+        struct MOICoreEncoder init;
+        const uint32_t window = encoder->encode_parameter.init_search_window;
+        const uint32_t init_depth = MOI_MIN_VAL(depth, num_samples - 1);
+        uint32_t lo = 0, hi = MAX_STEPSIZE_INDEX, best;
+
+        init.prev_sample = input[0]; init.total_cost = 0;
+
+        /* 直前ブロック末尾のインデックスが分かっていれば、その周辺だけ探索する */
+        if ((window > 0) && (encoder->init_seed >= 0)) {
+            const uint32_t seed = (uint32_t)encoder->init_seed;
+            MOI_ASSERT(seed <= MAX_STEPSIZE_INDEX);
+            lo = seed - MOI_MIN_VAL(seed, window);
+            hi = MOI_MIN_VAL(seed + window, MAX_STEPSIZE_INDEX);
+            /* ビーム幅分の候補が取れるまで広げる */
+            while ((hi - lo + 1) < beam_width) {
+                lo = (lo > 0) ? (lo - 1) : lo;
+                hi = (hi < MAX_STEPSIZE_INDEX) ? (hi + 1) : hi;
+            }
+            for (i = 0; i < MOI_IMAADPCM_STEPSIZE_TABLE_SIZE; i++) {
+                score[i] = MOICOST_MAX;
+            }
+        }
+
+        /* 各ステップサイズでスコア計算 */
+        best = lo;
+        for (i = lo; i <= hi; i++) {
+            init.stepsize_index = (int8_t)i;
+            score[i] = MOICoreEncoder_SearchMinScore(&init, input + 1, init_depth, MOICOST_MAX, &context);
+            if (score[i] < score[best]) {
+                best = i;
+            }
+        }
+        encoder->statistics.init_search_num_evaluations += hi - lo + 1;
+
+        /* 最小スコアが探索範囲の端にあれば、範囲外に最適値がありうるので内側に入るまで広げる */
+        for (;;) {
+            if ((best == lo) && (lo > 0)) {
+                lo--;
+                init.stepsize_index = (int8_t)lo;
+                score[lo] = MOICoreEncoder_SearchMinScore(&init, input + 1, init_depth, MOICOST_MAX, &context);
+                encoder->statistics.init_search_num_evaluations++;
+                if (score[lo] > score[best]) {
+                    break;
+                }
+                best = lo;
+            } else if ((best == hi) && (hi < MAX_STEPSIZE_INDEX)) {
+                hi++;
+                init.stepsize_index = (int8_t)hi;
+                score[hi] = MOICoreEncoder_SearchMinScore(&init, input + 1, init_depth, MOICOST_MAX, &context);
+                encoder->statistics.init_search_num_evaluations++;
+                if (score[hi] >= score[best]) {
+                    break;
+                }
+                best = hi;
+            } else {
+                break;
+            }
+        }
+#undef MAX_STEPSIZE_INDEX
+
+        /* 上位選択 */
+        MOICoreEncoder_SelectTopKIndices(score, MOI_IMAADPCM_STEPSIZE_TABLE_SIZE, beam_width, selected);
+        {
+            uint32_t argmin = beam_width;
+            MOICost min = MOICOST_MAX;
+            for (i = 0; i < beam_width; i++) {
+                candidate->prev_sample[i] = input[0];
+                candidate->total_cost[i] = 0;
+                candidate->stepsize_index[i] = (int8_t)selected[i];
+                candidate->init_stepsize_index[i] = (int8_t)selected[i];
+                candidate->lookahead_score[i] = score[selected[i]];
+                if (min > score[selected[i]]) {
+                    min = score[selected[i]];
+                    argmin = i;
+                }
+            }
+            MOI_ASSERT(argmin < beam_width);
+
+            /* デフォルト候補の初期化 */
+            MOICoreEncoderCandidates_Get(candidate, argmin, defalut_enc);
+            encoder->default_init_stepsize_index = candidate->init_stepsize_index[argmin];
+        }
+    }
+
+    /* デフォルト候補を先に全サンプル符号化し、その合計コスト（と打ち切りコストの小さい方）を探索の上界とする
+    * スコア（コストの下限）が上界を越えた候補は最後にデフォルト候補に負けるので探索から除く */
+    for (smpl = 1; smpl < num_samples; smpl++) {
+        const uint8_t nibble = MOICoreEncoder_CalculateIMAADPCMNibble(defalut_enc, input[smpl]);
+        MOICoreEncoder_Update(defalut_enc, input[smpl], nibble);
+        encoder->default_code[smpl] = nibble;
+    }
+    upper_bound = MOI_MIN_VAL(defalut_enc->total_cost, encoder->cost_bound);
+
+    /* ブロックデータエンコード */
+    num_candidates = beam_width;
+    committed = 1;
+    run_end = 1;
+    for (smpl = 1; smpl < num_samples; smpl++) {
+        const uint32_t init_depth = MOI_MIN_VAL(depth, num_samples - smpl);
+        uint32_t num_expansions = 0;
+
+        /* 時間切れなら探索を打ち切る（残りはIMA-ADPCMで符号化） */
+        if ((encoder->deadline != 0) && ((smpl % MOIENCODER_DEADLINE_CHECK_INTERVAL) == 0)
+                && (MOIEncoder_GetTimeMicroseconds() >= encoder->deadline)) {
+            encoder->statistics.num_deadline_fallbacks++;
+            break;
+        }
+
+        /* 最小の部分コスト（デフォルト候補は合計コスト）が打ち切りコストに達したら、
+        * 以降のコストは非負なのでこれ以上良くならない */
+        if (encoder->cost_bound != MOICOST_MAX) {
+            MOICost min = defalut_enc->total_cost;
+            for (i = 0; i < num_candidates; i++) {
+                min = MOI_MIN_VAL(min, candidate->total_cost[i]);
+            }
+            if (min >= encoder->cost_bound) {
+                encoder->search_aborted = 1;
+                return MOI_ERROR_OK;
+            }
+        }
+
+        /* 定数区間: 最小コストの候補が区間の値に一致し最小ステップサイズにあれば、
+        * 符号0（差分0）でコストを増やさずに進めるので探索を省略する
+        * 区間の末尾では他の候補を残した方が良い場合があるため、区間の末尾の探索深さ分は通常通り探索する */
+        if (smpl >= run_end) {
+            run_end = smpl + MOIEncoder_CountConstantRun(&input[smpl], num_samples - smpl);
+        }
+        {
+            uint32_t run_length = run_end - smpl, best_index = 0;
+            if (run_end < num_samples) {
+                run_length = (run_length > depth) ? (run_length - depth) : 0;
+            }
+            for (i = 1; (run_length >= MOIENCODER_CONSTANT_RUN_MIN_LENGTH) && (i < num_candidates); i++) {
+                if (candidate->total_cost[i] < candidate->total_cost[best_index]) {
+                    best_index = i;
+                }
+            }
+            if ((run_length >= MOIENCODER_CONSTANT_RUN_MIN_LENGTH)
+                    && (candidate->prev_sample[best_index] == input[smpl])
+                    && (candidate->stepsize_index[best_index] == 0)) {
+                /* 最小コストの候補の符号を確定し、区間は符号0で埋める */
+                MOIEncoder_TraceBackCodes(trace, beam_width, smpl - 1, best_index, committed, code_seq);
+                memset(&code_seq[smpl], 0, sizeof(uint8_t) * run_length);
+                MOICoreEncoderCandidates_Copy(candidate, 0, candidate, best_index);
+                /* 区間を飛ばしたので先読みスコアは次のサンプルの下限にならない */
+                candidate->lookahead_score[0] = 0;
+                num_candidates = 1;
+                committed = smpl + run_length;
+                encoder->statistics.num_constant_run_samples += run_length;
+                smpl = committed - 1;
+                continue;
+            }
+        }
+
+        /* 候補を展開し、同一状態に至るものはコスト最小のものだけ残す
+        * 同一状態からの先読み結果は同一なので、スコアの大小はコストだけで決まる */
+        MOIEncoder_ClearStateHash(encoder);
+        /* 全候補を同一符号の中で一括展開 */
+        MOICoreEncoder_ExpandCandidates(candidate, num_candidates, input[smpl], children);
+        for (i = 0; i < num_candidates * HALF_NUM_CODES; i++) {
+            const uint32_t parent = i / HALF_NUM_CODES;
+            struct MOICoreEncoder entry;
+            uint32_t index;
+            entry.prev_sample = (int16_t)children->prev_sample[i];
+            entry.stepsize_index = children->stepsize_index[i];
+            entry.total_cost = children->total_cost[i];
+            if (MOIEncoder_FindOrInsertState(encoder,
+                        MOICoreEncoder_CalculateStateKey(&entry), num_expansions, &index)) {
+                /* 既存の状態の方がコストが小さい */
+                if (entry.total_cost >= expansion->total_cost[index]) {
+                    continue;
+                }
+            } else {
+                num_expansions++;
+            }
+            expansion->prev_sample[index] = entry.prev_sample;
+            expansion->stepsize_index[index] = entry.stepsize_index;
+            expansion->total_cost[index] = entry.total_cost;
+            expansion->init_stepsize_index[index] = candidate->init_stepsize_index[parent];
+            expansion_trace[index].parent = (uint8_t)parent;
+            expansion_trace[index].nibble = (uint8_t)((i % HALF_NUM_CODES) | children->sign[parent]);
+        }
+
+        /* 異なる状態毎に先読みしてスコア計算（ブロック末尾では残りサンプル数まで浅くする） */
+        MOIEncoder_ScoreExpansions(encoder, num_candidates, num_expansions, MOI_MIN_VAL(beam_width, num_expansions),
+                init_depth, &input[smpl + 1], upper_bound, &context);
+
+        /* スコア上位のエンコーダを次の候補に選択（スコアが上界を越えたものは除く） */
+        {
+            const uint32_t num_selected = MOI_MIN_VAL(beam_width, num_expansions);
+            MOICoreEncoder_SelectTopKIndices(score, num_expansions, num_selected, selected);
+            num_candidates = 0;
+            for (i = 0; i < num_selected; i++) {
+                if (score[selected[i]] > upper_bound) {
+                    continue;
+                }
+                expansion->lookahead_score[selected[i]] = score[selected[i]];
+                MOICoreEncoderCandidates_Copy(candidate, num_candidates, expansion, selected[i]);
+                /* 符号選択を記録（符号列のコピーはしない） */
+                *MOIENCODER_TRACE_ENTRY(trace, smpl, beam_width, num_candidates) = expansion_trace[selected[i]];
+                num_candidates++;
+            }
+            encoder->statistics.search_num_selected_candidates += num_selected;
+            encoder->statistics.search_num_reference_prunes += num_selected - num_candidates;
+        }
+
+        /* 全候補がデフォルト候補に勝てない */
+        if (num_candidates == 0) {
+            break;
+        }
+
+        /* 全候補で共通の祖先の符号を確定して記録の窓を空ける */
+        if ((smpl % MOIENCODER_TRACE_COMMIT_INTERVAL) == 0) {
+            num_candidates = MOIEncoder_CommitConvergedCodes(
+                    trace, beam_width, smpl, &committed, candidate, num_candidates, code_seq, &(encoder->statistics));
+        }
+    }
+
+    /* 全候補がデフォルト候補に勝てなくなった場合はデフォルト候補の符号を使う */
+    if (num_candidates == 0) {
+        if (defalut_enc->total_cost >= encoder->cost_bound) {
+            encoder->search_aborted = 1;
+            return MOI_ERROR_OK;
+        }
+        memcpy(&code_seq[1], &(encoder->default_code[1]), sizeof(uint8_t) * (num_samples - 1));
+        (*best_init_stepsize_index) = encoder->default_init_stepsize_index;
+        encoder->search_cost = defalut_enc->total_cost;
+        return MOI_ERROR_OK;
+    }
+
+    {
+        /* 最小コストのインデックス探索 */
+        const uint32_t num_searched_samples = smpl;
+        struct MOICoreEncoder best;
+        MOICost min = MOICOST_MAX;
+        uint32_t best_index = num_candidates;
+        for (i = 0; i < num_candidates; i++) {
+            if (min > candidate->total_cost[i]) {
+                min = candidate->total_cost[i];
+                best_index = i;
+            }
+        }
+        MOI_ASSERT(best_index < num_candidates);
+
+        /* 探索を打ち切った場合は、最良候補の残りをIMA-ADPCMで符号化 */
+        MOICoreEncoderCandidates_Get(candidate, best_index, &best);
+        for (smpl = num_searched_samples; smpl < num_samples; smpl++) {
+            const uint8_t nibble = MOICoreEncoder_CalculateIMAADPCMNibble(&best, input[smpl]);
+            MOICoreEncoder_Update(&best, input[smpl], nibble);
+            code_seq[smpl] = nibble;
+        }
+
+        /* デフォルト候補の方がコストが小さければそちらを使う */
+        if (defalut_enc->total_cost < best.total_cost) {
+            memcpy(&code_seq[1], &(encoder->default_code[1]), sizeof(uint8_t) * (num_samples - 1));
+            (*best_init_stepsize_index) = encoder->default_init_stepsize_index;
+            encoder->search_cost = defalut_enc->total_cost;
+        } else {
+            /* 探索した範囲の末尾から未確定の符号を選択記録から復元 */
+            MOIEncoder_TraceBackCodes(trace, beam_width, num_searched_samples - 1, best_index, committed, code_seq);
+            (*best_init_stepsize_index) = candidate->init_stepsize_index[best_index];
+            encoder->search_cost = best.total_cost;
+        }
+    }
+
+    return MOI_ERROR_OK;
+#undef HALF_NUM_CODES
+}
+
+/* トレリス探索で併合する状態のキーを計算 */
+static uint32_t MOICoreEncoder_CalculateTrellisKey(const struct MOICoreEncoder *encoder)
+{
+    uint32_t width;
+
+    MOI_ASSERT(encoder != NULL);
+
+    /* ステップサイズに比べて十分近いサンプル値は同一視する */
+    width = (uint32_t)MOI_MAX_VAL(1, IMAADPCM_stepsize_table[encoder->stepsize_index] >> MOITRELLIS_MERGE_SHIFT);
+
+    return ((uint32_t)encoder->stepsize_index << 16) | ((uint32_t)(encoder->prev_sample - INT16_MIN) / width);
+}
+
+/* モノラルブロックのトレリス探索によるエンコード */
+static MOIError MOIEncoder_EncodeSamplesTrellis(
+    struct MOIEncoder *encoder, const int16_t *input, uint32_t num_samples,
+    uint8_t *code_seq, int8_t *best_init_stepsize_index)
+{
+#define HALF_NUM_CODES (MOIENCODER_NUM_CODES / 2)
+    uint32_t i, smpl, num_states, max_num_states, committed;
+    struct MOICoreEncoderCandidates *state, *next;
+    struct MOICoreEncoderChildren *children;
+    struct MOICoreEncoderTrace *trace, *next_trace;
+
+    /* 引数チェック */
+    if ((encoder == NULL) || (input == NULL) || (code_seq == NULL) || (num_samples == 0)) {
+        return MOI_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* オート変数に受ける */
+    state = &(encoder->trellis_state);
+    next = &(encoder->expansion);
+    children = &(encoder->children);
+    next_trace = encoder->expansion_trace;
+    trace = encoder->trace;
+    max_num_states = encoder->encode_parameter.trellis_num_states;
+
+    MOI_ASSERT((max_num_states > 0) && (max_num_states <= MOI_MAX_TRELLIS_NUM_STATES));
+
+    /* 初期状態は全ステップサイズインデックス */
+    for (i = 0; i < MOI_IMAADPCM_STEPSIZE_TABLE_SIZE; i++) {
+        state->prev_sample[i] = input[0];
+        state->stepsize_index[i] = (int8_t)i;
+        state->total_cost[i] = 0;
+        state->init_stepsize_index[i] = (int8_t)i;
+    }
+    num_states = MOI_IMAADPCM_STEPSIZE_TABLE_SIZE;
+
+    committed = 1;
+    for (smpl = 1; smpl < num_samples; smpl++) {
+        uint32_t num_next = 0;
+
+        /* 各状態を展開し、同一とみなせる状態はコスト最小のものに併合 */
+        MOIEncoder_ClearStateHash(encoder);
+        MOICoreEncoder_ExpandCandidates(state, num_states, input[smpl], children);
+        for (i = 0; i < num_states * HALF_NUM_CODES; i++) {
+            const uint32_t parent = i / HALF_NUM_CODES;
+            struct MOICoreEncoder entry;
+            uint32_t index;
+            entry.prev_sample = (int16_t)children->prev_sample[i];
+            entry.stepsize_index = children->stepsize_index[i];
+            entry.total_cost = children->total_cost[i];
+            if (MOIEncoder_FindOrInsertState(encoder,
+                        MOICoreEncoder_CalculateTrellisKey(&entry), num_next, &index)) {
+                /* 既存の状態の方がコストが小さい */
+                if (entry.total_cost >= next->total_cost[index]) {
+                    continue;
+                }
+            } else {
+                MOI_ASSERT(num_next < MOIENCODER_MAX_NUM_EXPANSIONS);
+                num_next++;
+            }
+            next->prev_sample[index] = entry.prev_sample;
+            next->stepsize_index[index] = entry.stepsize_index;
+            next->total_cost[index] = entry.total_cost;
+            next->init_stepsize_index[index] = state->init_stepsize_index[parent];
+            next_trace[index].parent = (uint8_t)parent;
+            next_trace[index].nibble = (uint8_t)((i % HALF_NUM_CODES) | children->sign[parent]);
+        }
+
+        /* コストが小さい状態を残す */
+        {
+            uint32_t *selected = encoder->selected_index;
+
+            MOI_ASSERT(num_next > 0);
+            num_states = MOI_MIN_VAL(max_num_states, num_next);
+            MOICoreEncoder_SelectTopKIndices(next->total_cost, num_next, num_states, selected);
+            for (i = 0; i < num_states; i++) {
+                MOICoreEncoderCandidates_Copy(state, i, next, selected[i]);
+                *MOIENCODER_TRACE_ENTRY(trace, smpl, max_num_states, i) = next_trace[selected[i]];
+            }
+        }
+
+        /* 全状態で共通の祖先の符号を確定して記録の窓を空ける */
+        if ((smpl % MOIENCODER_TRACE_COMMIT_INTERVAL) == 0) {
+            num_states = MOIEncoder_CommitConvergedCodes(
+                    trace, max_num_states, smpl, &committed, state, num_states, code_seq, &(encoder->statistics));
+        }
+    }
+
+    /* 最小コストの状態から選択記録を辿って未確定の符号を復元 */
+    {
+        MOICost min = MOICOST_MAX;
+        uint32_t index = num_states;
+        for (i = 0; i < num_states; i++) {
+            if (min > state->total_cost[i]) {
+                min = state->total_cost[i];
+                index = i;
+            }
+        }
+        MOI_ASSERT(index < num_states);
+
+        (*best_init_stepsize_index) = state->init_stepsize_index[index];
+        MOIEncoder_TraceBackCodes(trace, max_num_states, num_samples - 1, index, committed, code_seq);
+        encoder->search_cost = min;
+    }
+
+    return MOI_ERROR_OK;
+#undef HALF_NUM_CODES
+}
+
+/* 初期ステップサイズインデックス0からIMA-ADPCMで符号化し、合計コストを返す
+* code_seqがNULLの場合はコストの計算のみ行う */
+static MOICost MOIEncoder_EncodeSamplesIMAADPCM(
+        const int16_t *input, uint32_t num_samples, uint8_t *code_seq)
+{
+    uint32_t smpl;
+    struct MOICoreEncoder ima;
+
+    MOI_ASSERT(input != NULL);
+    MOI_ASSERT(num_samples > 0);
+
+    ima.prev_sample = input[0];
+    ima.stepsize_index = 0;
+    ima.total_cost = 0;
+    for (smpl = 1; smpl < num_samples; smpl++) {
+        const uint8_t nibble = MOICoreEncoder_CalculateIMAADPCMNibble(&ima, input[smpl]);
+        MOICoreEncoder_Update(&ima, input[smpl], nibble);
+        if (code_seq != NULL) {
+            code_seq[smpl] = nibble;
+        }
+    }
+
+    return ima.total_cost;
+}
+
+/* 符号列をデコードした場合の合計コストを計算 */
+static MOICost MOIEncoder_CalculateCodeCost(
+        const int16_t *input, uint32_t num_samples, int8_t init_stepsize_index, const uint8_t *code_seq)
+{
+    uint32_t smpl;
+    struct MOICoreEncoder decoder;
+
+    MOI_ASSERT((input != NULL) && (code_seq != NULL));
+
+    decoder.prev_sample = input[0];
+    decoder.stepsize_index = init_stepsize_index;
+    decoder.total_cost = 0;
+    for (smpl = 1; smpl < num_samples; smpl++) {
+        MOICoreEncoder_Update(&decoder, input[smpl], code_seq[smpl]);
+    }
+
+    return decoder.total_cost;
+}
+
+/* ブロックの符号化の難しさから探索の労力を見積もる
+* IMA-ADPCMで符号化した場合の誤差が大きいブロックほど探索の効果が大きいので、広く深く探索する */
+static uint32_t MOIEncoder_EstimateSearchEffort(const int16_t *input, uint32_t num_samples)
+{
+    uint32_t cost_bits;
+    MOICost mean_cost;
+
+    MOI_ASSERT(input != NULL);
+    MOI_ASSERT(num_samples > 0);
+
+    /* IMA-ADPCMの符号化による平均二乗誤差 */
+    mean_cost = MOIEncoder_EncodeSamplesIMAADPCM(input, num_samples, NULL)
+        / MOI_MAX_VAL(1, (MOICost)num_samples - 1);
+
+    /* 誤差のビット長を範囲内に収めて労力とする */
+    for (cost_bits = 0; mean_cost > 0; cost_bits++) {
+        mean_cost >>= 1;
+    }
+    return MOI_INNER_VAL(cost_bits, MOIENCODER_ADAPTIVE_MIN_COST_BITS, MOIENCODER_ADAPTIVE_MAX_COST_BITS)
+        - MOIENCODER_ADAPTIVE_MIN_COST_BITS;
+}
+
+/* 探索の労力に応じて探索ビーム幅・深さを最小から最大へ線形に割り当て（四捨五入） */
+static void MOIEncoder_SetSearchEffort(struct MOIEncoder *encoder, uint32_t effort)
+{
+    const struct MOIEncodeParameter *parameter;
+
+    MOI_ASSERT(encoder != NULL);
+    MOI_ASSERT(effort <= MOIENCODER_NUM_EFFORT_LEVELS);
+
+    parameter = &(encoder->encode_parameter);
+
+#define MOIENCODER_INTERPOLATE(min, max)\
+    ((min) + (((max) - (min)) * effort + MOIENCODER_NUM_EFFORT_LEVELS / 2) / MOIENCODER_NUM_EFFORT_LEVELS)
+    encoder->search_beam_width
+        = MOIENCODER_INTERPOLATE(parameter->min_search_beam_width, parameter->search_beam_width);
+    encoder->search_depth
+        = MOIENCODER_INTERPOLATE(parameter->min_search_depth, parameter->search_depth);
+#undef MOIENCODER_INTERPOLATE
+
+    MOI_ASSERT((encoder->search_beam_width >= parameter->min_search_beam_width)
+            && (encoder->search_beam_width <= parameter->search_beam_width));
+    MOI_ASSERT((encoder->search_depth >= parameter->min_search_depth)
+            && (encoder->search_depth <= parameter->search_depth));
+}
+
+/* 時間予算に対する実績から次のブロックの探索の労力を更新
+* 予算超過（時間切れを含む）なら大きく下げ、予算の半分未満なら少し上げる */
+static void MOIEncoder_UpdateBudgetEffort(
+        struct MOIEncoder *encoder, uint64_t elapsed, uint64_t budget, uint8_t expired)
+{
+    MOI_ASSERT(encoder != NULL);
+
+    if (expired || (elapsed > budget)) {
+        encoder->budget_effort = (encoder->budget_effort >= 2) ? (encoder->budget_effort - 2) : 0;
+    } else if ((2 * elapsed < budget) && (encoder->budget_effort < MOIENCODER_NUM_EFFORT_LEVELS)) {
+        encoder->budget_effort++;
+    }
+}
+
+/* 符号列をデコードした場合の末尾のステップサイズインデックスを計算 */
+static int8_t MOIEncoder_CalculateLastStepsizeIndex(
+        int8_t init_stepsize_index, const uint8_t *code_seq, uint32_t num_samples)
+{
+    uint32_t smpl;
+    int32_t index = init_stepsize_index;
+
+    MOI_ASSERT(code_seq != NULL);
+
+    for (smpl = 1; smpl < num_samples; smpl++) {
+        index = MOI_INNER_VAL(index + IMAADPCM_index_table[code_seq[smpl]], 0, (int32_t)MOI_IMAADPCM_STEPSIZE_TABLE_SIZE - 1);
+    }
+
+    return (int8_t)index;
+}
+
+/* ポートフォリオ符号化: 複数の探索設定で順に符号化し、最小コストの結果を選ぶ
+* 最小の部分コストがそれまでの最良のコストに達した設定は、それ以上良くならないので打ち切る */
+static MOIError MOIEncoder_EncodeSamplesPortfolio(
+    struct MOIEncoder *encoder, const int16_t *input, uint32_t num_samples,
+    uint8_t *code_seq, int8_t *best_init_stepsize_index)
+{
+    uint32_t k, best_k = 0;
+    MOICost best_cost = MOICOST_MAX;
+    MOIError err = MOI_ERROR_OK;
+    const struct MOIEncodeParameter *parameter;
+    struct MOIEncodeStatistics *statistics;
+
+    MOI_ASSERT((encoder != NULL) && (input != NULL) && (code_seq != NULL) && (best_init_stepsize_index != NULL));
+
+    parameter = &(encoder->encode_parameter);
+    statistics = &(encoder->statistics);
+    MOI_ASSERT((parameter->portfolio_size > 0) && (parameter->portfolio_size <= MOI_MAX_PORTFOLIO_SIZE));
+
+    for (k = 0; k < parameter->portfolio_size; k++) {
+        int8_t init_stepsize_index;
+        MOICost cost;
+        /* 最初の設定は出力先に直接符号化 */
+        uint8_t *code = (k == 0) ? code_seq : encoder->portfolio_code;
+
+        encoder->search_beam_width = parameter->portfolio_beam_width[k];
+        encoder->search_depth = parameter->portfolio_depth[k];
+        encoder->cost_bound = best_cost;
+        encoder->search_aborted = 0;
+        if ((err = MOIEncoder_EncodeSamples(encoder, input, num_samples, code, &init_stepsize_index)) != MOI_ERROR_OK) {
+            break;
+        }
+        statistics->portfolio_num_runs++;
+        statistics->num_searched_blocks++;
+        statistics->total_search_beam_width += encoder->search_beam_width;
+        statistics->total_search_depth += encoder->search_depth;
+        if (encoder->search_aborted) {
+            statistics->portfolio_num_aborts++;
+            continue;
+        }
+
+        /* 最良の結果を残す */
+        cost = encoder->search_cost;
+        if (cost < best_cost) {
+            if (code != code_seq) {
+                memcpy(&code_seq[1], &code[1], sizeof(uint8_t) * (num_samples - 1));
+            }
+            (*best_init_stepsize_index) = init_stepsize_index;
+            best_cost = cost;
+            best_k = k;
+        }
+    }
+
+    if (err == MOI_ERROR_OK) {
+        statistics->portfolio_num_wins[best_k]++;
+    }
+
+    encoder->cost_bound = MOICOST_MAX;
+    encoder->search_aborted = 0;
+
+    return err;
+}
+
+/* 局所探索: 符号列の各サンプルを符号化する直前の状態を計算
+* state[smpl]はサンプルsmplを符号化する直前の状態で、state[num_samples]が終端の状態 */
+static void MOIEncoder_CalculateCodeStates(
+        const int16_t *input, uint32_t num_samples, int8_t init_stepsize_index,
+        const uint8_t *code_seq, uint32_t start, struct MOICoreEncoder *state)
+{
+    uint32_t smpl;
+
+    MOI_ASSERT((input != NULL) && (code_seq != NULL) && (state != NULL));
+    MOI_ASSERT((start > 0) && (start < num_samples));
+
+    if (start == 1) {
+        state[1].prev_sample = input[0];
+        state[1].stepsize_index = init_stepsize_index;
+        state[1].total_cost = 0;
+    }
+    for (smpl = start; smpl < num_samples; smpl++) {
+        state[smpl + 1] = state[smpl];
+        MOICoreEncoder_Update(&state[smpl + 1], input[smpl], code_seq[smpl]);
+    }
+}
+
+/* 局所探索: 探索済みの符号列を1サンプルの符号の変更で改善する
+* 変更先は絶対値が1だけ異なる同符号の符号（絶対値0は符号反転も）に限る（それ以外はほぼ改善しない）
+* 変更後はIMA-ADPCMの符号で元の符号列の状態に再び一致するまで（最大MOIENCODER_LOCAL_SEARCH_HORIZONサンプル）補修し、
+* 一致した時点で以降のコストは元と等しいので差分が確定する（ブロック末尾に達した場合もそこで確定）
+* 残りの元のコストを差分が上回った時点で改善の見込みは無いので打ち切る（以降のコストは非負）
+* 改善が無くなるかmax_sweeps回走査するまで繰り返し、最終的な合計コストを返す */
+static MOICost MOIEncoder_ImproveCodeLocally(
+        const int16_t *input, uint32_t num_samples, int8_t init_stepsize_index,
+        uint8_t *code_seq, uint32_t max_sweeps, struct MOICoreEncoder *state,
+        struct MOIEncodeStatistics *statistics)
+{
+    uint32_t sweep, smpl, i, j, length, best_length, num_trials;
+    uint8_t improved;
+    uint8_t trial_nibble[2];
+    uint8_t trial_code[MOIENCODER_LOCAL_SEARCH_HORIZON], best_code[MOIENCODER_LOCAL_SEARCH_HORIZON];
+
+    MOI_ASSERT((input != NULL) && (code_seq != NULL) && (state != NULL) && (statistics != NULL));
+
+    if (num_samples < 2) {
+        return 0;
+    }
+
+    MOIEncoder_CalculateCodeStates(input, num_samples, init_stepsize_index, code_seq, 1, state);
+
+    for (sweep = 0, improved = 1; (sweep < max_sweeps) && improved; sweep++) {
+        improved = 0;
+        for (smpl = 1; smpl < num_samples; smpl++) {
+            const MOICost total_cost = state[num_samples].total_cost;
+            const uint32_t horizon = MOI_MIN_VAL(num_samples - smpl, MOIENCODER_LOCAL_SEARCH_HORIZON);
+            const uint8_t abs = code_seq[smpl] & 7, sign = code_seq[smpl] & 8;
+            MOICost best_delta = 0;
+            best_length = 0;
+            /* 変更先の符号を列挙 */
+            num_trials = 0;
+            if (abs > 0) {
+                trial_nibble[num_trials++] = (uint8_t)((abs - 1) | sign);
+            } else {
+                trial_nibble[num_trials++] = (uint8_t)(sign ^ 8);
+            }
+            if (abs < 7) {
+                trial_nibble[num_trials++] = (uint8_t)((abs + 1) | sign);
+            }
+            for (i = 0; i < num_trials; i++) {
+                struct MOICoreEncoder trial;
+                trial = state[smpl];
+                MOICoreEncoder_Update(&trial, input[smpl], trial_nibble[i]);
+                trial_code[0] = trial_nibble[i];
+                for (length = 1; length <= horizon; length++) {
+                    const MOICost delta = trial.total_cost - state[smpl + length].total_cost;
+                    j = smpl + length;
+                    /* 残りのコストが全て0になっても最良の改善に届かない */
+                    if (delta - (total_cost - state[j].total_cost) >= best_delta) {
+                        break;
+                    }
+                    /* 末尾に達したか、状態が一致して以降のコストが等しくなった */
+                    if ((j == num_samples) || ((trial.prev_sample == state[j].prev_sample)
+                                && (trial.stepsize_index == state[j].stepsize_index))) {
+                        if (delta < best_delta) {
+                            best_delta = delta;
+                            best_length = length;
+                            memcpy(best_code, trial_code, sizeof(uint8_t) * length);
+                        }
+                        break;
+                    }
+                    /* 補修範囲内で一致しなければ諦める */
+                    if (length == horizon) {
+                        break;
+                    }
+                    trial_code[length] = MOICoreEncoder_CalculateIMAADPCMNibble(&trial, input[j]);
+                    MOICoreEncoder_Update(&trial, input[j], trial_code[length]);
+                }
+            }
+            /* 改善する符号があれば変更して以降の状態を更新 */
+            if (best_length > 0) {
+                memcpy(&code_seq[smpl], best_code, sizeof(uint8_t) * best_length);
+                MOIEncoder_CalculateCodeStates(input, num_samples, init_stepsize_index, code_seq, smpl, state);
+                MOI_ASSERT(state[num_samples].total_cost == (total_cost + best_delta));
+                statistics->local_search_num_improvements++;
+                improved = 1;
+            }
+        }
+        statistics->local_search_num_sweeps++;
+    }
+
+    return state[num_samples].total_cost;
+}
+
+/* ブロックキャッシュの全エントリを無効化 */
+static void MOIBlockCache_Clear(struct MOIBlockCache *cache)
+{
+    MOI_ASSERT(cache != NULL);
+
+    if (cache->entry == NULL) {
+        return;
+    }
+
+    /* スタンプ更新により全エントリを無効化 */
+    cache->stamp++;
+    if (cache->stamp == 0) {
+        memset(cache->entry, 0, sizeof(struct MOIBlockCacheEntry) * cache->num_entries);
+        cache->stamp = 1;
+    }
+}
+
+/* ブロックのハッシュ値を計算 */
+static uint32_t MOIBlockCache_CalculateHash(
+        const int16_t *const *input, uint32_t num_channels, uint32_t num_samples, uint8_t reference_only,
+        const int8_t *init_seed)
+{
+    uint32_t ch, smpl, hash;
+
+    MOI_ASSERT((input != NULL) && (init_seed != NULL));
+
+    hash = (num_samples * 2654435761U) ^ (num_channels << 1) ^ reference_only;
+    for (ch = 0; ch < num_channels; ch++) {
+        hash = (hash ^ (uint8_t)init_seed[ch]) * 2246822519U;
+        /* 2サンプルずつ32bitにまとめて混ぜる */
+        for (smpl = 0; smpl + 1 < num_samples; smpl += 2) {
+            const uint32_t word = (uint32_t)(uint16_t)input[ch][smpl] | ((uint32_t)(uint16_t)input[ch][smpl + 1] << 16);
+            hash = (hash ^ word) * 2246822519U;
+            hash ^= hash >> 13;
+        }
+        if (smpl < num_samples) {
+            hash = (hash ^ (uint16_t)input[ch][smpl]) * 2246822519U;
+            hash ^= hash >> 13;
+        }
+    }
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+/* ブロックキャッシュの参照先エントリのインデックスを取得（直接写像、衝突時は上書き） */
+#define MOIBlockCache_GetEntryIndex(cache, hash) ((hash) & ((cache)->num_entries - 1))
+
+/* ブロックキャッシュのエントリが入力ブロックと一致するか（ハッシュの衝突に備えてサンプルも比較） */
+static uint8_t MOIBlockCache_IsMatch(
+        const struct MOIBlockCache *cache, uint32_t index, uint32_t hash,
+        const int16_t *const *input, uint32_t num_channels, uint32_t num_samples, uint8_t reference_only,
+        const int8_t *init_seed)
+{
+    uint32_t ch;
+    const struct MOIBlockCacheEntry *entry;
+
+    MOI_ASSERT((cache != NULL) && (cache->entry != NULL));
+    MOI_ASSERT(index < cache->num_entries);
+
+    entry = &(cache->entry[index]);
+    if ((entry->stamp != cache->stamp) || (entry->hash != hash)
+            || (entry->num_channels != num_channels) || (entry->num_samples != num_samples)
+            || (entry->reference_only != reference_only)) {
+        return 0;
+    }
+    for (ch = 0; ch < num_channels; ch++) {
+        if (entry->init_seed[ch] != init_seed[ch]) {
+            return 0;
+        }
+        if (memcmp(&(cache->sample[index * cache->slot_size + ch * num_samples]),
+                    input[ch], sizeof(int16_t) * num_samples) != 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* ブロックの探索結果をブロックキャッシュに登録 */
+static void MOIBlockCache_Store(
+        struct MOIBlockCache *cache, uint32_t index, uint32_t hash,
+        const int16_t *const *input, uint32_t num_channels, uint32_t num_samples, uint8_t reference_only,
+        const int8_t *init_seed /* [MOI_MAX_NUM_CHANNELS] */,
+        uint8_t *const *code, const int8_t *init_stepsize_index /* [MOI_MAX_NUM_CHANNELS] */)
+{
+    uint32_t ch;
+    struct MOIBlockCacheEntry *entry;
+
+    MOI_ASSERT((cache != NULL) && (cache->entry != NULL));
+    MOI_ASSERT(index < cache->num_entries);
+    MOI_ASSERT((num_channels * num_samples) <= cache->slot_size);
+
+    entry = &(cache->entry[index]);
+    entry->hash = hash;
+    entry->stamp = cache->stamp;
+    entry->num_samples = num_samples;
+    entry->num_channels = (uint16_t)num_channels;
+    entry->reference_only = reference_only;
+    memcpy(entry->init_seed, init_seed, sizeof(int8_t) * MOI_MAX_NUM_CHANNELS);
+    memcpy(entry->init_stepsize_index, init_stepsize_index, sizeof(int8_t) * MOI_MAX_NUM_CHANNELS);
+    for (ch = 0; ch < num_channels; ch++) {
+        const uint32_t offset = index * cache->slot_size + ch * num_samples;
+        memcpy(&(cache->sample[offset]), input[ch], sizeof(int16_t) * num_samples);
+        memcpy(&(cache->code[offset]), code[ch], sizeof(uint8_t) * num_samples);
+    }
+}
 
 /* 単一データブロックエンコード */
 MOIApiResult MOIEncoder_EncodeBlock(
@@ -597,6 +2459,10 @@ MOIApiResult MOIEncoder_EncodeBlock(
     MOIError err;
     uint32_t ch, smpl;
     uint8_t *data_pos;
+    uint8_t expired = 0, use_block_cache = 0, cache_hit = 0;
+    uint32_t cache_hash = 0, cache_index = 0;
+    uint64_t start_time = 0, budget = 0;
+    int8_t init_seed[MOI_MAX_NUM_CHANNELS];
     const struct MOIEncodeParameter *parameter;
 
     /* 引数チェック */
@@ -612,10 +2478,95 @@ MOIApiResult MOIEncoder_EncodeBlock(
     }
     data_pos = data;
 
-    /* 最前符号列の探索 */
-    for (ch = 0; ch < parameter->num_channels; ch++) {
-        if ((err = MOIEncoder_EncodeSamples(encoder, input[ch], num_samples,
-                encoder->best_code[ch], &(encoder->best_init_stepsize_index[ch]))) != MOI_ERROR_OK) {
+    /* ブロックの時間予算[us] */
+    if (parameter->time_budget > 0) {
+        start_time = MOIEncoder_GetTimeMicroseconds();
+        budget = ((uint64_t)parameter->time_budget * 1000 * num_samples) / parameter->sampling_rate;
+    }
+
+    /* 初期ステップサイズインデックスの探索の中心（直前ブロック末尾のインデックス） */
+    for (ch = 0; ch < MOI_MAX_NUM_CHANNELS; ch++) {
+        init_seed[ch] = (parameter->init_search_window > 0) ? encoder->last_stepsize_index[ch] : -1;
+    }
+
+    /* 同一内容のブロックの探索結果があれば再利用
+    * 時間予算指定時は探索結果が処理時間に依存するため使わない */
+    if ((encoder->block_cache.entry != NULL) && (parameter->time_budget == 0)
+            && ((parameter->num_channels * num_samples) <= encoder->block_cache.slot_size)) {
+        struct MOIBlockCache *cache = &(encoder->block_cache);
+        use_block_cache = 1;
+        cache_hash = MOIBlockCache_CalculateHash(
+                input, parameter->num_channels, num_samples, encoder->reference_only, init_seed);
+        cache_index = MOIBlockCache_GetEntryIndex(cache, cache_hash);
+        if (MOIBlockCache_IsMatch(cache, cache_index, cache_hash,
+                    input, parameter->num_channels, num_samples, encoder->reference_only, init_seed)) {
+            const struct MOIBlockCacheEntry *entry = &(cache->entry[cache_index]);
+            for (ch = 0; ch < parameter->num_channels; ch++) {
+                memcpy(encoder->best_code[ch],
+                        &(cache->code[cache_index * cache->slot_size + ch * num_samples]), sizeof(uint8_t) * num_samples);
+                encoder->best_init_stepsize_index[ch] = entry->init_stepsize_index[ch];
+            }
+            encoder->statistics.block_cache_hits++;
+            cache_hit = 1;
+        } else {
+            encoder->statistics.block_cache_misses++;
+        }
+    }
+
+    /* 最前符号列の探索（キャッシュにあれば省略） */
+    for (ch = 0; (ch < parameter->num_channels) && !cache_hit; ch++) {
+        /* 定数ブロックは最小ステップサイズから符号0（差分0）を続ければ誤差0 */
+        if (MOIEncoder_CountConstantRun(input[ch], num_samples) == num_samples) {
+            memset(&(encoder->best_code[ch][1]), 0, sizeof(uint8_t) * (num_samples - 1));
+            encoder->best_init_stepsize_index[ch] = 0;
+            encoder->statistics.num_constant_blocks++;
+            continue;
+        }
+        /* 2パス符号化で探索しないブロックはIMA-ADPCMの符号をそのまま使う */
+        if (encoder->reference_only) {
+            (void)MOIEncoder_EncodeSamplesIMAADPCM(input[ch], num_samples, encoder->best_code[ch]);
+            encoder->best_init_stepsize_index[ch] = 0;
+            continue;
+        }
+        switch (parameter->search_method) {
+        case MOI_SEARCH_METHOD_TRELLIS:
+            err = MOIEncoder_EncodeSamplesTrellis(encoder, input[ch], num_samples,
+                    encoder->best_code[ch], &(encoder->best_init_stepsize_index[ch]));
+            break;
+        default:
+            /* ポートフォリオ符号化は設定毎に探索幅・深さが決まっている */
+            if (parameter->portfolio_size > 0) {
+                encoder->init_seed = init_seed[ch];
+                err = MOIEncoder_EncodeSamplesPortfolio(encoder, input[ch], num_samples,
+                        encoder->best_code[ch], &(encoder->best_init_stepsize_index[ch]));
+                break;
+            }
+            /* 探索の労力を決める: ブロックの難しさと時間予算の低い方 */
+            if (parameter->search_adaptive || (parameter->time_budget > 0)) {
+                uint32_t effort = MOIENCODER_NUM_EFFORT_LEVELS;
+                if (parameter->search_adaptive) {
+                    effort = MOIEncoder_EstimateSearchEffort(input[ch], num_samples);
+                }
+                if (parameter->time_budget > 0) {
+                    effort = MOI_MIN_VAL(effort, encoder->budget_effort);
+                    /* 予算はチャンネルで等分 */
+                    encoder->deadline = start_time + (budget * (ch + 1)) / parameter->num_channels;
+                }
+                MOIEncoder_SetSearchEffort(encoder, effort);
+            }
+            {
+                const uint64_t num_fallbacks = encoder->statistics.num_deadline_fallbacks;
+                encoder->init_seed = init_seed[ch];
+                err = MOIEncoder_EncodeSamples(encoder, input[ch], num_samples,
+                        encoder->best_code[ch], &(encoder->best_init_stepsize_index[ch]));
+                expired |= (encoder->statistics.num_deadline_fallbacks != num_fallbacks) ? 1 : 0;
+            }
+            encoder->statistics.num_searched_blocks++;
+            encoder->statistics.total_search_beam_width += encoder->search_beam_width;
+            encoder->statistics.total_search_depth += encoder->search_depth;
+            break;
+        }
+        if (err != MOI_ERROR_OK) {
             /* エラーハンドル */
             switch (err) {
             case MOI_ERROR_INVALID_ARGUMENT:
@@ -628,6 +2579,47 @@ MOIApiResult MOIEncoder_EncodeBlock(
                 return MOI_APIRESULT_NG;
             }
         }
+        /* 局所探索で探索結果を改善 */
+        if (parameter->local_search_sweeps > 0) {
+            struct MOIEncodeStatistics *statistics = &(encoder->statistics);
+            const uint64_t local_search_start = MOIEncoder_GetTimeMicroseconds();
+            statistics->local_search_initial_cost += (uint64_t)MOIEncoder_CalculateCodeCost(input[ch], num_samples,
+                    encoder->best_init_stepsize_index[ch], encoder->best_code[ch]);
+            statistics->local_search_final_cost += (uint64_t)MOIEncoder_ImproveCodeLocally(input[ch], num_samples,
+                    encoder->best_init_stepsize_index[ch], encoder->best_code[ch],
+                    parameter->local_search_sweeps, encoder->local_search_state, statistics);
+            statistics->local_search_num_samples += num_samples - 1;
+            statistics->local_search_time += MOIEncoder_GetTimeMicroseconds() - local_search_start;
+        }
+    }
+
+    /* 次のブロックの初期ステップサイズインデックスの探索に備えて、末尾のインデックスを記録 */
+    if (parameter->init_search_window > 0) {
+        for (ch = 0; ch < parameter->num_channels; ch++) {
+            encoder->last_stepsize_index[ch] = MOIEncoder_CalculateLastStepsizeIndex(
+                    encoder->best_init_stepsize_index[ch], encoder->best_code[ch], num_samples);
+        }
+    }
+
+    /* 探索結果をキャッシュに登録 */
+    if (use_block_cache && !cache_hit) {
+        MOIBlockCache_Store(&(encoder->block_cache), cache_index, cache_hash,
+                input, parameter->num_channels, num_samples, encoder->reference_only, init_seed,
+                encoder->best_code, encoder->best_init_stepsize_index);
+    }
+
+    /* 時間予算の実績から次のブロックの労力を更新 */
+    if ((parameter->time_budget > 0) && (parameter->search_method == MOI_SEARCH_METHOD_BEAM)
+            && !encoder->reference_only) {
+        MOIEncoder_UpdateBudgetEffort(encoder,
+                MOIEncoder_GetTimeMicroseconds() - start_time, budget, expired);
+        encoder->deadline = 0;
+    }
+
+    /* 末尾の端数サンプルの符号を0埋め
+     * 以前のブロックの符号が残っていると、エンコードしたスレッドによって出力が変わってしまう */
+    for (ch = 0; ch < parameter->num_channels; ch++) {
+        memset(&(encoder->best_code[ch][num_samples]), 0, (parameter->num_channels == 1) ? 1 : 7);
     }
 
     /* ブロックヘッダエンコード */
@@ -740,6 +2732,36 @@ static MOIError MOIEncoder_ConvertParameterToHeader(
     return MOI_ERROR_OK;
 }
 
+/* ブロックの探索結果が同一になるパラメータか（スレッド数は結果に影響しない） */
+static uint8_t MOIEncoder_IsSameSearchParameter(
+        const struct MOIEncodeParameter *a, const struct MOIEncodeParameter *b)
+{
+    MOI_ASSERT((a != NULL) && (b != NULL));
+
+    return ((a->num_channels == b->num_channels)
+            && (a->sampling_rate == b->sampling_rate)
+            && (a->bits_per_sample == b->bits_per_sample)
+            && (a->block_size == b->block_size)
+            && (a->search_method == b->search_method)
+            && (a->search_beam_width == b->search_beam_width)
+            && (a->search_depth == b->search_depth)
+            && (a->search_use_lower_bound == b->search_use_lower_bound)
+            && (a->search_adaptive == b->search_adaptive)
+            && (a->min_search_beam_width == b->min_search_beam_width)
+            && (a->min_search_depth == b->min_search_depth)
+            && (a->time_budget == b->time_budget)
+            && (a->refine_percent == b->refine_percent)
+            && (a->refine_threshold == b->refine_threshold)
+            && (a->init_search_window == b->init_search_window)
+            && (a->local_search_sweeps == b->local_search_sweeps)
+            && (a->portfolio_size == b->portfolio_size)
+            && (memcmp(a->portfolio_beam_width, b->portfolio_beam_width,
+                    sizeof(uint32_t) * MOI_MIN_VAL(a->portfolio_size, MOI_MAX_PORTFOLIO_SIZE)) == 0)
+            && (memcmp(a->portfolio_depth, b->portfolio_depth,
+                    sizeof(uint32_t) * MOI_MIN_VAL(a->portfolio_size, MOI_MAX_PORTFOLIO_SIZE)) == 0)
+            && (a->trellis_num_states == b->trellis_num_states)) ? 1 : 0;
+}
+
 /* エンコードパラメータの設定 */
 MOIApiResult MOIEncoder_SetEncodeParameter(
         struct MOIEncoder *encoder, const struct MOIEncodeParameter *parameter)
@@ -756,21 +2778,340 @@ MOIApiResult MOIEncoder_SetEncodeParameter(
         return MOI_APIRESULT_INVALID_FORMAT;
     }
 
+    /* スレッド数が範囲外（0は1として扱う） */
+    if (parameter->num_threads > encoder->max_num_threads) {
+        return MOI_APIRESULT_INVALID_FORMAT;
+    }
+
+    /* 探索手法の確認 */
+    switch (parameter->search_method) {
+    case MOI_SEARCH_METHOD_BEAM:
+        /* 適応時・時間予算指定時の探索幅・深さの範囲がおかしい */
+        if ((parameter->search_adaptive || (parameter->time_budget > 0))
+                && ((parameter->min_search_beam_width == 0)
+                    || (parameter->min_search_beam_width > parameter->search_beam_width)
+                    || (parameter->search_beam_width > MOI_MAX_SEARCH_BEAM_WIDTH)
+                    || (parameter->min_search_depth == 0)
+                    || (parameter->min_search_depth > parameter->search_depth)
+                    || (parameter->search_depth > MOI_MAX_SEARCH_DEPTH))) {
+            return MOI_APIRESULT_INVALID_FORMAT;
+        }
+        /* ポートフォリオ符号化の設定数・探索幅・深さが範囲外
+        * 設定毎に探索幅・深さが決まるので、適応探索・時間予算とは併用できない */
+        if (parameter->portfolio_size > 0) {
+            uint32_t k;
+            if ((parameter->portfolio_size > MOI_MAX_PORTFOLIO_SIZE)
+                    || parameter->search_adaptive || (parameter->time_budget > 0)) {
+                return MOI_APIRESULT_INVALID_FORMAT;
+            }
+            for (k = 0; k < parameter->portfolio_size; k++) {
+                if ((parameter->portfolio_beam_width[k] == 0)
+                        || (parameter->portfolio_beam_width[k] > MOI_MAX_SEARCH_BEAM_WIDTH)
+                        || (parameter->portfolio_depth[k] == 0)
+                        || (parameter->portfolio_depth[k] > MOI_MAX_SEARCH_DEPTH)) {
+                    return MOI_APIRESULT_INVALID_FORMAT;
+                }
+            }
+        }
+        break;
+    case MOI_SEARCH_METHOD_TRELLIS:
+        /* 状態数が範囲外 */
+        if ((parameter->trellis_num_states == 0)
+                || (parameter->trellis_num_states > MOI_MAX_TRELLIS_NUM_STATES)) {
+            return MOI_APIRESULT_INVALID_FORMAT;
+        }
+        /* ポートフォリオ符号化はビームサーチのみ */
+        if (parameter->portfolio_size > 0) {
+            return MOI_APIRESULT_INVALID_FORMAT;
+        }
+        break;
+    default:
+        return MOI_APIRESULT_INVALID_FORMAT;
+    }
+
+    /* 探索するブロックの割合が範囲外 */
+    if (parameter->refine_percent > 100) {
+        return MOI_APIRESULT_INVALID_FORMAT;
+    }
+
+    /* 局所探索は時間予算の期限を見ずに反復するので、時間予算とは併用できない */
+    if ((parameter->local_search_sweeps > 0) && (parameter->time_budget > 0)) {
+        return MOI_APIRESULT_INVALID_FORMAT;
+    }
+
     /* パラメータ設定がおかしくないか、ヘッダへの変換を通じて確認 */
     /* 総サンプル数はダミー値を入れる */
     if (MOIEncoder_ConvertParameterToHeader(parameter, 0, &tmp_header) != MOI_ERROR_OK) {
         return MOI_APIRESULT_INVALID_FORMAT;
     }
 
-    /* パラメータ設定 */
+    /* 探索結果が変わりうるパラメータが変わった場合はブロックキャッシュを無効化 */
+    if (!encoder->set_parameter || !MOIEncoder_IsSameSearchParameter(&(encoder->encode_parameter), parameter)) {
+        uint32_t i;
+        for (i = 0; i < encoder->max_num_threads; i++) {
+            MOIBlockCache_Clear(&(encoder->thread_encoder[i]->block_cache));
+        }
+    }
+
+    /* パラメータ設定（適応しない場合は常に最大の探索幅・深さを使う） */
     encoder->encode_parameter = (*parameter);
+    if (encoder->encode_parameter.num_threads == 0) {
+        encoder->encode_parameter.num_threads = 1;
+    }
+    encoder->search_beam_width = parameter->search_beam_width;
+    encoder->search_depth = parameter->search_depth;
+    encoder->budget_effort = MOIENCODER_NUM_EFFORT_LEVELS;
+    encoder->deadline = 0;
+    encoder->reference_only = 0;
+    MOIEncoder_ResetInitSeed(encoder);
 
     /* パラメータ設定済みフラグを立てる */
     encoder->set_parameter = 1;
 
+    /* スレッド毎のエンコーダにも同じパラメータを設定 */
+    {
+        uint32_t i;
+        for (i = 1; i < encoder->max_num_threads; i++) {
+            struct MOIEncoder *thread_encoder = encoder->thread_encoder[i];
+            thread_encoder->encode_parameter = encoder->encode_parameter;
+            thread_encoder->search_beam_width = parameter->search_beam_width;
+            thread_encoder->search_depth = parameter->search_depth;
+            thread_encoder->budget_effort = MOIENCODER_NUM_EFFORT_LEVELS;
+            thread_encoder->deadline = 0;
+            thread_encoder->reference_only = 0;
+            MOIEncoder_ResetInitSeed(thread_encoder);
+            thread_encoder->set_parameter = 1;
+        }
+    }
+
+    /* 統計情報のリセット */
+    {
+        uint32_t i;
+        for (i = 0; i < encoder->max_num_threads; i++) {
+            memset(&(encoder->thread_encoder[i]->statistics), 0, sizeof(struct MOIEncodeStatistics));
+        }
+    }
+
     return MOI_APIRESULT_OK;
 }
 
+/* 2パス符号化: 1サンプルあたりの参照誤差をヒストグラムの階級に変換（誤差に対して単調非減少） */
+static uint32_t MOIEncoder_CalculateRefineBucket(MOICost mean_cost)
+{
+    uint32_t bits, fraction;
+    MOICost tmp;
+
+    MOI_ASSERT(mean_cost >= 0);
+
+    if (mean_cost == 0) {
+        return 0;
+    }
+
+    /* ビット長と、最上位ビットに続く端数ビットで階級を決める */
+    for (bits = 0, tmp = mean_cost; tmp > 0; bits++) {
+        tmp >>= 1;
+    }
+    if (bits > (MOIENCODER_REFINE_FRACTION_BITS + 1)) {
+        fraction = (uint32_t)(mean_cost >> (bits - 1 - MOIENCODER_REFINE_FRACTION_BITS));
+    } else {
+        fraction = (uint32_t)(mean_cost << (MOIENCODER_REFINE_FRACTION_BITS + 1 - bits));
+    }
+    fraction &= (1 << MOIENCODER_REFINE_FRACTION_BITS) - 1;
+
+    MOI_ASSERT(((bits << MOIENCODER_REFINE_FRACTION_BITS) | fraction) < MOIENCODER_REFINE_NUM_BUCKETS);
+    return (bits << MOIENCODER_REFINE_FRACTION_BITS) | fraction;
+}
+
+/* 2パス符号化: ブロックの全チャンネルをIMA-ADPCMで符号化した場合の合計コスト */
+static MOICost MOIEncoder_CalculateReferenceCost(
+        const int16_t *const *input, uint32_t num_channels, uint32_t num_samples)
+{
+    uint32_t ch;
+    MOICost cost = 0;
+
+    MOI_ASSERT(input != NULL);
+
+    for (ch = 0; ch < num_channels; ch++) {
+        cost += MOIEncoder_EncodeSamplesIMAADPCM(input[ch], num_samples, NULL);
+    }
+
+    return cost;
+}
+
+/* 2パス符号化: 1パス目の参照誤差を置けるブロックか判定
+* 参照誤差はブロックの出力先の先頭に置き、そのブロックをエンコードする直前に読み出す（出力で上書きされる） */
+#define MOIENCODER_CAN_STORE_REFERENCE_COST(offset, data_size) \
+    (((offset) < (data_size)) && (((data_size) - (offset)) >= sizeof(MOICost)))
+
+/* 2パス符号化: 合計コストから1サンプルあたりの参照誤差を計算 */
+#define MOIENCODER_REFERENCE_MEAN_COST(cost, num_channels, num_samples)    ((cost) / MOI_MAX_VAL(1, (MOICost)(num_channels) * ((MOICost)(num_samples) - 1)))
+
+/* 担当するブロックを順にエンコード */
+static void MOIEncoder_EncodeBlocks(struct MOIEncodeBlocksThreadArgument *arg)
+{
+    uint32_t i, ch, block, progress, offset, write_size, num_encode_samples;
+    const int16_t *input_ptr[MOI_MAX_NUM_CHANNELS];
+    const struct IMAADPCMWAVHeader *header;
+    const struct MOIEncodeParameter *parameter;
+    struct MOIEncodeStatistics *statistics;
+    MOICost reference_cost = 0;
+    uint64_t start_time = 0;
+
+    MOI_ASSERT(arg != NULL);
+
+    parameter = &(arg->encoder->encode_parameter);
+    statistics = &(arg->encoder->statistics);
+    header = arg->header;
+    arg->output_size = 0;
+    arg->result = MOI_APIRESULT_OK;
+
+    for (i = 0; ; i++) {
+        /* 担当セグメント内のブロックを順に処理 */
+        block = (arg->start_segment + (i / arg->segment_num_blocks) * arg->segment_stride) * arg->segment_num_blocks
+            + (i % arg->segment_num_blocks);
+
+        /* セグメントの先頭では直前ブロックの情報を使わない */
+        if ((i % arg->segment_num_blocks) == 0) {
+            MOIEncoder_ResetInitSeed(arg->encoder);
+        }
+
+        /* 終端判定（以降のセグメントも終端を越える） */
+        progress = block * header->num_samples_per_block;
+        if (progress >= arg->num_samples) {
+            break;
+        }
+
+        /* エンコードサンプル数の確定 */
+        num_encode_samples = MOI_MIN_VAL(header->num_samples_per_block, arg->num_samples - progress);
+        /* サンプル参照位置のセット */
+        for (ch = 0; ch < header->num_channels; ch++) {
+            input_ptr[ch] = &(arg->input[ch][progress]);
+        }
+
+        /* 末尾以外のブロックはブロックサイズ丁度で書き出されるので、書き出し位置が決まる */
+        offset = block * header->block_size;
+        if (offset >= arg->data_size) {
+            arg->result = MOI_APIRESULT_INSUFFICIENT_DATA;
+            return;
+        }
+
+        /* 2パス符号化: 参照誤差が大きいブロックだけ探索する */
+        if (MOIENCODER_IS_TWO_PASS(parameter)) {
+            MOICost mean_cost;
+            /* 1パス目で計算済みならそれを使う */
+            if (arg->reference_cost_stored && MOIENCODER_CAN_STORE_REFERENCE_COST(offset, arg->data_size)) {
+                memcpy(&reference_cost, arg->data + offset, sizeof(MOICost));
+            } else {
+                reference_cost = MOIEncoder_CalculateReferenceCost(input_ptr, header->num_channels, num_encode_samples);
+            }
+            mean_cost = MOIENCODER_REFERENCE_MEAN_COST(reference_cost, header->num_channels, num_encode_samples);
+            arg->encoder->reference_only
+                = ((MOIEncoder_CalculateRefineBucket(mean_cost) < arg->refine_min_bucket)
+                    && ((parameter->refine_threshold == 0) || (mean_cost <= (MOICost)parameter->refine_threshold))) ? 1 : 0;
+            statistics->reference_total_cost += (uint64_t)reference_cost;
+            statistics->reference_num_samples += (uint64_t)header->num_channels * (num_encode_samples - 1);
+            if (!arg->encoder->reference_only) {
+                start_time = MOIEncoder_GetTimeMicroseconds();
+            }
+        }
+
+        /* ブロックエンコード */
+        if ((arg->result = MOIEncoder_EncodeBlock(arg->encoder,
+                        input_ptr, num_encode_samples,
+                        arg->data + offset, arg->data_size - offset, &write_size)) != MOI_APIRESULT_OK) {
+            arg->encoder->reference_only = 0;
+            return;
+        }
+        MOI_ASSERT((write_size == header->block_size) || (num_encode_samples < header->num_samples_per_block));
+
+        /* 2パス符号化: 探索による誤差の改善と所要時間を記録 */
+        if (MOIENCODER_IS_TWO_PASS(parameter) && !arg->encoder->reference_only) {
+            MOICost refined_cost = 0;
+            statistics->refine_time += MOIEncoder_GetTimeMicroseconds() - start_time;
+            for (ch = 0; ch < header->num_channels; ch++) {
+                refined_cost += MOIEncoder_CalculateCodeCost(input_ptr[ch], num_encode_samples,
+                        arg->encoder->best_init_stepsize_index[ch], arg->encoder->best_code[ch]);
+            }
+            statistics->num_refined_blocks++;
+            statistics->refined_reference_cost += (uint64_t)reference_cost;
+            statistics->refined_cost += (uint64_t)refined_cost;
+        }
+
+        /* 進捗更新 */
+        arg->output_size += write_size;
+    }
+
+    arg->encoder->reference_only = 0;
+    MOIEncoder_ResetInitSeed(arg->encoder);
+}
+
+/* 2パス符号化: 全ブロックの参照誤差から、探索するブロックの階級の下限を決める
+* 参照誤差が大きい方から指定割合のブロックを含む最小の階級を返す（同じ階級のブロックは全て探索する）
+* 計算した参照誤差は2パス目で再計算しないよう各ブロックの出力先に置く */
+static uint32_t MOIEncoder_CalculateRefineMinBucket(
+        const struct MOIEncodeParameter *parameter, const struct IMAADPCMWAVHeader *header,
+        const int16_t *const *input, uint32_t num_samples, uint8_t *data, uint32_t data_size)
+{
+    uint32_t ch, block, bucket, num_blocks, num_refine_blocks, count;
+    uint32_t histogram[MOIENCODER_REFINE_NUM_BUCKETS];
+    const int16_t *input_ptr[MOI_MAX_NUM_CHANNELS];
+
+    MOI_ASSERT((parameter != NULL) && (header != NULL) && (input != NULL));
+
+    if (parameter->refine_percent == 0) {
+        return MOIENCODER_REFINE_NUM_BUCKETS;
+    }
+
+    /* 1パス目: 全ブロックをIMA-ADPCMで符号化して参照誤差のヒストグラムを作る */
+    memset(histogram, 0, sizeof(histogram));
+    num_blocks = 0;
+    for (block = 0; block * header->num_samples_per_block < num_samples; block++) {
+        const uint32_t progress = block * header->num_samples_per_block;
+        const uint32_t num_encode_samples = MOI_MIN_VAL(header->num_samples_per_block, num_samples - progress);
+        const uint32_t offset = block * header->block_size;
+        MOICost cost;
+        for (ch = 0; ch < header->num_channels; ch++) {
+            input_ptr[ch] = &(input[ch][progress]);
+        }
+        cost = MOIEncoder_CalculateReferenceCost(input_ptr, header->num_channels, num_encode_samples);
+        if (MOIENCODER_CAN_STORE_REFERENCE_COST(offset, data_size)) {
+            memcpy(data + offset, &cost, sizeof(MOICost));
+        }
+        histogram[MOIEncoder_CalculateRefineBucket(
+                MOIENCODER_REFERENCE_MEAN_COST(cost, header->num_channels, num_encode_samples))]++;
+        num_blocks++;
+    }
+
+    /* 誤差の大きい階級から指定割合（切り上げ）に達するまで数える */
+    num_refine_blocks = (uint32_t)(((uint64_t)num_blocks * parameter->refine_percent + 99) / 100);
+    count = 0;
+    for (bucket = MOIENCODER_REFINE_NUM_BUCKETS; bucket > 0; bucket--) {
+        if (count >= num_refine_blocks) {
+            break;
+        }
+        count += histogram[bucket - 1];
+    }
+
+    return bucket;
+}
+
+#if defined(MOI_WITHOUT_THREADS)
+#elif defined(_WIN32)
+/* スレッドのエントリ関数 */
+static DWORD WINAPI MOIEncoder_EncodeBlocksThreadEntry(LPVOID arg)
+{
+    MOIEncoder_EncodeBlocks((struct MOIEncodeBlocksThreadArgument *)arg);
+    return 0;
+}
+#else
+/* スレッドのエントリ関数 */
+static void *MOIEncoder_EncodeBlocksThreadEntry(void *arg)
+{
+    MOIEncoder_EncodeBlocks((struct MOIEncodeBlocksThreadArgument *)arg);
+    return NULL;
+}
+#endif
+
 /* ヘッダ含めファイル全体をエンコード */
 MOIApiResult MOIEncoder_EncodeWhole(
         struct MOIEncoder *encoder,
@@ -778,10 +3119,9 @@ MOIApiResult MOIEncoder_EncodeWhole(
         uint8_t *data, uint32_t data_size, uint32_t *output_size)
 {
     MOIApiResult ret;
-    uint32_t progress, ch, write_size, write_offset, num_encode_samples;
-    uint8_t *data_pos;
-    const int16_t *input_ptr[MOI_MAX_NUM_CHANNELS];
+    uint32_t i, num_threads, write_offset;
     struct IMAADPCMWAVHeader header = { 0, };
+    struct MOIEncodeBlocksThreadArgument thread_arg[MOI_MAX_NUM_THREADS];
 
     /* 引数チェック */
     if ((encoder == NULL) || (input == NULL)
@@ -794,46 +3134,152 @@ MOIApiResult MOIEncoder_EncodeWhole(
         return MOI_APIRESULT_PARAMETER_NOT_SET;
     }
 
-    /* 書き出し位置を取得 */
-    data_pos = data;
-
     /* エンコードパラメータをヘッダに変換 */
     if (MOIEncoder_ConvertParameterToHeader(&(encoder->encode_parameter), num_samples, &header) != MOI_ERROR_OK) {
         return MOI_APIRESULT_INVALID_FORMAT;
     }
 
     /* ヘッダエンコード */
-    if ((ret = MOIEncoder_EncodeHeader(&header, data_pos, data_size)) != MOI_APIRESULT_OK) {
+    if ((ret = MOIEncoder_EncodeHeader(&header, data, data_size)) != MOI_APIRESULT_OK) {
         return ret;
     }
 
-    progress = 0;
-    write_offset = MOIENCODER_HEADER_SIZE;
-    data_pos = data + MOIENCODER_HEADER_SIZE;
-    while (progress < num_samples) {
-        /* エンコードサンプル数の確定 */
-        num_encode_samples = MOI_MIN_VAL(header.num_samples_per_block, num_samples - progress);
-        /* サンプル参照位置のセット */
-        for (ch = 0; ch < header.num_channels; ch++) {
-            input_ptr[ch] = &input[ch][progress];
+    /* スレッド毎に担当セグメント（連続するブロックの組）を割り当て */
+    /* ブロックは同じセグメント内の直前ブロックにしか依存せず、セグメントの先頭で直前ブロックの情報を
+    * MOIEncoder_ResetInitSeedで初期化する。セグメント境界はスレッド数に依らず固定なので出力は一致する */
+    num_threads = encoder->encode_parameter.num_threads;
+    MOI_ASSERT((num_threads > 0) && (num_threads <= encoder->max_num_threads));
+    MOI_ASSERT(num_threads <= MOI_MAX_NUM_THREADS);
+    for (i = 0; i < num_threads; i++) {
+        struct MOIEncodeBlocksThreadArgument *arg = &thread_arg[i];
+        arg->encoder = encoder->thread_encoder[i];
+        arg->input = input;
+        arg->num_samples = num_samples;
+        arg->header = &header;
+        arg->data = data + MOIENCODER_HEADER_SIZE;
+        arg->data_size = data_size - MOIENCODER_HEADER_SIZE;
+        arg->start_segment = i;
+        arg->segment_stride = num_threads;
+        /* 直前ブロックの情報を使う場合は連続するブロックを同じスレッドで処理 */
+        arg->segment_num_blocks
+            = (encoder->encode_parameter.init_search_window > 0) ? MOIENCODER_SEGMENT_NUM_BLOCKS : 1;
+        arg->refine_min_bucket = MOIENCODER_REFINE_NUM_BUCKETS;
+        arg->reference_cost_stored = 0;
+    }
+
+    /* 2パス符号化: 探索するブロックの参照誤差の下限を決める */
+    if (MOIENCODER_IS_TWO_PASS(&(encoder->encode_parameter))) {
+        const uint32_t refine_min_bucket = MOIEncoder_CalculateRefineMinBucket(&(encoder->encode_parameter),
+                &header, input, num_samples, data + MOIENCODER_HEADER_SIZE, data_size - MOIENCODER_HEADER_SIZE);
+        for (i = 0; i < num_threads; i++) {
+            thread_arg[i].refine_min_bucket = refine_min_bucket;
+            thread_arg[i].reference_cost_stored = (encoder->encode_parameter.refine_percent > 0) ? 1 : 0;
         }
+    }
 
-        /* ブロックエンコード */
-        if ((ret = MOIEncoder_EncodeBlock(encoder,
-                        input_ptr, num_encode_samples,
-                        data_pos, data_size - write_offset, &write_size)) != MOI_APIRESULT_OK) {
-            return ret;
+    /* ブロックエンコード */
+    if (num_threads == 1) {
+        MOIEncoder_EncodeBlocks(&thread_arg[0]);
+    } else {
+#if defined(MOI_WITHOUT_THREADS)
+        for (i = 0; i < num_threads; i++) {
+            MOIEncoder_EncodeBlocks(&thread_arg[i]);
+        }
+#else
+        MOIThread thread[MOI_MAX_NUM_THREADS];
+        uint8_t created[MOI_MAX_NUM_THREADS];
+        /* 先頭以外はスレッドを立ててエンコード（作成に失敗したら自スレッドで処理） */
+        for (i = 1; i < num_threads; i++) {
+#if defined(_WIN32)
+            thread[i] = CreateThread(NULL, 0, MOIEncoder_EncodeBlocksThreadEntry, &thread_arg[i], 0, NULL);
+            created[i] = (thread[i] != NULL) ? 1 : 0;
+#else
+            created[i] = (pthread_create(&thread[i], NULL, MOIEncoder_EncodeBlocksThreadEntry, &thread_arg[i]) == 0) ? 1 : 0;
+#endif
+            if (!created[i]) {
+                MOIEncoder_EncodeBlocks(&thread_arg[i]);
+            }
+        }
+        MOIEncoder_EncodeBlocks(&thread_arg[0]);
+        /* 全スレッドの終了を待つ */
+        for (i = 1; i < num_threads; i++) {
+            if (created[i]) {
+#if defined(_WIN32)
+                WaitForSingleObject(thread[i], INFINITE);
+                CloseHandle(thread[i]);
+#else
+                pthread_join(thread[i], NULL);
+#endif
+            }
         }
+#endif
+    }
 
-        /* 進捗更新 */
-        data_pos += write_size;
-        write_offset += write_size;
-        progress += num_encode_samples;
-        MOI_ASSERT(write_size <= header.block_size);
-        MOI_ASSERT(write_offset <= data_size);
+    /* 結果の集計 */
+    write_offset = MOIENCODER_HEADER_SIZE;
+    for (i = 0; i < num_threads; i++) {
+        if (thread_arg[i].result != MOI_APIRESULT_OK) {
+            return thread_arg[i].result;
+        }
+        write_offset += thread_arg[i].output_size;
     }
+    MOI_ASSERT(write_offset <= data_size);
 
     /* 成功終了 */
     (*output_size) = write_offset;
     return MOI_APIRESULT_OK;
 }
+
+/* エンコード統計情報の取得（全スレッドの合計） */
+MOIApiResult MOIEncoder_GetEncodeStatistics(
+        const struct MOIEncoder *encoder, struct MOIEncodeStatistics *statistics)
+{
+    uint32_t i, j;
+
+    /* 引数チェック */
+    if ((encoder == NULL) || (statistics == NULL)) {
+        return MOI_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* スレッド毎の統計を合算 */
+    memset(statistics, 0, sizeof(struct MOIEncodeStatistics));
+    for (i = 0; i < encoder->max_num_threads; i++) {
+        const struct MOIEncodeStatistics *thread_statistics = &(encoder->thread_encoder[i]->statistics);
+        statistics->search_num_nodes += thread_statistics->search_num_nodes;
+        statistics->search_num_bound_prunes += thread_statistics->search_num_bound_prunes;
+        statistics->search_cache_hits += thread_statistics->search_cache_hits;
+        statistics->search_cache_misses += thread_statistics->search_cache_misses;
+        statistics->search_num_skipped_expansions += thread_statistics->search_num_skipped_expansions;
+        statistics->search_num_selected_candidates += thread_statistics->search_num_selected_candidates;
+        statistics->search_num_reference_prunes += thread_statistics->search_num_reference_prunes;
+        statistics->num_searched_blocks += thread_statistics->num_searched_blocks;
+        statistics->total_search_beam_width += thread_statistics->total_search_beam_width;
+        statistics->total_search_depth += thread_statistics->total_search_depth;
+        statistics->num_deadline_fallbacks += thread_statistics->num_deadline_fallbacks;
+        statistics->num_forced_trace_commits += thread_statistics->num_forced_trace_commits;
+        statistics->num_constant_blocks += thread_statistics->num_constant_blocks;
+        statistics->block_cache_hits += thread_statistics->block_cache_hits;
+        statistics->init_search_num_evaluations += thread_statistics->init_search_num_evaluations;
+        statistics->block_cache_misses += thread_statistics->block_cache_misses;
+        statistics->num_constant_run_samples += thread_statistics->num_constant_run_samples;
+        statistics->num_refined_blocks += thread_statistics->num_refined_blocks;
+        statistics->reference_total_cost += thread_statistics->reference_total_cost;
+        statistics->reference_num_samples += thread_statistics->reference_num_samples;
+        statistics->refined_reference_cost += thread_statistics->refined_reference_cost;
+        statistics->refined_cost += thread_statistics->refined_cost;
+        statistics->refine_time += thread_statistics->refine_time;
+        statistics->local_search_num_sweeps += thread_statistics->local_search_num_sweeps;
+        statistics->local_search_num_improvements += thread_statistics->local_search_num_improvements;
+        statistics->local_search_num_samples += thread_statistics->local_search_num_samples;
+        statistics->local_search_initial_cost += thread_statistics->local_search_initial_cost;
+        statistics->local_search_final_cost += thread_statistics->local_search_final_cost;
+        statistics->local_search_time += thread_statistics->local_search_time;
+        statistics->portfolio_num_runs += thread_statistics->portfolio_num_runs;
+        statistics->portfolio_num_aborts += thread_statistics->portfolio_num_aborts;
+        for (j = 0; j < MOI_MAX_PORTFOLIO_SIZE; j++) {
+            statistics->portfolio_num_wins[j] += thread_statistics->portfolio_num_wins[j];
+        }
+    }
+
+    return MOI_APIRESULT_OK;
+}
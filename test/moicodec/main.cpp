@@ -16,6 +16,9 @@ extern "C" {
 #define MOI_SetValidEncoderConfig(p_config) {\
     struct MOIEncoderConfig *p__config = p_config;\
     p__config->max_block_size = 256;\
+    p__config->max_num_threads = 1;\
+    p__config->max_search_cache_size = 64 * 1024;\
+    p__config->max_block_cache_size = 0;\
 }
 
 /* 有効なヘッダをセット */
@@ -38,8 +41,21 @@ extern "C" {
     p__param->sampling_rate = 8000;\
     p__param->bits_per_sample = MOI_BITS_PER_SAMPLE;\
     p__param->block_size = 256;\
+    p__param->search_method = MOI_SEARCH_METHOD_BEAM;\
     p__param->search_beam_width = 2;\
     p__param->search_depth = 2;\
+    p__param->search_use_lower_bound = 0;\
+    p__param->search_adaptive = 0;\
+    p__param->min_search_beam_width = 1;\
+    p__param->min_search_depth = 1;\
+    p__param->time_budget = 0;\
+    p__param->refine_percent = 0;\
+    p__param->refine_threshold = 0;\
+    p__param->init_search_window = 0;\
+    p__param->local_search_sweeps = 0;\
+    p__param->portfolio_size = 0;\
+    p__param->trellis_num_states = 8;\
+    p__param->num_threads = 1;\
 }
 
 /* ヘッダエンコードデコードテスト */
@@ -361,6 +377,58 @@ TEST(MOIDecoder, DecodeTest)
                 MOIDecoderTest_CheckDecodeResult(
                     "unit_impulse_adpcm_ffmpeg.wav", "unit_impulse_adpcm_ffmpeg_decoded.wav"));
     }
+
+    /* ブロックヘッダのステップサイズインデックスが範囲外ならば不正なフォーマット */
+    {
+        static const char *test_filenames[] = { "sin300Hz_mono_adpcm_ffmpeg.wav", "sin300Hz_adpcm_ffmpeg.wav" };
+        static const uint8_t invalid_indices[] = { 89, 127, 0x80, 0xFF };
+        uint32_t i, j, ch;
+
+        for (i = 0; i < sizeof(test_filenames) / sizeof(test_filenames[0]); i++) {
+            FILE        *fp;
+            uint8_t     *data;
+            int16_t     *output[2];
+            struct stat fstat;
+            uint32_t    data_size;
+            struct IMAADPCMWAVHeader header;
+            struct MOIDecoder *decoder;
+
+            fp = fopen(test_filenames[i], "rb");
+            assert(fp != NULL);
+            stat(test_filenames[i], &fstat);
+            data_size = (uint32_t)fstat.st_size;
+            data = (uint8_t *)malloc(data_size);
+            fread(data, sizeof(uint8_t), data_size, fp);
+            fclose(fp);
+
+            ASSERT_EQ(MOI_APIRESULT_OK, MOIDecoder_DecodeHeader(data, data_size, &header));
+            for (ch = 0; ch < header.num_channels; ch++) {
+                output[ch] = (int16_t *)malloc(sizeof(int16_t) * header.num_samples);
+            }
+            decoder = MOIDecoder_Create(NULL, 0);
+
+            /* 各チャンネルの先頭ブロックのインデックスを書き換え（ブロックヘッダはチャンネル毎に4byte、インデックスは3byte目） */
+            for (ch = 0; ch < header.num_channels; ch++) {
+                uint8_t *index_pos = &data[header.header_size + 4 * ch + 2];
+                const uint8_t original = *index_pos;
+                for (j = 0; j < sizeof(invalid_indices) / sizeof(invalid_indices[0]); j++) {
+                    *index_pos = invalid_indices[j];
+                    EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIDecoder_DecodeWhole(decoder,
+                                data, data_size, output, header.num_channels, header.num_samples));
+                }
+                *index_pos = 88;
+                EXPECT_EQ(MOI_APIRESULT_OK, MOIDecoder_DecodeWhole(decoder,
+                            data, data_size, output, header.num_channels, header.num_samples));
+                *index_pos = original;
+            }
+
+            MOIDecoder_Destroy(decoder);
+            for (ch = 0; ch < header.num_channels; ch++) {
+                free(output[ch]);
+            }
+            free(data);
+        }
+    }
 }
 
 /* エンコードハンドル作成破棄テスト */
@@ -379,6 +447,77 @@ TEST(MOIEncoder, CreateDestroyTest)
         config.max_block_size = 0;
         work_size = MOIEncoder_CalculateWorkSize(&config);
         EXPECT_TRUE(work_size < 0);
+
+        MOI_SetValidEncoderConfig(&config);
+        config.max_num_threads = MOI_MAX_NUM_THREADS + 1;
+        work_size = MOIEncoder_CalculateWorkSize(&config);
+        EXPECT_TRUE(work_size < 0);
+
+        MOI_SetValidEncoderConfig(&config);
+        config.max_search_cache_size = MOI_MAX_SEARCH_CACHE_SIZE + 1;
+        work_size = MOIEncoder_CalculateWorkSize(&config);
+        EXPECT_TRUE(work_size < 0);
+
+        MOI_SetValidEncoderConfig(&config);
+        config.max_block_cache_size = MOI_MAX_BLOCK_CACHE_SIZE + 1;
+        work_size = MOIEncoder_CalculateWorkSize(&config);
+        EXPECT_TRUE(work_size < 0);
+
+        /* 1スレッドあたりは表せても、スレッド数倍するとint32_tで表せない */
+        MOI_SetValidEncoderConfig(&config);
+        config.max_block_cache_size = MOI_MAX_BLOCK_CACHE_SIZE;
+        work_size = MOIEncoder_CalculateWorkSize(&config);
+        EXPECT_TRUE(work_size > 0);
+        config.max_num_threads = MOI_MAX_NUM_THREADS;
+        config.max_search_cache_size = MOI_MAX_SEARCH_CACHE_SIZE;
+        work_size = MOIEncoder_CalculateWorkSize(&config);
+        EXPECT_TRUE(work_size < 0);
+    }
+
+    /* ブロックキャッシュ領域の割当て */
+    {
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+
+        /* 1エントリに満たなければ無効 */
+        MOI_SetValidEncoderConfig(&config);
+        config.max_block_cache_size = (uint32_t)MOIBLOCKCACHE_ENTRY_SIZE(config.max_block_size) - 1;
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        EXPECT_TRUE(encoder != NULL);
+        EXPECT_TRUE(encoder->block_cache.entry == NULL);
+        MOIEncoder_Destroy(encoder);
+
+        /* エントリ数は指定サイズに収まる最大の2の冪 */
+        MOI_SetValidEncoderConfig(&config);
+        config.max_block_cache_size = 5 * (uint32_t)MOIBLOCKCACHE_ENTRY_SIZE(config.max_block_size);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        EXPECT_TRUE(encoder != NULL);
+        EXPECT_TRUE(encoder->block_cache.entry != NULL);
+        EXPECT_EQ(4, encoder->block_cache.num_entries);
+        MOIEncoder_Destroy(encoder);
+    }
+
+    /* 先読み探索キャッシュ領域の割当て */
+    {
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+
+        /* キャッシュ無効 */
+        MOI_SetValidEncoderConfig(&config);
+        config.max_search_cache_size = 0;
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        EXPECT_TRUE(encoder != NULL);
+        EXPECT_TRUE(encoder->search_cache.entry == NULL);
+        MOIEncoder_Destroy(encoder);
+
+        /* エントリ数は指定サイズに収まる最大の2の冪 */
+        MOI_SetValidEncoderConfig(&config);
+        config.max_search_cache_size = 3 * 1024 * sizeof(struct MOISearchCacheEntry);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        EXPECT_TRUE(encoder != NULL);
+        EXPECT_TRUE(encoder->search_cache.entry != NULL);
+        EXPECT_EQ(2048, encoder->search_cache.num_entries);
+        MOIEncoder_Destroy(encoder);
     }
 
     /* ワーク領域渡しによるハンドル作成（成功例） */
@@ -417,6 +556,46 @@ TEST(MOIEncoder, CreateDestroyTest)
         MOIEncoder_Destroy(encoder);
     }
 
+    /* 最大スレッド数0は1として扱う */
+    {
+        int32_t work_size;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+
+        MOI_SetValidEncoderConfig(&config);
+        config.max_num_threads = 1;
+        work_size = MOIEncoder_CalculateWorkSize(&config);
+        config.max_num_threads = 0;
+        EXPECT_EQ(work_size, MOIEncoder_CalculateWorkSize(&config));
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        EXPECT_TRUE(encoder != NULL);
+        EXPECT_EQ(1, encoder->max_num_threads);
+
+        MOIEncoder_Destroy(encoder);
+    }
+
+    /* 複数スレッド用のハンドル作成（成功例） */
+    {
+        uint32_t i;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+
+        MOI_SetValidEncoderConfig(&config);
+        config.max_num_threads = 4;
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        EXPECT_TRUE(encoder != NULL);
+        EXPECT_EQ(4, encoder->max_num_threads);
+        EXPECT_TRUE(encoder->thread_encoder[0] == encoder);
+        for (i = 1; i < config.max_num_threads; i++) {
+            EXPECT_TRUE(encoder->thread_encoder[i] != NULL);
+            EXPECT_TRUE(encoder->thread_encoder[i] != encoder);
+            EXPECT_TRUE(encoder->thread_encoder[i]->work == NULL);
+            EXPECT_EQ(config.max_block_size, encoder->thread_encoder[i]->max_block_size);
+        }
+
+        MOIEncoder_Destroy(encoder);
+    }
+
     /* ワーク領域渡しによるハンドル作成（失敗ケース） */
     {
         void *work;
@@ -446,6 +625,14 @@ TEST(MOIEncoder, CreateDestroyTest)
         encoder = MOIEncoder_Create(&config, work, work_size);
         EXPECT_TRUE(encoder == NULL);
 
+        /* ワークサイズがint32_tで表せない */
+        MOI_SetValidEncoderConfig(&config);
+        config.max_num_threads = MOI_MAX_NUM_THREADS;
+        config.max_block_cache_size = MOI_MAX_BLOCK_CACHE_SIZE;
+        config.max_search_cache_size = MOI_MAX_SEARCH_CACHE_SIZE;
+        encoder = MOIEncoder_Create(&config, work, INT32_MAX);
+        EXPECT_TRUE(encoder == NULL);
+
         free(work);
     }
 
@@ -459,6 +646,13 @@ TEST(MOIEncoder, CreateDestroyTest)
         encoder = MOIEncoder_Create(&config, NULL, 0);
         EXPECT_TRUE(encoder == NULL);
 
+        MOI_SetValidEncoderConfig(&config);
+        config.max_num_threads = MOI_MAX_NUM_THREADS;
+        config.max_block_cache_size = MOI_MAX_BLOCK_CACHE_SIZE;
+        config.max_search_cache_size = MOI_MAX_SEARCH_CACHE_SIZE;
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        EXPECT_TRUE(encoder == NULL);
+
         MOIEncoder_Destroy(encoder);
     }
 }
@@ -480,6 +674,12 @@ TEST(MOIEncoder, SetEncodeParameterTest)
         EXPECT_EQ(1, encoder->set_parameter);
         EXPECT_EQ(0, memcmp(&(encoder->encode_parameter), &param, sizeof(struct MOIEncodeParameter)));
 
+        /* スレッド数0は1として扱う */
+        MOI_SetValidParameter(&param);
+        param.num_threads = 0;
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        EXPECT_EQ(1, encoder->encode_parameter.num_threads);
+
         MOIEncoder_Destroy(encoder);
     }
 
@@ -510,13 +710,59 @@ TEST(MOIEncoder, SetEncodeParameterTest)
         param.block_size = param.num_channels * 4;
         EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
 
+        /* スレッド数が範囲外 */
+        MOI_SetValidParameter(&param);
+        param.num_threads = config.max_num_threads + 1;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+
+        /* 探索手法が不正 */
+        MOI_SetValidParameter(&param);
+        param.search_method = (MOISearchMethod)-1;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+
+        /* トレリス探索の状態数が範囲外 */
+        MOI_SetValidParameter(&param);
+        param.search_method = MOI_SEARCH_METHOD_TRELLIS;
+        param.trellis_num_states = 0;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        MOI_SetValidParameter(&param);
+        param.search_method = MOI_SEARCH_METHOD_TRELLIS;
+        param.trellis_num_states = MOI_MAX_TRELLIS_NUM_STATES + 1;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+
+        /* 適応探索の探索幅・深さの範囲が不正 */
+        MOI_SetValidParameter(&param);
+        param.search_adaptive = 1;
+        param.min_search_beam_width = 0;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        MOI_SetValidParameter(&param);
+        param.search_adaptive = 1;
+        param.min_search_beam_width = param.search_beam_width + 1;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        MOI_SetValidParameter(&param);
+        param.search_adaptive = 1;
+        param.search_beam_width = MOI_MAX_SEARCH_BEAM_WIDTH + 1;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        MOI_SetValidParameter(&param);
+        param.search_adaptive = 1;
+        param.min_search_depth = 0;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        MOI_SetValidParameter(&param);
+        param.search_adaptive = 1;
+        param.min_search_depth = param.search_depth + 1;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        MOI_SetValidParameter(&param);
+        param.search_adaptive = 1;
+        param.search_depth = MOI_MAX_SEARCH_DEPTH + 1;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+
         MOIEncoder_Destroy(encoder);
     }
 }
 
-/* エンコード→デコードテスト 成功時は1, 失敗時は0を返す */
-static uint8_t MOIEncoderTest_EncodeDecodeTest(
-        const char *wav_filename, uint16_t bits_per_sample, uint16_t block_size, double rms_epsilon)
+/* パラメータ指定付きエンコード→デコードテスト 成功時は1, 失敗時は0を返す */
+static uint8_t MOIEncoderTest_EncodeDecodeWithParameterTest(
+        const char *wav_filename, const struct MOIEncodeParameter *parameter, double rms_epsilon)
 {
     struct WAVFile *wavfile;
     struct stat fstat;
@@ -559,16 +805,15 @@ static uint8_t MOIEncoderTest_EncodeDecodeTest(
 
     /* ハンドル作成 */
     MOI_SetValidEncoderConfig(&enc_config);
-    enc_config.max_block_size = block_size;
+    enc_config.max_block_size = parameter->block_size;
+    enc_config.max_num_threads = parameter->num_threads;
     encoder = MOIEncoder_Create(&enc_config, NULL, 0);
     decoder = MOIDecoder_Create(NULL, 0);
 
     /* エンコードパラメータをセット */
-    MOI_SetValidParameter(&enc_param);
+    enc_param = (*parameter);
     enc_param.num_channels = num_channels;
     enc_param.sampling_rate = wavfile->format.sampling_rate;
-    enc_param.bits_per_sample = bits_per_sample;
-    enc_param.block_size = block_size;
     if (MOIEncoder_SetEncodeParameter(encoder, &enc_param) != MOI_APIRESULT_OK) {
         is_ok = 0;
         goto CHECK_END;
@@ -628,6 +873,30 @@ CHECK_END:
     return is_ok;
 }
 
+/* 探索テスト用の入力: 440Hzの正弦波に擬似乱数を重畳（毎回同じ系列） */
+static void MOIEncoderTest_GenerateNoisySine(int16_t *input, uint32_t num_samples)
+{
+    uint32_t smpl;
+
+    srand(0);
+    for (smpl = 0; smpl < num_samples; smpl++) {
+        input[smpl] = (int16_t)(8000.0 * sin((2.0 * 3.1415 * 440.0 * smpl) / 8000.0) + (rand() % 512) - 256);
+    }
+}
+
+/* エンコード→デコードテスト 成功時は1, 失敗時は0を返す */
+static uint8_t MOIEncoderTest_EncodeDecodeTest(
+        const char *wav_filename, uint16_t bits_per_sample, uint16_t block_size, double rms_epsilon)
+{
+    struct MOIEncodeParameter enc_param;
+
+    MOI_SetValidParameter(&enc_param);
+    enc_param.bits_per_sample = bits_per_sample;
+    enc_param.block_size = block_size;
+
+    return MOIEncoderTest_EncodeDecodeWithParameterTest(wav_filename, &enc_param, rms_epsilon);
+}
+
 /* エンコードテスト */
 TEST(MOIEncoder, EncodeTest)
 {
@@ -738,6 +1007,1733 @@ TEST(MOIEncoder, EncodeTest)
         EXPECT_EQ(1, MOIEncoderTest_EncodeDecodeTest("sin300Hz.wav",          4, 1024, 5.0e-2));
     }
 
+    /* トレリス探索によるエンコードデコードテスト */
+    {
+        static const char *test_files[] = {
+            "unit_impulse_mono.wav", "unit_impulse.wav", "sin300Hz_mono.wav", "sin300Hz.wav" };
+        static const uint16_t block_sizes[] = { 128, 256, 512, 1024 };
+        static const uint32_t num_states[] = { 1, 8, MOI_MAX_TRELLIS_NUM_STATES };
+        uint32_t i, j, k;
+        struct MOIEncodeParameter param;
+
+        for (i = 0; i < sizeof(test_files) / sizeof(test_files[0]); i++) {
+            for (j = 0; j < sizeof(block_sizes) / sizeof(block_sizes[0]); j++) {
+                for (k = 0; k < sizeof(num_states) / sizeof(num_states[0]); k++) {
+                    MOI_SetValidParameter(&param);
+                    param.search_method = MOI_SEARCH_METHOD_TRELLIS;
+                    param.trellis_num_states = num_states[k];
+                    param.block_size = block_sizes[j];
+                    EXPECT_EQ(1, MOIEncoderTest_EncodeDecodeWithParameterTest(test_files[i], &param, 5.0e-2));
+                }
+            }
+        }
+    }
+
+    /* 適応探索によるエンコードデコードテスト */
+    {
+        static const char *test_files[] = {
+            "unit_impulse_mono.wav", "unit_impulse.wav", "sin300Hz_mono.wav", "sin300Hz.wav" };
+        static const uint16_t block_sizes[] = { 128, 256, 512, 1024 };
+        uint32_t i, j;
+        struct MOIEncodeParameter param;
+
+        for (i = 0; i < sizeof(test_files) / sizeof(test_files[0]); i++) {
+            for (j = 0; j < sizeof(block_sizes) / sizeof(block_sizes[0]); j++) {
+                MOI_SetValidParameter(&param);
+                param.search_adaptive = 1;
+                param.search_beam_width = 4;
+                param.search_depth = 3;
+                param.block_size = block_sizes[j];
+                EXPECT_EQ(1, MOIEncoderTest_EncodeDecodeWithParameterTest(test_files[i], &param, 5.0e-2));
+            }
+        }
+    }
+
+}
+
+/* 適応探索のパラメータ選択テスト */
+TEST(MOIEncoder, AdaptiveSearchParameterTest)
+{
+    /* 無音は最小、大振幅の雑音は最大の探索幅・深さになるか */
+    {
+#define NUM_SAMPLES 505
+        int16_t input[NUM_SAMPLES];
+        uint32_t smpl;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        MOI_SetValidParameter(&param);
+        param.search_adaptive = 1;
+        param.search_beam_width = 8;
+        param.search_depth = 4;
+        param.min_search_beam_width = 2;
+        param.min_search_depth = 1;
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        EXPECT_EQ(8, encoder->search_beam_width);
+        EXPECT_EQ(4, encoder->search_depth);
+
+        memset(input, 0, sizeof(input));
+        MOIEncoder_SetSearchEffort(encoder, MOIEncoder_EstimateSearchEffort(input, NUM_SAMPLES));
+        EXPECT_EQ(2, encoder->search_beam_width);
+        EXPECT_EQ(1, encoder->search_depth);
+
+        srand(0);
+        for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+            input[smpl] = (int16_t)((rand() % 65536) + INT16_MIN);
+        }
+        MOIEncoder_SetSearchEffort(encoder, MOIEncoder_EstimateSearchEffort(input, NUM_SAMPLES));
+        EXPECT_EQ(8, encoder->search_beam_width);
+        EXPECT_EQ(4, encoder->search_depth);
+
+        MOIEncoder_Destroy(encoder);
+#undef NUM_SAMPLES
+    }
+}
+
+/* 時間予算指定エンコードのテスト */
+TEST(MOIEncoder, TimeBudgetTest)
+{
+    /* 時間切れの場合は残りをIMA-ADPCMで符号化し、デフォルト候補より悪くならない */
+    {
+#define NUM_SAMPLES 505
+        int16_t input[NUM_SAMPLES];
+        uint8_t code[NUM_SAMPLES];
+        int8_t init_stepsize_index;
+        uint32_t smpl;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+        struct MOIEncodeStatistics stats;
+        struct MOICoreEncoder result;
+
+        for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+            input[smpl] = (int16_t)(8192.0 * sin((2.0 * 3.1415 * 440.0 * smpl) / 8000.0));
+        }
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        MOI_SetValidParameter(&param);
+        param.search_beam_width = 4;
+        param.search_depth = 3;
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+
+        /* 既に期限切れ */
+        encoder->deadline = 1;
+        EXPECT_EQ(MOI_ERROR_OK, MOIEncoder_EncodeSamples(encoder, input, NUM_SAMPLES, code, &init_stepsize_index));
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_GetEncodeStatistics(encoder, &stats));
+        EXPECT_EQ(1, stats.num_deadline_fallbacks);
+
+        result.prev_sample = input[0];
+        result.stepsize_index = init_stepsize_index;
+        result.total_cost = 0;
+        for (smpl = 1; smpl < NUM_SAMPLES; smpl++) {
+            MOICoreEncoder_Update(&result, input[smpl], code[smpl]);
+        }
+        EXPECT_TRUE(result.total_cost <= encoder->default_encoder.total_cost);
+
+        MOIEncoder_Destroy(encoder);
+#undef NUM_SAMPLES
+    }
+
+    /* 時間予算を指定してエンコードデコード */
+    {
+        static const char *test_files[] = {
+            "unit_impulse_mono.wav", "unit_impulse.wav", "sin300Hz_mono.wav", "sin300Hz.wav" };
+        static const uint32_t time_budgets[] = { 1, 1000 };
+        uint32_t i, j;
+        struct MOIEncodeParameter param;
+
+        for (i = 0; i < sizeof(test_files) / sizeof(test_files[0]); i++) {
+            for (j = 0; j < sizeof(time_budgets) / sizeof(time_budgets[0]); j++) {
+                MOI_SetValidParameter(&param);
+                param.search_beam_width = 4;
+                param.search_depth = 3;
+                param.time_budget = time_budgets[j];
+                EXPECT_EQ(1, MOIEncoderTest_EncodeDecodeWithParameterTest(test_files[i], &param, 5.0e-2));
+            }
+        }
+    }
+
+    /* 時間予算指定時の探索幅・深さの範囲が不正 */
+    {
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        MOI_SetValidParameter(&param);
+        param.time_budget = 1;
+        param.min_search_depth = param.search_depth + 1;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        MOIEncoder_Destroy(encoder);
+    }
+}
+
+/* 符号選択記録の確定テスト */
+TEST(MOIEncoder, TraceCommitTest)
+{
+    /* 共通の祖先の符号を途中で確定しても、全記録を残して末尾から辿った符号列と一致する（窓を複数周する） */
+    {
+#define NUM_SAMPLES (4 * MOIENCODER_TRACE_WINDOW_SIZE)
+#define WIDTH 8
+        static struct MOICoreEncoderTrace trace[MOIENCODER_TRACE_WINDOW_SIZE * WIDTH];
+        static struct MOICoreEncoderTrace full_trace[NUM_SAMPLES][WIDTH];
+        static uint8_t code[NUM_SAMPLES], reference[NUM_SAMPLES];
+        static struct MOICoreEncoderCandidates candidates;
+        uint32_t smpl, i, index, committed;
+        struct MOIEncodeStatistics stats;
+
+        memset(&candidates, 0, sizeof(struct MOICoreEncoderCandidates));
+        memset(&stats, 0, sizeof(struct MOIEncodeStatistics));
+
+        srand(0);
+        committed = 1;
+        for (smpl = 1; smpl < NUM_SAMPLES; smpl++) {
+            for (i = 0; i < WIDTH; i++) {
+                full_trace[smpl][i].parent = (uint8_t)(rand() % WIDTH);
+                full_trace[smpl][i].nibble = (uint8_t)(rand() % MOIENCODER_NUM_CODES);
+                *MOIENCODER_TRACE_ENTRY(trace, smpl, WIDTH, i) = full_trace[smpl][i];
+            }
+            if ((smpl % MOIENCODER_TRACE_COMMIT_INTERVAL) == 0) {
+                EXPECT_EQ(WIDTH, MOIEncoder_CommitConvergedCodes(
+                            trace, WIDTH, smpl, &committed, &candidates, WIDTH, code, &stats));
+            }
+        }
+        EXPECT_TRUE(committed > (NUM_SAMPLES - MOIENCODER_TRACE_WINDOW_SIZE));
+        EXPECT_EQ(0, stats.num_forced_trace_commits);
+        MOIEncoder_TraceBackCodes(trace, WIDTH, NUM_SAMPLES - 1, 0, committed, code);
+
+        index = 0;
+        for (smpl = NUM_SAMPLES - 1; smpl >= 1; smpl--) {
+            reference[smpl] = full_trace[smpl][index].nibble;
+            index = full_trace[smpl][index].parent;
+        }
+        EXPECT_EQ(0, memcmp(&reference[1], &code[1], NUM_SAMPLES - 1));
+#undef WIDTH
+#undef NUM_SAMPLES
+    }
+
+    /* 窓より長いブロックの符号列のコストが探索結果のコストに一致する
+    * 0と1の繰り返しは対称な候補が残り続けて祖先が一致しないので、最良候補の祖先で強制的に確定する */
+    {
+#define BLOCK_SIZE 2048
+#define NUM_SAMPLES ((BLOCK_SIZE - 4) * 2 + 1)
+        static int16_t input[NUM_SAMPLES];
+        static uint8_t code[NUM_SAMPLES];
+        int8_t init_stepsize_index;
+        uint32_t smpl, signal, method;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+        struct MOIEncodeStatistics stats;
+
+        MOI_STATIC_ASSERT(NUM_SAMPLES > MOIENCODER_TRACE_WINDOW_SIZE);
+
+        MOI_SetValidEncoderConfig(&config);
+        config.max_block_size = BLOCK_SIZE;
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+
+        for (signal = 0; signal < 2; signal++) {
+            if (signal == 0) {
+                for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+                    input[smpl] = (int16_t)(smpl % 2);
+                }
+            } else {
+                MOIEncoderTest_GenerateNoisySine(input, NUM_SAMPLES);
+            }
+            for (method = 0; method < 2; method++) {
+                MOIError err;
+                MOI_SetValidParameter(&param);
+                param.block_size = BLOCK_SIZE;
+                param.search_method = (method == 0) ? MOI_SEARCH_METHOD_BEAM : MOI_SEARCH_METHOD_TRELLIS;
+                param.search_beam_width = 4;
+                EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+                err = (method == 0)
+                    ? MOIEncoder_EncodeSamples(encoder, input, NUM_SAMPLES, code, &init_stepsize_index)
+                    : MOIEncoder_EncodeSamplesTrellis(encoder, input, NUM_SAMPLES, code, &init_stepsize_index);
+                EXPECT_EQ(MOI_ERROR_OK, err);
+                EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_GetEncodeStatistics(encoder, &stats));
+                if (signal == 0) {
+                    EXPECT_TRUE(stats.num_forced_trace_commits > 0);
+                } else {
+                    EXPECT_EQ(0, stats.num_forced_trace_commits);
+                }
+                EXPECT_EQ(encoder->search_cost, MOIEncoder_CalculateCodeCost(input, NUM_SAMPLES, init_stepsize_index, code));
+                EXPECT_TRUE(encoder->search_cost <= encoder->default_encoder.total_cost);
+            }
+        }
+
+        MOIEncoder_Destroy(encoder);
+#undef NUM_SAMPLES
+#undef BLOCK_SIZE
+    }
+}
+
+/* ビーム候補の重複除去テスト */
+TEST(MOIEncoder, BeamCandidateDeduplicationTest)
+{
+    /* ブロック末尾のビーム候補は全て異なる状態を持つ */
+    {
+#define NUM_SAMPLES 505
+        int16_t input[NUM_SAMPLES];
+        uint8_t code[NUM_SAMPLES];
+        int8_t init_stepsize_index;
+        uint32_t smpl, i, j, num_candidates;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+
+        /* 重複が生じやすい小振幅の正弦波 */
+        for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+            input[smpl] = (int16_t)(16.0 * sin((2.0 * 3.1415 * 440.0 * smpl) / 8000.0));
+        }
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        MOI_SetValidParameter(&param);
+        param.search_beam_width = MOI_MAX_SEARCH_BEAM_WIDTH;
+        param.search_depth = 2;
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+
+        EXPECT_EQ(MOI_ERROR_OK, MOIEncoder_EncodeSamples(encoder, input, NUM_SAMPLES, code, &init_stepsize_index));
+
+        num_candidates = MOI_MAX_SEARCH_BEAM_WIDTH;
+        for (i = 0; i < num_candidates; i++) {
+            for (j = i + 1; j < num_candidates; j++) {
+                EXPECT_FALSE((encoder->candidate.prev_sample[i] == encoder->candidate.prev_sample[j])
+                        && (encoder->candidate.stepsize_index[i] == encoder->candidate.stepsize_index[j]));
+            }
+        }
+
+        MOIEncoder_Destroy(encoder);
+#undef NUM_SAMPLES
+    }
+}
+
+/* 枝刈り無しで最小スコアを計算する参照実装 */
+static MOICost MOIEncoderTest_ReferenceSearchMinScore(
+        const struct MOICoreEncoder *encoder, const int16_t *sample, uint32_t depth)
+{
+    uint8_t abs, killer_nibble;
+    MOICost min, score;
+
+    if (depth == 0) {
+        return encoder->total_cost;
+    }
+
+    killer_nibble = MOICoreEncoder_CalculateIMAADPCMNibble(encoder, sample[0]);
+    if (depth == 1) {
+        return encoder->total_cost + MOICoreEncoder_CalculateCost(encoder, sample[0], killer_nibble);
+    }
+
+    min = MOICOST_MAX;
+    for (abs = 0; abs <= 0x7; abs++) {
+        struct MOICoreEncoder next = (*encoder);
+        MOICoreEncoder_Update(&next, sample[0], (uint8_t)(abs | (killer_nibble & 0x8)));
+        score = MOIEncoderTest_ReferenceSearchMinScore(&next, sample + 1, depth - 1);
+        min = MOI_MIN_VAL(min, score);
+    }
+
+    return min;
+}
+
+/* 整数コストによる探索のテスト */
+TEST(MOIEncoder, IntegerCostSearchTest)
+{
+    /* 64bit/32bit飽和演算の探索が参照実装と一致するか（下限による枝刈りの有無に依らない） */
+    {
+#define NUM_TRIALS 200
+        uint32_t trial, depth, smpl;
+        int16_t sample[MOI_MAX_SEARCH_DEPTH];
+        struct MOICoreEncoder encoder;
+        struct MOISearchCache cache;
+        struct MOIEncodeStatistics stats;
+        struct MOISearchContext context;
+
+        /* キャッシュは使わない */
+        memset(&cache, 0, sizeof(struct MOISearchCache));
+        memset(&stats, 0, sizeof(struct MOIEncodeStatistics));
+        context.cache = &cache;
+        context.statistics = &stats;
+
+        srand(0);
+        for (trial = 0; trial < NUM_TRIALS; trial++) {
+            context.use_lower_bound = (uint8_t)(trial % 2);
+            encoder.prev_sample = (int16_t)((rand() % 4096) - 2048);
+            encoder.stepsize_index = (int8_t)(rand() % 60);
+            encoder.total_cost = rand() % 1024;
+            for (smpl = 0; smpl < MOI_MAX_SEARCH_DEPTH; smpl++) {
+                sample[smpl] = (int16_t)((rand() % 4096) - 2048);
+            }
+            for (depth = 1; depth <= 5; depth++) {
+                const MOICost reference = MOIEncoderTest_ReferenceSearchMinScore(&encoder, sample, depth);
+                EXPECT_EQ(reference, MOICoreEncoder_SearchMinScore(&encoder, sample, depth, MOICOST_MAX, &context));
+                if (depth <= MOIENCODER_SATURATED_SEARCH_MAX_DEPTH) {
+                    EXPECT_EQ(reference - encoder.total_cost,
+                            MOICoreEncoder_SearchMinFutureCost32(&encoder, sample, depth, INT32_MAX, &context));
+                }
+            }
+        }
+#undef NUM_TRIALS
+    }
+
+    /* フルスケールの入力でも参照実装と一致する（32bit演算で飽和する部分木があっても結果は変わらない） */
+    {
+#define NUM_TRIALS 200
+        uint32_t trial, depth, smpl;
+        int16_t sample[MOI_MAX_SEARCH_DEPTH];
+        struct MOICoreEncoder encoder;
+        struct MOISearchCache cache;
+        struct MOIEncodeStatistics stats;
+        struct MOISearchContext context;
+
+        memset(&cache, 0, sizeof(struct MOISearchCache));
+        memset(&stats, 0, sizeof(struct MOIEncodeStatistics));
+        context.cache = &cache;
+        context.statistics = &stats;
+
+        srand(0);
+        for (trial = 0; trial < NUM_TRIALS; trial++) {
+            context.use_lower_bound = (uint8_t)(trial % 2);
+            encoder.stepsize_index = (int8_t)(rand() % MOI_IMAADPCM_STEPSIZE_TABLE_SIZE);
+            encoder.total_cost = rand() % 1024;
+            switch ((trial / 2) % 3) {
+            case 0:
+                /* フルスケールのステップ */
+                encoder.prev_sample = INT16_MIN;
+                for (smpl = 0; smpl < MOI_MAX_SEARCH_DEPTH; smpl++) {
+                    sample[smpl] = INT16_MAX;
+                }
+                break;
+            case 1:
+                /* フルスケールの矩形波 */
+                encoder.prev_sample = (trial % 4 < 2) ? -INT16_MAX : INT16_MAX;
+                for (smpl = 0; smpl < MOI_MAX_SEARCH_DEPTH; smpl++) {
+                    sample[smpl] = (int16_t)((((smpl + trial) / 2) % 2) ? INT16_MAX : -INT16_MAX);
+                }
+                break;
+            default:
+                /* フルスケールの乱数 */
+                encoder.prev_sample = (int16_t)((rand() % 65536) - 32768);
+                for (smpl = 0; smpl < MOI_MAX_SEARCH_DEPTH; smpl++) {
+                    sample[smpl] = (int16_t)((rand() % 65536) - 32768);
+                }
+                break;
+            }
+            for (depth = 1; depth <= 5; depth++) {
+                const MOICost reference = MOIEncoderTest_ReferenceSearchMinScore(&encoder, sample, depth);
+                EXPECT_EQ(reference, MOICoreEncoder_SearchMinScore(&encoder, sample, depth, MOICOST_MAX, &context));
+                /* これまでの最小が与えられた場合は、それを下回るスコアは正確に求まる */
+                EXPECT_EQ(reference, MOICoreEncoder_SearchMinScore(&encoder, sample, depth, reference + 1, &context));
+                {
+                    const MOICost min = encoder.total_cost + 1000000;
+                    const MOICost score = MOICoreEncoder_SearchMinScore(&encoder, sample, depth, min, &context);
+                    if (reference < min) {
+                        EXPECT_EQ(reference, score);
+                    } else {
+                        EXPECT_TRUE(score >= min);
+                    }
+                }
+                /* 32bit演算はINT32_MAX未満の上限を与えれば上限でクリップした値に一致する */
+                if ((depth >= 2) && (depth <= MOIENCODER_SATURATED_SEARCH_MAX_DEPTH)) {
+                    EXPECT_EQ(MOI_MIN_VAL(reference - encoder.total_cost, INT32_MAX - 1),
+                            MOICoreEncoder_SearchMinFutureCost32(&encoder, sample, depth, INT32_MAX - 1, &context));
+                    EXPECT_EQ(MOI_MIN_VAL(reference - encoder.total_cost, 1000000),
+                            MOICoreEncoder_SearchMinFutureCost32(&encoder, sample, depth, 1000000, &context));
+                }
+            }
+        }
+#undef NUM_TRIALS
+    }
+
+    /* 誤差が46340を越えると32bit演算は飽和するが、64bit演算の探索は正確なコストを返す */
+    {
+        int16_t sample[2] = { INT16_MAX, INT16_MAX };
+        struct MOICoreEncoder encoder;
+        struct MOIEncodeStatistics stats;
+        struct MOISearchContext context;
+
+        memset(&stats, 0, sizeof(struct MOIEncodeStatistics));
+        context.cache = NULL;
+        context.statistics = &stats;
+        context.use_lower_bound = 0;
+        encoder.prev_sample = INT16_MIN;
+        encoder.stepsize_index = 0;
+        encoder.total_cost = 0;
+        EXPECT_EQ(INT32_MAX, MOICoreEncoder_CalculateCost32(&encoder, sample[0], 0));
+        EXPECT_TRUE(MOICoreEncoder_CalculateCost(&encoder, sample[0], 0) > INT32_MAX);
+        EXPECT_EQ(MOIEncoderTest_ReferenceSearchMinScore(&encoder, sample, 2),
+                MOICoreEncoder_SearchMinScore(&encoder, sample, 2, MOICOST_MAX, &context));
+        EXPECT_TRUE(MOICoreEncoder_SearchMinScore(&encoder, sample, 2, MOICOST_MAX, &context) > INT32_MAX);
+    }
+}
+
+/* 残りコストの下限のテスト */
+TEST(MOIEncoder, LowerBoundTest)
+{
+    /* 最大変位テーブルは単調増加 */
+    {
+        uint32_t i, k;
+        for (i = 0; i < MOI_IMAADPCM_STEPSIZE_TABLE_SIZE; i++) {
+            EXPECT_EQ(0, MOI_max_displacement_table[i][0]);
+            EXPECT_EQ(MOI_qdiff_magnitude_table[i][7], MOI_max_displacement_table[i][1]);
+            for (k = 1; k <= MOI_MAX_SEARCH_DEPTH; k++) {
+                EXPECT_TRUE(MOI_max_displacement_table[i][k - 1] < MOI_max_displacement_table[i][k]);
+            }
+        }
+    }
+
+    /* 下限は探索結果を越えない */
+    {
+#define NUM_TRIALS 500
+        uint32_t trial, depth, smpl;
+        int16_t sample[MOI_MAX_SEARCH_DEPTH];
+        struct MOICoreEncoder encoder;
+
+        srand(1);
+        for (trial = 0; trial < NUM_TRIALS; trial++) {
+            encoder.prev_sample = (int16_t)((rand() % 8192) - 4096);
+            encoder.stepsize_index = (int8_t)(rand() % 40);
+            encoder.total_cost = 0;
+            for (smpl = 0; smpl < MOI_MAX_SEARCH_DEPTH; smpl++) {
+                sample[smpl] = (int16_t)((rand() % 8192) - 4096);
+            }
+            for (depth = 1; depth <= 4; depth++) {
+                EXPECT_TRUE(MOICoreEncoder_CalculateLowerBound(&encoder, sample, depth, MOICOST_MAX)
+                        <= MOIEncoderTest_ReferenceSearchMinScore(&encoder, sample, depth));
+            }
+        }
+#undef NUM_TRIALS
+    }
+
+    /* 下限による枝刈りの有無で出力が一致し、ノード数が減る */
+    {
+#define NUM_SAMPLES 8192
+        const uint32_t buffer_size = 16 * 1024;
+        int16_t *input[1];
+        uint8_t *data[2];
+        uint32_t smpl, i, output_size[2];
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+        struct MOIEncodeStatistics stats[2];
+
+        input[0] = (int16_t *)malloc(sizeof(int16_t) * NUM_SAMPLES);
+        data[0] = (uint8_t *)malloc(buffer_size);
+        data[1] = (uint8_t *)malloc(buffer_size);
+
+        /* 急峻な変化を含む矩形波 */
+        for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+            input[0][smpl] = (int16_t)(((smpl / 50) % 2) ? 12000 : -12000);
+        }
+
+        MOI_SetValidEncoderConfig(&config);
+        config.max_search_cache_size = 0;
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        for (i = 0; i < 2; i++) {
+            MOI_SetValidParameter(&param);
+            param.search_depth = 6;
+            param.search_use_lower_bound = (uint8_t)i;
+            EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+            EXPECT_EQ(MOI_APIRESULT_OK,
+                    MOIEncoder_EncodeWhole(encoder, (const int16_t *const *)input, NUM_SAMPLES, data[i], buffer_size, &output_size[i]));
+            EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_GetEncodeStatistics(encoder, &stats[i]));
+        }
+        EXPECT_EQ(output_size[0], output_size[1]);
+        EXPECT_EQ(0, memcmp(data[0], data[1], output_size[0]));
+        EXPECT_EQ(0, stats[0].search_num_bound_prunes);
+        EXPECT_TRUE(stats[1].search_num_bound_prunes > 0);
+        EXPECT_TRUE(stats[1].search_num_nodes < stats[0].search_num_nodes);
+
+        MOIEncoder_Destroy(encoder);
+        free(input[0]);
+        free(data[0]);
+        free(data[1]);
+#undef NUM_SAMPLES
+    }
+
+    /* フルスケールの素材でも下限による枝刈りの有無で出力が一致する */
+    {
+#define NUM_SAMPLES 16384
+#define SEGMENT_SIZE 1024
+        static const uint32_t depths[] = { 5, 6 };
+        const uint32_t buffer_size = 64 * 1024;
+        int16_t *input[2];
+        uint8_t *data[2];
+        uint32_t smpl, ch, i, j, output_size[2];
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+
+        input[0] = (int16_t *)malloc(sizeof(int16_t) * NUM_SAMPLES);
+        input[1] = (int16_t *)malloc(sizeof(int16_t) * NUM_SAMPLES);
+        data[0] = (uint8_t *)malloc(buffer_size);
+        data[1] = (uint8_t *)malloc(buffer_size);
+
+        /* 無音・正弦波・直流・フルスケールの雑音を順に繰り返す（チャンネル間で区間をずらす） */
+        srand(0);
+        for (ch = 0; ch < 2; ch++) {
+            for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+                switch (((smpl + ch * (SEGMENT_SIZE / 2)) / SEGMENT_SIZE) % 4) {
+                case 0: input[ch][smpl] = 0; break;
+                case 1: input[ch][smpl] = (int16_t)(20000.0 * sin((2.0 * 3.1415 * 440.0 * smpl) / 44100.0)); break;
+                case 2: input[ch][smpl] = 12345; break;
+                default: input[ch][smpl] = (int16_t)((rand() % 65536) - 32768); break;
+                }
+            }
+        }
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        for (j = 0; j < sizeof(depths) / sizeof(depths[0]); j++) {
+            for (i = 0; i < 2; i++) {
+                MOI_SetValidParameter(&param);
+                param.num_channels = 2;
+                param.search_depth = depths[j];
+                param.search_use_lower_bound = (uint8_t)i;
+                EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+                EXPECT_EQ(MOI_APIRESULT_OK,
+                        MOIEncoder_EncodeWhole(encoder, (const int16_t *const *)input, NUM_SAMPLES, data[i], buffer_size, &output_size[i]));
+            }
+            EXPECT_EQ(output_size[0], output_size[1]);
+            EXPECT_EQ(0, memcmp(data[0], data[1], output_size[0]));
+        }
+
+        MOIEncoder_Destroy(encoder);
+        free(input[0]);
+        free(input[1]);
+        free(data[0]);
+        free(data[1]);
+#undef SEGMENT_SIZE
+#undef NUM_SAMPLES
+    }
+}
+
+/* 符号の並べ替えテスト */
+TEST(MOIEncoder, NibbleOrderTest)
+{
+    /* 同一符号の全符号がコストの昇順に並ぶか */
+    {
+#define NUM_TRIALS 1000
+        uint32_t trial, i;
+        int32_t lo, hi, abs;
+        int32_t abs_err[MOIENCODER_NUM_CODES / 2];
+        uint8_t nibbles[MOIENCODER_NUM_CODES / 2];
+        struct MOICoreEncoder encoder;
+
+        srand(0);
+        for (trial = 0; trial < NUM_TRIALS; trial++) {
+            const int16_t sample = (int16_t)((rand() % 65536) + INT16_MIN);
+            uint8_t sign, mask = 0;
+            encoder.prev_sample = (int16_t)((rand() % 65536) + INT16_MIN);
+            encoder.stepsize_index = (int8_t)(rand() % MOI_IMAADPCM_STEPSIZE_TABLE_SIZE);
+            encoder.total_cost = 0;
+            sign = ((sample - encoder.prev_sample) < 0) ? 8 : 0;
+            lo = MOICoreEncoder_CalculateAbsErrors(&encoder, sample, sign, abs_err, NULL);
+            hi = lo + 1;
+            for (i = 0; i < MOIENCODER_NUM_CODES / 2; i++) {
+                abs = MOICoreEncoder_GetNextNibble(abs_err, &lo, &hi);
+                nibbles[i] = (uint8_t)(abs | sign);
+                EXPECT_EQ(MOICoreEncoder_CalculateCost(&encoder, sample, nibbles[i]), (MOICost)abs_err[abs] * abs_err[abs]);
+            }
+            for (i = 0; i < MOIENCODER_NUM_CODES / 2; i++) {
+                EXPECT_EQ(sign, nibbles[i] & 0x8);
+                mask |= (uint8_t)(1 << (nibbles[i] & 0x7));
+                if (i > 0) {
+                    EXPECT_TRUE(MOICoreEncoder_CalculateCost(&encoder, sample, nibbles[i - 1])
+                            <= MOICoreEncoder_CalculateCost(&encoder, sample, nibbles[i]));
+                }
+            }
+            EXPECT_EQ(0xFF, mask);
+        }
+#undef NUM_TRIALS
+    }
+}
+
+/* 上位選択のテスト */
+TEST(MOIEncoder, SelectTopKIndicesTest)
+{
+    /* スコア昇順・同点はインデックス昇順で安定ソートした先頭k個と一致するか */
+    {
+#define NUM_TRIALS 1000
+#define MAX_NUM_DATA MOIENCODER_MAX_NUM_EXPANSIONS
+        static MOICost score[MAX_NUM_DATA];
+        static uint32_t order[MAX_NUM_DATA];
+        uint32_t selected[MOIENCODER_TRACE_WIDTH];
+        uint32_t trial, i, j, n, k;
+
+        srand(0);
+        for (trial = 0; trial < NUM_TRIALS; trial++) {
+            /* 同点が多く生じるよう値域を狭める場合も確認 */
+            const int32_t range = (trial % 2) ? 8 : RAND_MAX;
+            n = (uint32_t)(rand() % MAX_NUM_DATA) + 1;
+            k = (uint32_t)(rand() % MOI_MIN_VAL(n, MOIENCODER_TRACE_WIDTH)) + 1;
+            for (i = 0; i < n; i++) {
+                score[i] = rand() % range;
+                order[i] = i;
+            }
+            /* 参照: 安定な挿入ソート */
+            for (i = 1; i < n; i++) {
+                const uint32_t index = order[i];
+                for (j = i; (j > 0) && (score[order[j - 1]] > score[index]); j--) {
+                    order[j] = order[j - 1];
+                }
+                order[j] = index;
+            }
+            /* 参照の先頭k個をインデックス昇順に */
+            for (i = 1; i < k; i++) {
+                const uint32_t index = order[i];
+                for (j = i; (j > 0) && (order[j - 1] > index); j--) {
+                    order[j] = order[j - 1];
+                }
+                order[j] = index;
+            }
+
+            MOICoreEncoder_SelectTopKIndices(score, n, k, selected);
+            for (i = 0; i < k; i++) {
+                EXPECT_EQ(order[i], selected[i]);
+            }
+        }
+#undef MAX_NUM_DATA
+#undef NUM_TRIALS
+    }
+}
+
+/* 全候補一括展開のテスト */
+TEST(MOIEncoder, ExpandCandidatesTest)
+{
+    /* 各候補・各符号を逐次更新した結果と一致するか */
+    {
+#define NUM_TRIALS 1000
+        uint32_t trial, i, j;
+        int32_t argmin;
+        int32_t abs_err[MOIENCODER_NUM_CODES / 2];
+        int32_t next_sample[MOIENCODER_NUM_CODES / 2];
+        struct MOICoreEncoder encoder, reference;
+        struct MOICoreEncoderCandidates *candidates;
+        struct MOICoreEncoderChildren *children;
+
+        candidates = (struct MOICoreEncoderCandidates *)malloc(sizeof(struct MOICoreEncoderCandidates));
+        children = (struct MOICoreEncoderChildren *)malloc(sizeof(struct MOICoreEncoderChildren));
+
+        srand(0);
+        for (trial = 0; trial < NUM_TRIALS; trial++) {
+            const int16_t sample = (int16_t)((rand() % 65536) + INT16_MIN);
+            const uint32_t num_candidates = (uint32_t)(rand() % MOITRELLIS_MAX_NUM_STATES) + 1;
+
+            for (i = 0; i < num_candidates; i++) {
+                candidates->prev_sample[i] = (int16_t)((rand() % 65536) + INT16_MIN);
+                candidates->stepsize_index[i] = (int8_t)(rand() % MOI_IMAADPCM_STEPSIZE_TABLE_SIZE);
+                candidates->init_stepsize_index[i] = 0;
+                candidates->total_cost[i] = rand();
+            }
+            MOICoreEncoder_ExpandCandidates(candidates, num_candidates, sample, children);
+
+            for (i = 0; i < num_candidates; i++) {
+                MOICost min_cost = MOICOST_MAX;
+                int32_t reference_argmin = 0;
+                /* 誤差が最小となる側と逆の符号の場合も確認 */
+                const uint8_t sign = (uint8_t)((rand() % 2) * 8);
+                MOICoreEncoderCandidates_Get(candidates, i, &encoder);
+                EXPECT_EQ(((sample - encoder.prev_sample) < 0) ? 8 : 0, children->sign[i]);
+                argmin = MOICoreEncoder_CalculateAbsErrors(&encoder, sample, sign, abs_err, next_sample);
+                for (j = 0; j < MOIENCODER_NUM_CODES / 2; j++) {
+                    const uint32_t k = i * (MOIENCODER_NUM_CODES / 2) + j;
+                    MOICost cost = MOICoreEncoder_CalculateCost(&encoder, sample, (uint8_t)(j | sign));
+                    EXPECT_EQ(cost, (MOICost)abs_err[j] * abs_err[j]);
+                    if (cost < min_cost) {
+                        min_cost = cost;
+                        reference_argmin = (int32_t)j;
+                    }
+                    reference = encoder;
+                    MOICoreEncoder_Update(&reference, sample, (uint8_t)(j | sign));
+                    EXPECT_EQ(reference.prev_sample, next_sample[j]);
+                    /* 一括展開結果 */
+                    reference = encoder;
+                    MOICoreEncoder_Update(&reference, sample, (uint8_t)(j | children->sign[i]));
+                    EXPECT_EQ(reference.prev_sample, children->prev_sample[k]);
+                    EXPECT_EQ(reference.stepsize_index, children->stepsize_index[k]);
+                    EXPECT_EQ(reference.total_cost, children->total_cost[k]);
+                }
+                EXPECT_EQ(reference_argmin, argmin);
+            }
+        }
+
+        free(candidates);
+        free(children);
+#undef NUM_TRIALS
+    }
+}
+
+/* 先読み探索キャッシュのテスト */
+TEST(MOIEncoder, SearchCacheTest)
+{
+    /* キャッシュの有無・サイズに依らず出力が一致するか */
+    {
+#define NUM_SAMPLES 8192
+        static const uint32_t cache_sizes[] = { 0, 1024, 64 * 1024, MOI_MAX_SEARCH_CACHE_SIZE };
+        static const uint32_t depths[] = { 1, 3, 5 };
+        const uint32_t buffer_size = 16 * 1024;
+        int16_t *input[1];
+        uint8_t *reference, *data;
+        uint32_t i, j, reference_size, output_size;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+        struct MOIEncodeStatistics stats;
+
+        input[0] = (int16_t *)malloc(sizeof(int16_t) * NUM_SAMPLES);
+        reference = (uint8_t *)malloc(buffer_size);
+        data = (uint8_t *)malloc(buffer_size);
+
+        MOIEncoderTest_GenerateNoisySine(input[0], NUM_SAMPLES);
+
+        for (j = 0; j < sizeof(depths) / sizeof(depths[0]); j++) {
+            for (i = 0; i < sizeof(cache_sizes) / sizeof(cache_sizes[0]); i++) {
+                MOI_SetValidEncoderConfig(&config);
+                config.max_search_cache_size = cache_sizes[i];
+                encoder = MOIEncoder_Create(&config, NULL, 0);
+                ASSERT_TRUE(encoder != NULL);
+                MOI_SetValidParameter(&param);
+                param.search_depth = depths[j];
+                EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+
+                /* 統計情報はパラメータ設定でリセットされる */
+                EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_GetEncodeStatistics(encoder, &stats));
+                EXPECT_EQ(0, stats.search_cache_hits);
+                EXPECT_EQ(0, stats.search_cache_misses);
+
+                EXPECT_EQ(MOI_APIRESULT_OK,
+                        MOIEncoder_EncodeWhole(encoder, (const int16_t *const *)input, NUM_SAMPLES, data, buffer_size, &output_size));
+                EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_GetEncodeStatistics(encoder, &stats));
+                if ((cache_sizes[i] == 0) || (depths[j] < MOISEARCHCACHE_MIN_DEPTH)) {
+                    /* キャッシュが使われない */
+                    EXPECT_EQ(0, stats.search_cache_hits);
+                    EXPECT_EQ(0, stats.search_cache_misses);
+                } else {
+                    EXPECT_TRUE(stats.search_cache_hits > 0);
+                    EXPECT_TRUE(stats.search_cache_misses > 0);
+                }
+
+                if (i == 0) {
+                    memcpy(reference, data, output_size);
+                    reference_size = output_size;
+                } else {
+                    EXPECT_EQ(reference_size, output_size);
+                    EXPECT_EQ(0, memcmp(reference, data, output_size));
+                }
+
+                MOIEncoder_Destroy(encoder);
+            }
+        }
+
+        free(input[0]);
+        free(reference);
+        free(data);
+#undef NUM_SAMPLES
+    }
+
+    /* 統計情報取得の失敗ケース */
+    {
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeStatistics stats;
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        EXPECT_EQ(MOI_APIRESULT_INVALID_ARGUMENT, MOIEncoder_GetEncodeStatistics(NULL, &stats));
+        EXPECT_EQ(MOI_APIRESULT_INVALID_ARGUMENT, MOIEncoder_GetEncodeStatistics(encoder, NULL));
+        MOIEncoder_Destroy(encoder);
+    }
+}
+
+/* 指定パラメータでファイル全体をエンコードするサブルーチン 成功時は1, 失敗時は0を返す */
+static uint8_t MOIEncoderTest_EncodeWhole(
+        const char *wav_filename, const struct MOIEncodeParameter *parameter,
+        uint8_t *buffer, uint32_t buffer_size, uint32_t *output_size)
+{
+    struct WAVFile *wavfile;
+    int16_t *input[MOI_MAX_NUM_CHANNELS];
+    uint8_t is_ok;
+    uint32_t ch, smpl, num_channels, num_samples;
+    struct MOIEncodeParameter enc_param;
+    struct MOIEncoderConfig enc_config;
+    struct MOIEncoder *encoder;
+
+    /* 入力wav取得 */
+    wavfile = WAV_CreateFromFile(wav_filename);
+    assert(wavfile != NULL);
+    num_channels = wavfile->format.num_channels;
+    num_samples = wavfile->format.num_samples;
+
+    /* 16bit幅でデータ取得 */
+    for (ch = 0; ch < num_channels; ch++) {
+        input[ch] = (int16_t *)malloc(sizeof(int16_t) * num_samples);
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            input[ch][smpl] = WAVFile_PCM(wavfile, smpl, ch) >> 16;
+        }
+    }
+
+    /* ハンドル作成 */
+    MOI_SetValidEncoderConfig(&enc_config);
+    enc_config.max_block_size = parameter->block_size;
+    enc_config.max_num_threads = parameter->num_threads;
+    encoder = MOIEncoder_Create(&enc_config, NULL, 0);
+
+    /* エンコード */
+    enc_param = (*parameter);
+    enc_param.num_channels = num_channels;
+    enc_param.sampling_rate = wavfile->format.sampling_rate;
+    is_ok = 0;
+    if (MOIEncoder_SetEncodeParameter(encoder, &enc_param) == MOI_APIRESULT_OK) {
+        if (MOIEncoder_EncodeWhole(
+                    encoder, (const int16_t *const *)input, num_samples,
+                    buffer, buffer_size, output_size) == MOI_APIRESULT_OK) {
+            is_ok = 1;
+        }
+    }
+
+    /* 領域開放 */
+    MOIEncoder_Destroy(encoder);
+    for (ch = 0; ch < num_channels; ch++) {
+        free(input[ch]);
+    }
+    WAV_Destroy(wavfile);
+
+    return is_ok;
+}
+
+/* 並列エンコードテスト */
+TEST(MOIEncoder, ParallelEncodeTest)
+{
+    /* スレッド数に依らず出力が一致するか */
+    {
+        static const char *test_files[] = { "sin300Hz_mono.wav", "sin300Hz.wav", "unit_impulse.wav" };
+        static const uint16_t block_sizes[] = { 128, 256, 1024 };
+        static const uint32_t num_threads[] = { 2, 3, 8 };
+        const uint32_t buffer_size = 128 * 1024;
+        uint8_t *serial, *parallel;
+        uint32_t i, j, k, serial_size, parallel_size;
+        struct MOIEncodeParameter param;
+
+        serial = (uint8_t *)malloc(buffer_size);
+        parallel = (uint8_t *)malloc(buffer_size);
+
+        for (i = 0; i < sizeof(test_files) / sizeof(test_files[0]); i++) {
+            for (j = 0; j < sizeof(block_sizes) / sizeof(block_sizes[0]); j++) {
+                MOI_SetValidParameter(&param);
+                param.block_size = block_sizes[j];
+                ASSERT_EQ(1, MOIEncoderTest_EncodeWhole(test_files[i], &param, serial, buffer_size, &serial_size));
+                for (k = 0; k < sizeof(num_threads) / sizeof(num_threads[0]); k++) {
+                    memset(parallel, 0xFF, buffer_size);
+                    param.num_threads = num_threads[k];
+                    ASSERT_EQ(1, MOIEncoderTest_EncodeWhole(test_files[i], &param, parallel, buffer_size, &parallel_size));
+                    EXPECT_EQ(serial_size, parallel_size);
+                    EXPECT_EQ(0, memcmp(serial, parallel, serial_size));
+                }
+            }
+        }
+
+        free(serial);
+        free(parallel);
+    }
+}
+
+/* 2パス符号化テスト */
+TEST(MOIEncoder, TwoPassRefineTest)
+{
+    /* 参照誤差の階級は誤差に対して単調非減少 */
+    {
+        MOICost cost;
+        uint32_t prev_bucket = 0;
+        EXPECT_EQ(0, MOIEncoder_CalculateRefineBucket(0));
+        for (cost = 1; cost < (1 << 20); cost += (cost >> 4) + 1) {
+            const uint32_t bucket = MOIEncoder_CalculateRefineBucket(cost);
+            EXPECT_TRUE(bucket >= prev_bucket);
+            EXPECT_TRUE(bucket < MOIENCODER_REFINE_NUM_BUCKETS);
+            prev_bucket = bucket;
+        }
+        EXPECT_TRUE(MOIEncoder_CalculateRefineBucket(INT64_MAX) < MOIENCODER_REFINE_NUM_BUCKETS);
+    }
+
+    /* 探索するブロックの割合を指定してエンコードデコード */
+    {
+        static const char *test_files[] = {
+            "unit_impulse_mono.wav", "unit_impulse.wav", "sin300Hz_mono.wav", "sin300Hz.wav" };
+        static const uint32_t refine_percents[] = { 0, 1, 50, 100 };
+        static const uint32_t refine_thresholds[] = { 0, 1000 };
+        uint32_t i, j, k;
+        struct MOIEncodeParameter param;
+
+        for (i = 0; i < sizeof(test_files) / sizeof(test_files[0]); i++) {
+            for (j = 0; j < sizeof(refine_percents) / sizeof(refine_percents[0]); j++) {
+                for (k = 0; k < sizeof(refine_thresholds) / sizeof(refine_thresholds[0]); k++) {
+                    MOI_SetValidParameter(&param);
+                    param.refine_percent = refine_percents[j];
+                    param.refine_threshold = refine_thresholds[k];
+                    EXPECT_EQ(1, MOIEncoderTest_EncodeDecodeWithParameterTest(test_files[i], &param, 5.0e-2));
+                }
+            }
+        }
+    }
+
+    /* 全ブロックを探索する場合は1パスの出力と一致し、スレッド数に依らず出力が一致する */
+    {
+        static const char *test_files[] = { "sin300Hz_mono.wav", "sin300Hz.wav" };
+        const uint32_t buffer_size = 128 * 1024;
+        uint8_t *single, *two_pass;
+        uint32_t i, single_size, two_pass_size;
+        struct MOIEncodeParameter param;
+
+        single = (uint8_t *)malloc(buffer_size);
+        two_pass = (uint8_t *)malloc(buffer_size);
+
+        for (i = 0; i < sizeof(test_files) / sizeof(test_files[0]); i++) {
+            MOI_SetValidParameter(&param);
+            ASSERT_EQ(1, MOIEncoderTest_EncodeWhole(test_files[i], &param, single, buffer_size, &single_size));
+            param.refine_percent = 100;
+            ASSERT_EQ(1, MOIEncoderTest_EncodeWhole(test_files[i], &param, two_pass, buffer_size, &two_pass_size));
+            EXPECT_EQ(single_size, two_pass_size);
+            EXPECT_EQ(0, memcmp(single, two_pass, single_size));
+
+            param.refine_percent = 30;
+            ASSERT_EQ(1, MOIEncoderTest_EncodeWhole(test_files[i], &param, single, buffer_size, &single_size));
+            param.num_threads = 4;
+            ASSERT_EQ(1, MOIEncoderTest_EncodeWhole(test_files[i], &param, two_pass, buffer_size, &two_pass_size));
+            EXPECT_EQ(single_size, two_pass_size);
+            EXPECT_EQ(0, memcmp(single, two_pass, single_size));
+        }
+
+        free(single);
+        free(two_pass);
+    }
+
+    /* 1パス目は各ブロックの参照誤差を出力先の範囲内にだけ置く */
+    {
+#define NUM_SAMPLES 4096
+        static int16_t samples[NUM_SAMPLES];
+        static uint8_t data[NUM_SAMPLES];
+        const int16_t *input[1];
+        uint32_t smpl, block, num_blocks, data_size;
+        struct MOIEncodeParameter param;
+        struct IMAADPCMWAVHeader header;
+
+        MOIEncoderTest_GenerateNoisySine(samples, NUM_SAMPLES);
+        input[0] = samples;
+        MOI_SetValidParameter(&param);
+        param.num_channels = 1;
+        param.refine_percent = 50;
+        ASSERT_EQ(MOI_ERROR_OK, MOIEncoder_ConvertParameterToHeader(&param, NUM_SAMPLES, &header));
+        num_blocks = (NUM_SAMPLES + header.num_samples_per_block - 1) / header.num_samples_per_block;
+        ASSERT_TRUE(num_blocks > 1);
+
+        /* 最終ブロックの先頭に参照誤差が収まらない大きさ */
+        data_size = (num_blocks - 1) * header.block_size + (uint32_t)sizeof(MOICost) - 1;
+        memset(data, 0xA5, sizeof(data));
+        (void)MOIEncoder_CalculateRefineMinBucket(&param, &header, input, NUM_SAMPLES, data, data_size);
+        for (block = 0; block < num_blocks - 1; block++) {
+            const uint32_t progress = block * header.num_samples_per_block;
+            const int16_t *block_input[1];
+            MOICost stored;
+            block_input[0] = &samples[progress];
+            memcpy(&stored, &data[block * header.block_size], sizeof(MOICost));
+            EXPECT_EQ(MOIEncoder_CalculateReferenceCost(block_input, 1,
+                        MOI_MIN_VAL(header.num_samples_per_block, NUM_SAMPLES - progress)), stored);
+        }
+        for (smpl = (num_blocks - 1) * header.block_size; smpl < sizeof(data); smpl++) {
+            EXPECT_EQ(0xA5, data[smpl]);
+        }
+#undef NUM_SAMPLES
+    }
+
+    /* 探索するブロックの割合が範囲外 */
+    {
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        MOI_SetValidParameter(&param);
+        param.refine_percent = 101;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        param.refine_percent = 100;
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        MOIEncoder_Destroy(encoder);
+    }
+}
+
+/* 定数区間の探索省略テスト */
+TEST(MOIEncoder, ConstantRunTest)
+{
+    /* 定数ブロックは最小ステップサイズと符号0で誤差なく符号化される */
+    {
+#define NUM_SAMPLES 505
+        int16_t data[NUM_SAMPLES];
+        const int16_t *input[1];
+        uint8_t buffer[512];
+        uint32_t smpl, output_size;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+        struct MOIEncodeStatistics stats;
+
+        for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+            data[smpl] = -1234;
+        }
+        input[0] = data;
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        MOI_SetValidParameter(&param);
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_EncodeBlock(encoder, input, 256, buffer, sizeof(buffer), &output_size));
+        EXPECT_EQ(0, encoder->best_init_stepsize_index[0]);
+        EXPECT_EQ(0, MOIEncoder_CalculateCodeCost(data, 256, 0, encoder->best_code[0]));
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_GetEncodeStatistics(encoder, &stats));
+        EXPECT_EQ(1, stats.num_constant_blocks);
+
+        MOIEncoder_Destroy(encoder);
+#undef NUM_SAMPLES
+    }
+
+    /* ブロック内の定数区間は探索を省略し、デフォルト候補より悪くならない */
+    {
+#define NUM_SAMPLES 505
+        int16_t input[NUM_SAMPLES];
+        uint8_t code[NUM_SAMPLES];
+        int8_t init_stepsize_index;
+        uint32_t smpl;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+        struct MOIEncodeStatistics stats;
+
+        for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+            input[smpl] = ((smpl < 100) || (smpl >= 400))
+                ? (int16_t)(8192.0 * sin((2.0 * 3.1415 * 440.0 * smpl) / 8000.0)) : 0;
+        }
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        MOI_SetValidParameter(&param);
+        param.search_beam_width = 4;
+        param.search_depth = 3;
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        EXPECT_EQ(MOI_ERROR_OK, MOIEncoder_EncodeSamples(encoder, input, NUM_SAMPLES, code, &init_stepsize_index));
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_GetEncodeStatistics(encoder, &stats));
+        EXPECT_TRUE(stats.num_constant_run_samples > 0);
+        EXPECT_TRUE(MOIEncoder_CalculateCodeCost(input, NUM_SAMPLES, init_stepsize_index, code)
+                <= encoder->default_encoder.total_cost);
+
+        MOIEncoder_Destroy(encoder);
+#undef NUM_SAMPLES
+    }
+}
+
+/* ブロックキャッシュテスト */
+TEST(MOIEncoder, BlockCacheTest)
+{
+    /* 同一内容のブロックはキャッシュから再利用され、出力はキャッシュ無しと一致する */
+    {
+#define NUM_SAMPLES (505 * 8)
+        int16_t data[NUM_SAMPLES];
+        const int16_t *input[1];
+        uint8_t *cached, *uncached;
+        const uint32_t buffer_size = 2 * NUM_SAMPLES;
+        uint32_t smpl, cached_size, uncached_size;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+        struct MOIEncodeStatistics stats;
+
+        /* ブロックサイズ256（505サンプル）を周期とする信号 */
+        for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+            data[smpl] = (int16_t)(8192.0 * sin((2.0 * 3.1415 * 7.0 * (smpl % 505)) / 505.0));
+        }
+        input[0] = data;
+        cached = (uint8_t *)malloc(buffer_size);
+        uncached = (uint8_t *)malloc(buffer_size);
+
+        MOI_SetValidEncoderConfig(&config);
+        MOI_SetValidParameter(&param);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_EncodeWhole(encoder, input, NUM_SAMPLES, uncached, buffer_size, &uncached_size));
+        MOIEncoder_Destroy(encoder);
+
+        config.max_block_cache_size = 4 * (uint32_t)MOIBLOCKCACHE_ENTRY_SIZE(config.max_block_size);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_EncodeWhole(encoder, input, NUM_SAMPLES, cached, buffer_size, &cached_size));
+        EXPECT_EQ(uncached_size, cached_size);
+        EXPECT_EQ(0, memcmp(uncached, cached, cached_size));
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_GetEncodeStatistics(encoder, &stats));
+        EXPECT_EQ(1, stats.block_cache_misses);
+        EXPECT_EQ(7, stats.block_cache_hits);
+
+        /* 同じパラメータなら別のエンコードでも再利用される */
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_EncodeWhole(encoder, input, NUM_SAMPLES, cached, buffer_size, &cached_size));
+        EXPECT_EQ(0, memcmp(uncached, cached, cached_size));
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_GetEncodeStatistics(encoder, &stats));
+        EXPECT_EQ(0, stats.block_cache_misses);
+        EXPECT_EQ(8, stats.block_cache_hits);
+
+        /* パラメータが変われば無効化される */
+        param.search_beam_width = 1;
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_EncodeWhole(encoder, input, NUM_SAMPLES, cached, buffer_size, &cached_size));
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_GetEncodeStatistics(encoder, &stats));
+        EXPECT_EQ(1, stats.block_cache_misses);
+        EXPECT_EQ(7, stats.block_cache_hits);
+
+        MOIEncoder_Destroy(encoder);
+        free(cached);
+        free(uncached);
+#undef NUM_SAMPLES
+    }
+
+    /* ハッシュが一致してもサンプルが異なれば再利用しない */
+    {
+        int16_t data[2][505];
+        const int16_t *input[1];
+        uint32_t smpl, hash, index;
+        uint8_t code[505];
+        uint8_t *code_ptr[1];
+        int8_t init_stepsize_index[MOI_MAX_NUM_CHANNELS] = { 0, };
+        const int8_t init_seed[MOI_MAX_NUM_CHANNELS] = { -1, -1 };
+        const int8_t other_seed[MOI_MAX_NUM_CHANNELS] = { 10, -1 };
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+
+        for (smpl = 0; smpl < 505; smpl++) {
+            data[0][smpl] = (int16_t)smpl;
+            data[1][smpl] = (int16_t)smpl;
+            code[smpl] = 0;
+        }
+        data[1][100] = 0;
+        code_ptr[0] = code;
+
+        MOI_SetValidEncoderConfig(&config);
+        config.max_block_cache_size = 4 * (uint32_t)MOIBLOCKCACHE_ENTRY_SIZE(config.max_block_size);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+
+        input[0] = data[0];
+        hash = MOIBlockCache_CalculateHash(input, 1, 505, 0, init_seed);
+        index = MOIBlockCache_GetEntryIndex(&(encoder->block_cache), hash);
+        MOIBlockCache_Store(&(encoder->block_cache), index, hash,
+                input, 1, 505, 0, init_seed, code_ptr, init_stepsize_index);
+        EXPECT_EQ(1, MOIBlockCache_IsMatch(&(encoder->block_cache), index, hash, input, 1, 505, 0, init_seed));
+        EXPECT_EQ(0, MOIBlockCache_IsMatch(&(encoder->block_cache), index, hash, input, 1, 505, 1, init_seed));
+        EXPECT_EQ(0, MOIBlockCache_IsMatch(&(encoder->block_cache), index, hash, input, 1, 505, 0, other_seed));
+        input[0] = data[1];
+        EXPECT_EQ(0, MOIBlockCache_IsMatch(&(encoder->block_cache), index, hash, input, 1, 505, 0, init_seed));
+
+        MOIEncoder_Destroy(encoder);
+    }
+}
+
+/* 初期ステップサイズインデックスの探索範囲の絞り込みテスト */
+TEST(MOIEncoder, InitSearchWindowTest)
+{
+    /* 探索範囲を指定してエンコードデコード */
+    {
+        static const char *test_files[] = {
+            "unit_impulse_mono.wav", "unit_impulse.wav", "sin300Hz_mono.wav", "sin300Hz.wav" };
+        static const uint32_t windows[] = { 1, 4 };
+        uint32_t i, j;
+        struct MOIEncodeParameter param;
+
+        for (i = 0; i < sizeof(test_files) / sizeof(test_files[0]); i++) {
+            for (j = 0; j < sizeof(windows) / sizeof(windows[0]); j++) {
+                MOI_SetValidParameter(&param);
+                param.init_search_window = windows[j];
+                EXPECT_EQ(1, MOIEncoderTest_EncodeDecodeWithParameterTest(test_files[i], &param, 5.0e-2));
+            }
+        }
+    }
+
+    /* スレッド数に依らず出力が一致する */
+    {
+        static const char *test_files[] = { "sin300Hz_mono.wav", "sin300Hz.wav" };
+        const uint32_t buffer_size = 128 * 1024;
+        uint8_t *serial, *parallel;
+        uint32_t i, serial_size, parallel_size;
+        struct MOIEncodeParameter param;
+
+        serial = (uint8_t *)malloc(buffer_size);
+        parallel = (uint8_t *)malloc(buffer_size);
+
+        for (i = 0; i < sizeof(test_files) / sizeof(test_files[0]); i++) {
+            MOI_SetValidParameter(&param);
+            param.init_search_window = 2;
+            ASSERT_EQ(1, MOIEncoderTest_EncodeWhole(test_files[i], &param, serial, buffer_size, &serial_size));
+            param.num_threads = 3;
+            ASSERT_EQ(1, MOIEncoderTest_EncodeWhole(test_files[i], &param, parallel, buffer_size, &parallel_size));
+            EXPECT_EQ(serial_size, parallel_size);
+            EXPECT_EQ(0, memcmp(serial, parallel, serial_size));
+        }
+
+        free(serial);
+        free(parallel);
+    }
+
+    /* 範囲の端で最小となる場合は範囲を広げる */
+    {
+#define NUM_SAMPLES 505
+        int16_t input[NUM_SAMPLES];
+        uint8_t code[NUM_SAMPLES];
+        int8_t init_stepsize_index;
+        uint32_t smpl;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+        struct MOIEncodeStatistics stats;
+
+        /* 先頭から大振幅で、大きなステップサイズが最適 */
+        for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+            input[smpl] = (smpl & 1) ? 16000 : -16000;
+        }
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        MOI_SetValidParameter(&param);
+        param.init_search_window = 1;
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        encoder->init_seed = 0;
+        EXPECT_EQ(MOI_ERROR_OK, MOIEncoder_EncodeSamples(encoder, input, NUM_SAMPLES, code, &init_stepsize_index));
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_GetEncodeStatistics(encoder, &stats));
+        EXPECT_TRUE(stats.init_search_num_evaluations > 2);
+        EXPECT_TRUE(stats.init_search_num_evaluations < MOI_IMAADPCM_STEPSIZE_TABLE_SIZE);
+        EXPECT_TRUE(init_stepsize_index > 2);
+
+        MOIEncoder_Destroy(encoder);
+#undef NUM_SAMPLES
+    }
+}
+
+/* 展開先スコア計算テスト */
+TEST(MOIEncoder, ScoreExpansionsTest)
+{
+    /* 親の先読みスコアで探索を省略しても全探索と同じ上位が選ばれる */
+    {
+#define NUM_SAMPLES 16
+#define NUM_PARENTS 4
+#define NUM_EXPANSIONS (NUM_PARENTS * MOIENCODER_NUM_CODES)
+        static const int16_t prev_samples[NUM_PARENTS] = { 0, 500, -500, 1000 };
+        static const int8_t stepsize_indices[NUM_PARENTS] = { 10, 20, 30, 40 };
+        static const uint32_t depths[] = { 1, 4, 5, 7 };
+        int16_t input[NUM_SAMPLES];
+        MOICost reference[NUM_EXPANSIONS];
+        uint32_t selected[NUM_PARENTS], reference_selected[NUM_PARENTS];
+        uint32_t smpl, i, j, k, num_select;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+        struct MOISearchContext context;
+
+        srand(0);
+        for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+            input[smpl] = (int16_t)((rand() % 2048) - 1024);
+        }
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        MOI_SetValidParameter(&param);
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        context.cache = &(encoder->search_cache);
+        context.statistics = &(encoder->statistics);
+        context.use_lower_bound = 0;
+
+        for (i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+            for (num_select = 1; num_select <= NUM_PARENTS; num_select++) {
+                MOISearchCache_Clear(&(encoder->search_cache), input);
+                memset(&(encoder->statistics), 0, sizeof(struct MOIEncodeStatistics));
+
+                /* 親の先読みスコアを計算し、全符号で展開 */
+                for (j = 0; j < NUM_PARENTS; j++) {
+                    struct MOICoreEncoder parent;
+                    parent.prev_sample = prev_samples[j];
+                    parent.stepsize_index = stepsize_indices[j];
+                    parent.total_cost = 0;
+                    encoder->candidate.lookahead_score[j]
+                        = MOICoreEncoder_SearchMinScore(&parent, input, depths[i], MOICOST_MAX, &context);
+                    for (k = 0; k < MOIENCODER_NUM_CODES; k++) {
+                        struct MOICoreEncoder child = parent;
+                        const uint32_t index = j * MOIENCODER_NUM_CODES + k;
+                        MOICoreEncoder_Update(&child, input[0], (uint8_t)k);
+                        encoder->expansion.prev_sample[index] = child.prev_sample;
+                        encoder->expansion.stepsize_index[index] = child.stepsize_index;
+                        encoder->expansion.total_cost[index] = child.total_cost;
+                        encoder->expansion_trace[index].parent = (uint8_t)j;
+                        reference[index]
+                            = MOICoreEncoder_SearchMinScore(&child, &input[1], depths[i] - 1, MOICOST_MAX, &context);
+                    }
+                }
+
+                MOIEncoder_ScoreExpansions(encoder, NUM_PARENTS, NUM_EXPANSIONS, num_select, depths[i], &input[1], MOICOST_MAX, &context);
+                MOICoreEncoder_SelectTopKIndices(reference, NUM_EXPANSIONS, num_select, reference_selected);
+                MOICoreEncoder_SelectTopKIndices(encoder->expansion_score, NUM_EXPANSIONS, num_select, selected);
+                for (j = 0; j < num_select; j++) {
+                    EXPECT_EQ(reference_selected[j], selected[j]);
+                    EXPECT_EQ(reference[selected[j]], encoder->expansion_score[selected[j]]);
+                }
+
+                /* 上界を与えた場合、上界以下のスコアは一致し、それ以外は上界を越える */
+                {
+                    const MOICost upper_bound = reference[reference_selected[num_select / 2]];
+                    MOIEncoder_ScoreExpansions(encoder, NUM_PARENTS, NUM_EXPANSIONS, num_select, depths[i], &input[1], upper_bound, &context);
+                    MOICoreEncoder_SelectTopKIndices(encoder->expansion_score, NUM_EXPANSIONS, num_select, selected);
+                    for (j = 0; j < num_select; j++) {
+                        if (reference[reference_selected[j]] <= upper_bound) {
+                            EXPECT_EQ(reference[reference_selected[j]], encoder->expansion_score[selected[j]]);
+                        } else {
+                            EXPECT_TRUE(encoder->expansion_score[selected[j]] > upper_bound);
+                        }
+                    }
+                }
+                /* 深い探索では省略が起こる */
+                if (depths[i] >= MOIENCODER_SKIP_EXPANSION_MIN_DEPTH) {
+                    EXPECT_TRUE(encoder->statistics.search_num_skipped_expansions > 0);
+                } else {
+                    EXPECT_EQ(0, encoder->statistics.search_num_skipped_expansions);
+                }
+            }
+        }
+
+        MOIEncoder_Destroy(encoder);
+#undef NUM_SAMPLES
+#undef NUM_PARENTS
+#undef NUM_EXPANSIONS
+    }
+}
+
+/* 局所探索テスト */
+TEST(MOIEncoder, LocalSearchTest)
+{
+    /* 局所探索を有効にしてエンコードデコード */
+    {
+        static const char *test_files[] = {
+            "unit_impulse_mono.wav", "unit_impulse.wav", "sin300Hz_mono.wav", "sin300Hz.wav" };
+        static const uint32_t sweeps[] = { 1, 4 };
+        uint32_t i, j;
+        struct MOIEncodeParameter param;
+
+        for (i = 0; i < sizeof(test_files) / sizeof(test_files[0]); i++) {
+            for (j = 0; j < sizeof(sweeps) / sizeof(sweeps[0]); j++) {
+                MOI_SetValidParameter(&param);
+                param.local_search_sweeps = sweeps[j];
+                EXPECT_EQ(1, MOIEncoderTest_EncodeDecodeWithParameterTest(test_files[i], &param, 5.0e-2));
+                param.search_method = MOI_SEARCH_METHOD_TRELLIS;
+                EXPECT_EQ(1, MOIEncoderTest_EncodeDecodeWithParameterTest(test_files[i], &param, 5.0e-2));
+            }
+        }
+    }
+
+    /* IMA-ADPCMの符号列を改善し、返り値は改善後の符号列のコストに一致する */
+    {
+#define NUM_SAMPLES 1024
+        static const uint32_t sweeps[] = { 1, 2, 8 };
+        int16_t input[NUM_SAMPLES];
+        uint8_t code[NUM_SAMPLES];
+        uint32_t smpl, i;
+        MOICost initial_cost, cost, prev_cost;
+        struct MOICoreEncoder state[NUM_SAMPLES + 1];
+        struct MOIEncodeStatistics stats;
+
+        MOIEncoderTest_GenerateNoisySine(input, NUM_SAMPLES);
+        initial_cost = MOIEncoder_EncodeSamplesIMAADPCM(input, NUM_SAMPLES, code);
+
+        prev_cost = initial_cost;
+        for (i = 0; i < sizeof(sweeps) / sizeof(sweeps[0]); i++) {
+            memset(&stats, 0, sizeof(struct MOIEncodeStatistics));
+            MOIEncoder_EncodeSamplesIMAADPCM(input, NUM_SAMPLES, code);
+            cost = MOIEncoder_ImproveCodeLocally(input, NUM_SAMPLES, 0, code, sweeps[i], state, &stats);
+            EXPECT_EQ(MOIEncoder_CalculateCodeCost(input, NUM_SAMPLES, 0, code), cost);
+            EXPECT_TRUE(cost < initial_cost);
+            EXPECT_TRUE(cost <= prev_cost);
+            EXPECT_TRUE(stats.local_search_num_improvements > 0);
+            EXPECT_TRUE(stats.local_search_num_sweeps <= sweeps[i]);
+            prev_cost = cost;
+        }
+
+        /* 定数入力は誤差0のまま */
+        for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+            input[smpl] = 100;
+        }
+        memset(code, 0, sizeof(code));
+        memset(&stats, 0, sizeof(struct MOIEncodeStatistics));
+        EXPECT_EQ(0, MOIEncoder_ImproveCodeLocally(input, NUM_SAMPLES, 0, code, 4, state, &stats));
+        EXPECT_EQ(0, stats.local_search_num_improvements);
+        EXPECT_EQ(1, stats.local_search_num_sweeps);
+#undef NUM_SAMPLES
+    }
+
+    /* 時間予算とは併用できない */
+    {
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+
+        MOI_SetValidParameter(&param);
+        param.local_search_sweeps = 4;
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        param.time_budget = 100;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        param.search_method = MOI_SEARCH_METHOD_TRELLIS;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+
+        MOIEncoder_Destroy(encoder);
+    }
+}
+
+/* ポートフォリオ符号化テスト */
+TEST(MOIEncoder, PortfolioTest)
+{
+    /* ポートフォリオ符号化でエンコードデコード */
+    {
+        static const char *test_files[] = {
+            "unit_impulse_mono.wav", "unit_impulse.wav", "sin300Hz_mono.wav", "sin300Hz.wav" };
+        uint32_t i;
+        struct MOIEncodeParameter param;
+
+        for (i = 0; i < sizeof(test_files) / sizeof(test_files[0]); i++) {
+            MOI_SetValidParameter(&param);
+            param.portfolio_size = 3;
+            param.portfolio_beam_width[0] = 1; param.portfolio_depth[0] = 1;
+            param.portfolio_beam_width[1] = 4; param.portfolio_depth[1] = 2;
+            param.portfolio_beam_width[2] = 2; param.portfolio_depth[2] = 4;
+            EXPECT_EQ(1, MOIEncoderTest_EncodeDecodeWithParameterTest(test_files[i], &param, 5.0e-2));
+        }
+    }
+
+    /* 設定が1つならば同じ探索幅・深さの通常の符号化と一致する */
+    {
+        static const char *test_files[] = { "sin300Hz_mono.wav", "sin300Hz.wav" };
+        const uint32_t buffer_size = 128 * 1024;
+        uint8_t *single, *portfolio;
+        uint32_t i, single_size, portfolio_size;
+        struct MOIEncodeParameter param;
+
+        single = (uint8_t *)malloc(buffer_size);
+        portfolio = (uint8_t *)malloc(buffer_size);
+
+        for (i = 0; i < sizeof(test_files) / sizeof(test_files[0]); i++) {
+            MOI_SetValidParameter(&param);
+            param.search_beam_width = 3;
+            param.search_depth = 4;
+            ASSERT_EQ(1, MOIEncoderTest_EncodeWhole(test_files[i], &param, single, buffer_size, &single_size));
+            param.search_beam_width = 1;
+            param.search_depth = 1;
+            param.portfolio_size = 1;
+            param.portfolio_beam_width[0] = 3;
+            param.portfolio_depth[0] = 4;
+            ASSERT_EQ(1, MOIEncoderTest_EncodeWhole(test_files[i], &param, portfolio, buffer_size, &portfolio_size));
+            EXPECT_EQ(single_size, portfolio_size);
+            EXPECT_EQ(0, memcmp(single, portfolio, single_size));
+        }
+
+        free(single);
+        free(portfolio);
+    }
+
+    /* 各設定の最小コストの結果が選ばれ、最良に届かない設定は打ち切られる */
+    {
+#define NUM_SAMPLES 1024
+        static const uint32_t beam_widths[] = { 8, 1, 2 };
+        static const uint32_t depths[] = { 4, 1, 2 };
+        int16_t input[NUM_SAMPLES];
+        uint8_t code[NUM_SAMPLES];
+        int8_t init_stepsize_index;
+        uint32_t k;
+        MOICost min_cost = MOICOST_MAX;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+        struct MOIEncodeStatistics stats;
+
+        MOIEncoderTest_GenerateNoisySine(input, NUM_SAMPLES);
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+
+        /* 各設定単独での結果 */
+        MOI_SetValidParameter(&param);
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        for (k = 0; k < sizeof(beam_widths) / sizeof(beam_widths[0]); k++) {
+            MOICost cost;
+            encoder->search_beam_width = beam_widths[k];
+            encoder->search_depth = depths[k];
+            EXPECT_EQ(MOI_ERROR_OK, MOIEncoder_EncodeSamples(encoder, input, NUM_SAMPLES, code, &init_stepsize_index));
+            cost = MOIEncoder_CalculateCodeCost(input, NUM_SAMPLES, init_stepsize_index, code);
+            min_cost = MOI_MIN_VAL(min_cost, cost);
+        }
+
+        param.portfolio_size = sizeof(beam_widths) / sizeof(beam_widths[0]);
+        for (k = 0; k < param.portfolio_size; k++) {
+            param.portfolio_beam_width[k] = beam_widths[k];
+            param.portfolio_depth[k] = depths[k];
+        }
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+        EXPECT_EQ(MOI_ERROR_OK, MOIEncoder_EncodeSamplesPortfolio(encoder, input, NUM_SAMPLES, code, &init_stepsize_index));
+        EXPECT_EQ(min_cost, MOIEncoder_CalculateCodeCost(input, NUM_SAMPLES, init_stepsize_index, code));
+        EXPECT_EQ(MOICOST_MAX, encoder->cost_bound);
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_GetEncodeStatistics(encoder, &stats));
+        EXPECT_EQ(param.portfolio_size, stats.portfolio_num_runs);
+        EXPECT_EQ(2, stats.portfolio_num_aborts);
+        EXPECT_EQ(1, stats.portfolio_num_wins[0]);
+
+        MOIEncoder_Destroy(encoder);
+#undef NUM_SAMPLES
+    }
+
+    /* 不正なパラメータ */
+    {
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+
+#define MOI_SetValidPortfolioParameter(p__param) {\
+    MOI_SetValidParameter(p__param);\
+    (p__param)->portfolio_size = 2;\
+    (p__param)->portfolio_beam_width[0] = 2; (p__param)->portfolio_depth[0] = 2;\
+    (p__param)->portfolio_beam_width[1] = 4; (p__param)->portfolio_depth[1] = 3;\
+}
+        MOI_SetValidPortfolioParameter(&param);
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+
+        /* 設定数が多すぎる */
+        MOI_SetValidPortfolioParameter(&param);
+        param.portfolio_size = MOI_MAX_PORTFOLIO_SIZE + 1;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+
+        /* 探索幅・深さが範囲外 */
+        MOI_SetValidPortfolioParameter(&param);
+        param.portfolio_beam_width[1] = 0;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        MOI_SetValidPortfolioParameter(&param);
+        param.portfolio_beam_width[1] = MOI_MAX_SEARCH_BEAM_WIDTH + 1;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        MOI_SetValidPortfolioParameter(&param);
+        param.portfolio_depth[0] = 0;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        MOI_SetValidPortfolioParameter(&param);
+        param.portfolio_depth[0] = MOI_MAX_SEARCH_DEPTH + 1;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+
+        /* 適応探索・時間予算とは併用できない */
+        MOI_SetValidPortfolioParameter(&param);
+        param.search_adaptive = 1;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        MOI_SetValidPortfolioParameter(&param);
+        param.time_budget = 100;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+
+        /* トレリス探索とは併用できない（設定数が範囲外でも同様） */
+        MOI_SetValidPortfolioParameter(&param);
+        param.search_method = MOI_SEARCH_METHOD_TRELLIS;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        param.portfolio_size = MOI_MAX_PORTFOLIO_SIZE + 1;
+        EXPECT_EQ(MOI_APIRESULT_INVALID_FORMAT, MOIEncoder_SetEncodeParameter(encoder, &param));
+        param.portfolio_size = 0;
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+#undef MOI_SetValidPortfolioParameter
+
+        MOIEncoder_Destroy(encoder);
+    }
+}
+
+TEST(MOIEncoder, ReferencePruneTest)
+{
+    /* IMA-ADPCMの候補の合計コストを上界に探索しても、結果はIMA-ADPCMより悪くならない */
+    {
+#define NUM_SAMPLES 1024
+        static const uint32_t beam_widths[] = { 1, 4, 8 };
+        static const uint32_t depths[] = { 1, 2, 4 };
+        int16_t input[NUM_SAMPLES];
+        uint8_t code[NUM_SAMPLES];
+        int8_t init_stepsize_index;
+        uint32_t k;
+        MOICost min_cost = MOICOST_MAX;
+        struct MOIEncoder *encoder;
+        struct MOIEncoderConfig config;
+        struct MOIEncodeParameter param;
+
+        MOIEncoderTest_GenerateNoisySine(input, NUM_SAMPLES);
+
+        MOI_SetValidEncoderConfig(&config);
+        encoder = MOIEncoder_Create(&config, NULL, 0);
+        MOI_SetValidParameter(&param);
+        EXPECT_EQ(MOI_APIRESULT_OK, MOIEncoder_SetEncodeParameter(encoder, &param));
+
+        for (k = 0; k < sizeof(beam_widths) / sizeof(beam_widths[0]); k++) {
+            MOICost cost, default_cost;
+            encoder->search_beam_width = beam_widths[k];
+            encoder->search_depth = depths[k];
+            EXPECT_EQ(MOI_ERROR_OK, MOIEncoder_EncodeSamples(encoder, input, NUM_SAMPLES, code, &init_stepsize_index));
+            cost = MOIEncoder_CalculateCodeCost(input, NUM_SAMPLES, init_stepsize_index, code);
+            default_cost = MOIEncoder_CalculateCodeCost(input, NUM_SAMPLES,
+                    encoder->default_init_stepsize_index, encoder->default_code);
+            EXPECT_TRUE(cost <= default_cost);
+            EXPECT_TRUE(encoder->statistics.search_num_reference_prunes
+                    <= encoder->statistics.search_num_selected_candidates);
+            min_cost = MOI_MIN_VAL(min_cost, cost);
+        }
+
+        /* 打ち切りコストが与えられたら、それを越える候補が除かれる */
+        memset(&(encoder->statistics), 0, sizeof(struct MOIEncodeStatistics));
+        encoder->cost_bound = min_cost;
+        encoder->search_aborted = 0;
+        encoder->search_beam_width = 4;
+        encoder->search_depth = 2;
+        EXPECT_EQ(MOI_ERROR_OK, MOIEncoder_EncodeSamples(encoder, input, NUM_SAMPLES, code, &init_stepsize_index));
+        EXPECT_TRUE(encoder->statistics.search_num_reference_prunes > 0);
+        if (!encoder->search_aborted) {
+            EXPECT_TRUE(MOIEncoder_CalculateCodeCost(input, NUM_SAMPLES, init_stepsize_index, code) < min_cost);
+        }
+        encoder->cost_bound = MOICOST_MAX;
+
+        MOIEncoder_Destroy(encoder);
+#undef NUM_SAMPLES
+    }
+}
+
+/* 次状態テーブルのテスト */
+TEST(MOIEncoder, NextStateTableTest)
+{
+    /* 量子化誤差の絶対値テーブルの行はベクトル1回のロードに収まるよう整列している */
+    EXPECT_EQ(16, sizeof(MOI_qdiff_magnitude_table[0]));
+    EXPECT_EQ(0, (uintptr_t)MOI_qdiff_magnitude_table % MOI_ALIGNMENT);
+
+    /* 量子化した差分と次のインデックスが各テーブルから計算した値と一致する */
+    {
+        uint32_t i, nibble;
+        for (i = 0; i < MOI_IMAADPCM_STEPSIZE_TABLE_SIZE; i++) {
+            for (nibble = 0; nibble < 16; nibble++) {
+                const int32_t next_state = MOI_next_state_table[i][nibble];
+                const int32_t magnitude = (IMAADPCM_stepsize_table[i] * (((int32_t)(nibble & 7) << 1) + 1)) >> 3;
+                const int32_t index = MOI_INNER_VAL((int32_t)i + IMAADPCM_index_table[nibble], 0, (int32_t)MOI_IMAADPCM_STEPSIZE_TABLE_SIZE - 1);
+                EXPECT_EQ((nibble & 8) ? -magnitude : magnitude, MOI_NEXT_STATE_QDIFF(next_state));
+                EXPECT_EQ(MOI_QUANTIZED_DIFF(i, nibble), MOI_NEXT_STATE_QDIFF(next_state));
+                EXPECT_EQ(index, MOI_NEXT_STATE_INDEX(next_state));
+                /* 要素は非負（負数の右シフトを使わずに取り出せる） */
+                EXPECT_TRUE(next_state >= 0);
+            }
+        }
+    }
 }
 
 int main(int argc, char **argv)
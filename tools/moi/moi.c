@@ -8,6 +8,9 @@
 #include "wav.h"
 #include "command_line_parser.h"
 
+/* スレッドあたりの先読み探索キャッシュサイズ[byte] */
+#define MOI_DEFAULT_SEARCH_CACHE_SIZE (1UL << 20)
+
 /* コマンドライン仕様 */
 static struct CommandLineParserSpecification command_line_spec[] = {
     { 'e', "encode", "Encode mode (PCM wav -> IMA-ADPCM wav)",
@@ -22,6 +25,34 @@ static struct CommandLineParserSpecification command_line_spec[] = {
         COMMAND_LINE_PARSER_TRUE, "4", COMMAND_LINE_PARSER_FALSE },
     { 'D', "search-depth", "Specify search depth in encoding (default:3)",
         COMMAND_LINE_PARSER_TRUE, "3", COMMAND_LINE_PARSER_FALSE },
+    { 'A', "adaptive-search", "Adapt search beam width and depth per block by encoding difficulty (-W/-D are the maximum)",
+        COMMAND_LINE_PARSER_FALSE, NULL, COMMAND_LINE_PARSER_FALSE },
+    { 'w', "min-search-beam-width", "Specify minimum search beam width in adaptive search (default:1)",
+        COMMAND_LINE_PARSER_TRUE, "1", COMMAND_LINE_PARSER_FALSE },
+    { 'p', "min-search-depth", "Specify minimum search depth in adaptive search (default:1)",
+        COMMAND_LINE_PARSER_TRUE, "1", COMMAND_LINE_PARSER_FALSE },
+    { 't', "time-budget", "Specify encoding time budget per second of audio in milliseconds, per thread (default:0 = unlimited)",
+        COMMAND_LINE_PARSER_TRUE, "0", COMMAND_LINE_PARSER_FALSE },
+    { 'r', "refine-percent", "Two-pass encoding: search only this percentage of blocks with the worst IMA-ADPCM error (default:0)",
+        COMMAND_LINE_PARSER_TRUE, "0", COMMAND_LINE_PARSER_FALSE },
+    { 'R', "refine-threshold", "Two-pass encoding: also search blocks whose IMA-ADPCM mean squared error exceeds this (default:0 = disabled)",
+        COMMAND_LINE_PARSER_TRUE, "0", COMMAND_LINE_PARSER_FALSE },
+    { 'I', "init-search-window", "Search initial step index only within this distance from the previous block's last index (default:0 = full search)",
+        COMMAND_LINE_PARSER_TRUE, "0", COMMAND_LINE_PARSER_FALSE },
+    { 'l', "local-search-sweeps", "Improve searched codes by changing one code at a time, up to this many sweeps per block (not with -t, default:0 = disabled)",
+        COMMAND_LINE_PARSER_TRUE, "0", COMMAND_LINE_PARSER_FALSE },
+    { 'P', "portfolio", "Portfolio encoding: encode each block with these comma-separated WIDTHxDEPTH search settings and keep the best (e.g. 2x2,4x3,8x5, default: disabled)",
+        COMMAND_LINE_PARSER_TRUE, "", COMMAND_LINE_PARSER_FALSE },
+    { 'C', "block-cache-size", "Specify per-thread cache size in KiB to reuse results of duplicate blocks (default:0 = disabled)",
+        COMMAND_LINE_PARSER_TRUE, "0", COMMAND_LINE_PARSER_FALSE },
+    { 'L', "lower-bound", "Prune lookahead search by lower bound of remaining cost (same result, faster at deep search)",
+        COMMAND_LINE_PARSER_FALSE, NULL, COMMAND_LINE_PARSER_FALSE },
+    { 'T', "num-threads", "Specify number of threads in encoding (default:1)",
+        COMMAND_LINE_PARSER_TRUE, "1", COMMAND_LINE_PARSER_FALSE },
+    { 'M', "search-method", "Specify search method in encoding: beam or trellis (default:beam)",
+        COMMAND_LINE_PARSER_TRUE, "beam", COMMAND_LINE_PARSER_FALSE },
+    { 'S', "trellis-num-states", "Specify number of states in trellis search (default:16)",
+        COMMAND_LINE_PARSER_TRUE, "16", COMMAND_LINE_PARSER_FALSE },
     { 'h', "help", "Show command help message",
         COMMAND_LINE_PARSER_FALSE, NULL, COMMAND_LINE_PARSER_FALSE },
     { 'v', "version", "Show version information",
@@ -109,10 +140,74 @@ static int do_decode(const char *adpcm_filename, const char *decoded_filename)
     return 0;
 }
 
+/* 探索の統計情報を表示 */
+static void print_encode_statistics(const struct MOIEncoder *encoder)
+{
+    struct MOIEncodeStatistics stats;
+
+    if (MOIEncoder_GetEncodeStatistics(encoder, &stats) == MOI_APIRESULT_OK) {
+        const double num_lookups = (double)(stats.search_cache_hits + stats.search_cache_misses);
+        const double num_blocks = (double)stats.num_searched_blocks;
+        printf("Search nodes:%.0f \n", (double)stats.search_num_nodes);
+        printf("Lower bound prunes:%.0f \n", (double)stats.search_num_bound_prunes);
+        printf("Search cache hit rate:%f \n",
+                (num_lookups > 0.0) ? ((double)stats.search_cache_hits / num_lookups) : 0.0);
+        printf("Skipped expansions:%.0f \n", (double)stats.search_num_skipped_expansions);
+        printf("Reference bound prune rate:%f \n", (stats.search_num_selected_candidates > 0)
+                ? ((double)stats.search_num_reference_prunes / (double)stats.search_num_selected_candidates) : 0.0);
+        printf("Average search beam width:%f \n",
+                (num_blocks > 0.0) ? ((double)stats.total_search_beam_width / num_blocks) : 0.0);
+        printf("Average search depth:%f \n",
+                (num_blocks > 0.0) ? ((double)stats.total_search_depth / num_blocks) : 0.0);
+        printf("Deadline fallbacks:%.0f \n", (double)stats.num_deadline_fallbacks);
+        printf("Forced trace commits:%.0f \n", (double)stats.num_forced_trace_commits);
+        printf("Average initial step index evaluations:%f \n",
+                (num_blocks > 0.0) ? ((double)stats.init_search_num_evaluations / num_blocks) : 0.0);
+        printf("Block cache hit rate:%f \n",
+                ((stats.block_cache_hits + stats.block_cache_misses) > 0)
+                ? ((double)stats.block_cache_hits / (double)(stats.block_cache_hits + stats.block_cache_misses)) : 0.0);
+        printf("Constant blocks:%.0f Constant run samples:%.0f \n",
+                (double)stats.num_constant_blocks, (double)stats.num_constant_run_samples);
+        /* 2パス符号化の効果: 探索によるRMSEの改善と、探索時間あたりの改善量 */
+        if (stats.reference_num_samples > 0) {
+            const double num_samples = (double)stats.reference_num_samples;
+            const double reference_rmse = sqrt((double)stats.reference_total_cost / num_samples) / 32768.0;
+            const double refined_rmse = sqrt(((double)stats.reference_total_cost
+                        - (double)stats.refined_reference_cost + (double)stats.refined_cost) / num_samples) / 32768.0;
+            const double refine_seconds = (double)stats.refine_time / 1.0e6;
+            printf("Refined blocks:%.0f \n", (double)stats.num_refined_blocks);
+            printf("Reference RMSE:%f Refined RMSE:%f \n", reference_rmse, refined_rmse);
+            printf("RMSE gain per CPU second:%e \n",
+                    (refine_seconds > 0.0) ? ((reference_rmse - refined_rmse) / refine_seconds) : 0.0);
+        }
+        /* ポートフォリオ符号化: 打ち切りの割合と各設定が最良だった回数 */
+        if (stats.portfolio_num_runs > 0) {
+            uint32_t k;
+            printf("Portfolio runs:%.0f Aborted runs:%.0f \n",
+                    (double)stats.portfolio_num_runs, (double)stats.portfolio_num_aborts);
+            printf("Portfolio wins:");
+            for (k = 0; k < MOI_MAX_PORTFOLIO_SIZE; k++) {
+                printf(" %.0f", (double)stats.portfolio_num_wins[k]);
+            }
+            printf(" \n");
+        }
+        /* 局所探索の効果: 探索結果からのRMSEの改善と所要時間 */
+        if (stats.local_search_num_samples > 0) {
+            const double num_samples = (double)stats.local_search_num_samples;
+            printf("Local search sweeps:%.0f Improved codes:%.0f \n",
+                    (double)stats.local_search_num_sweeps, (double)stats.local_search_num_improvements);
+            printf("Local search RMSE before:%f after:%f Time:%f sec \n",
+                    sqrt((double)stats.local_search_initial_cost / num_samples) / 32768.0,
+                    sqrt((double)stats.local_search_final_cost / num_samples) / 32768.0,
+                    (double)stats.local_search_time / 1.0e6);
+        }
+    }
+}
+
 /* エンコード処理 */
 static int do_encode(
         const char *wav_file, const char *encoded_filename,
-        uint16_t block_size, uint32_t search_beam_width, uint32_t search_depth)
+        const struct MOIEncodeParameter *parameter, uint32_t block_cache_size)
 {
     FILE *fp;
     struct WAVFile *wavfile;
@@ -153,16 +248,17 @@ static int do_encode(
     }
 
     /* ハンドル作成 */
-    config.max_block_size = block_size;
+    config.max_block_size = parameter->block_size;
+    config.max_num_threads = parameter->num_threads;
+    config.max_search_cache_size = MOI_DEFAULT_SEARCH_CACHE_SIZE;
+    config.max_block_cache_size = block_cache_size;
     encoder = MOIEncoder_Create(&config, NULL, 0);
 
     /* エンコードパラメータをセット */
+    enc_param = (*parameter);
     enc_param.num_channels = (uint16_t)num_channels;
     enc_param.sampling_rate = wavfile->format.sampling_rate;
     enc_param.bits_per_sample = MOI_BITS_PER_SAMPLE;
-    enc_param.block_size = block_size;
-    enc_param.search_beam_width = search_beam_width;
-    enc_param.search_depth = search_depth;
     if ((api_result = MOIEncoder_SetEncodeParameter(encoder, &enc_param))
             != MOI_APIRESULT_OK) {
         fprintf(stderr, "Failed to set encode parameter. API result:%d \n", api_result);
@@ -177,6 +273,11 @@ static int do_encode(
         return 1;
     }
 
+    /* 時間予算・2パス符号化を指定した場合は実際に使った探索の労力を表示 */
+    if ((enc_param.time_budget > 0) || (enc_param.refine_percent > 0) || (enc_param.refine_threshold > 0)) {
+        print_encode_statistics(encoder);
+    }
+
     /* ファイル書き出し */
     fp = fopen(encoded_filename, "wb");
     if (fp == NULL) {
@@ -202,7 +303,8 @@ static int do_encode(
 
 /* 再構成処理 */
 static int do_reconstruction_core(
-        const char *wav_file, int16_t **decoded, const struct MOIEncodeParameter *parameter)
+        const char *wav_file, int16_t **decoded,
+        const struct MOIEncodeParameter *parameter, uint32_t block_cache_size)
 {
     struct WAVFile *wavfile;
     struct stat fstat;
@@ -243,6 +345,9 @@ static int do_reconstruction_core(
 
     /* ハンドル作成 */
     enc_config.max_block_size = parameter->block_size;
+    enc_config.max_num_threads = parameter->num_threads;
+    enc_config.max_search_cache_size = MOI_DEFAULT_SEARCH_CACHE_SIZE;
+    enc_config.max_block_cache_size = block_cache_size;
     encoder = MOIEncoder_Create(&enc_config, NULL, 0);
     decoder = MOIDecoder_Create(NULL, 0);
 
@@ -261,6 +366,9 @@ static int do_reconstruction_core(
         return 1;
     }
 
+    /* 探索の統計情報を表示 */
+    print_encode_statistics(encoder);
+
     /* そのままデコード */
     if ((api_result = MOIDecoder_DecodeWhole(decoder,
                     buffer, output_size, decoded, num_channels, num_samples)) != MOI_APIRESULT_OK) {
@@ -282,8 +390,7 @@ static int do_reconstruction_core(
 
 /* 統計計算処理 */
 static int do_calculate_statistics(
-        const char *wav_file,
-        uint16_t block_size, uint32_t search_beam_width, uint32_t search_depth)
+        const char *wav_file, const struct MOIEncodeParameter *parameter, uint32_t block_cache_size)
 {
     struct WAVFile *wavfile;
     struct stat fstat;
@@ -314,15 +421,13 @@ static int do_calculate_statistics(
     buffer = malloc(buffer_size);
 
     /* エンコードパラメータをセット */
+    enc_param = (*parameter);
     enc_param.num_channels = (uint16_t)num_channels;
     enc_param.sampling_rate = wavfile->format.sampling_rate;
     enc_param.bits_per_sample = MOI_BITS_PER_SAMPLE;
-    enc_param.block_size = block_size;
-    enc_param.search_beam_width = search_beam_width;
-    enc_param.search_depth = search_depth;
 
     /* 再構成処理 */
-    if (do_reconstruction_core(wav_file, pcmdata, &enc_param) != 0) {
+    if (do_reconstruction_core(wav_file, pcmdata, &enc_param, block_cache_size) != 0) {
         return 1;
     }
 
@@ -350,6 +455,44 @@ static int do_calculate_statistics(
     return 0;
 }
 
+/* ポートフォリオ符号化の探索設定を取得（"幅x深さ"のカンマ区切り） */
+static int32_t check_get_portfolio_option(char **argv, struct MOIEncodeParameter *parameter)
+{
+    char *e;
+    const char *lstr = CommandLineParser_GetArgumentString(command_line_spec, "portfolio");
+
+    parameter->portfolio_size = 0;
+    while (*lstr != '\0') {
+        uint32_t width, depth;
+        if (parameter->portfolio_size >= MOI_MAX_PORTFOLIO_SIZE) {
+            fprintf(stderr, "%s: too many portfolio settings (maximum %d). \n", argv[0], MOI_MAX_PORTFOLIO_SIZE);
+            return 1;
+        }
+        width = (uint32_t)strtol(lstr, &e, 10);
+        if ((e == lstr) || (*e != 'x')) {
+            fprintf(stderr, "%s: invalid portfolio setting at %s. (expected WIDTHxDEPTH)\n", argv[0], lstr);
+            return 1;
+        }
+        lstr = e + 1;
+        depth = (uint32_t)strtol(lstr, &e, 10);
+        if ((e == lstr) || ((*e != ',') && (*e != '\0'))) {
+            fprintf(stderr, "%s: invalid portfolio setting at %s. (expected WIDTHxDEPTH)\n", argv[0], lstr);
+            return 1;
+        }
+        if ((width == 0) || (width > MOI_MAX_SEARCH_BEAM_WIDTH) || (depth == 0) || (depth > MOI_MAX_SEARCH_DEPTH)) {
+            fprintf(stderr, "%s: portfolio setting %dx%d is out of range (width (0,%d], depth (0,%d]). \n",
+                    argv[0], width, depth, MOI_MAX_SEARCH_BEAM_WIDTH, MOI_MAX_SEARCH_DEPTH);
+            return 1;
+        }
+        parameter->portfolio_beam_width[parameter->portfolio_size] = width;
+        parameter->portfolio_depth[parameter->portfolio_size] = depth;
+        parameter->portfolio_size++;
+        lstr = (*e == ',') ? (e + 1) : e;
+    }
+
+    return 0;
+}
+
 /* 使用法の表示 */
 static void print_usage(char** argv)
 {
@@ -385,7 +528,11 @@ int main(int argc, char **argv)
     const char *filename_ptr[2] = { NULL, NULL };
     const char *input_file;
     const char *output_file;
-    uint32_t search_beam_width, search_depth, block_size;
+    const char *search_method;
+    uint32_t search_beam_width, search_depth, block_size, num_threads, trellis_num_states;
+    uint32_t min_search_beam_width, min_search_depth, time_budget, refine_percent, refine_threshold;
+    uint32_t block_cache_size, init_search_window, local_search_sweeps;
+    struct MOIEncodeParameter enc_param;
 
     /* 引数が足らない */
     if (argc == 1) {
@@ -466,6 +613,121 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    /* 適応探索の最小探索ビーム幅を取得 */
+    if (check_get_numerical_option(argv, "min-search-beam-width", &min_search_beam_width) != 0) {
+        return 1;
+    }
+    if ((min_search_beam_width == 0) || (min_search_beam_width > search_beam_width)) {
+        fprintf(stderr, "%s: minimum search beam width(=%d) is out of range (%d,%d]. \n",
+                argv[0], min_search_beam_width, 0, search_beam_width);
+        return 1;
+    }
+
+    /* 適応探索の最小探索深さを取得 */
+    if (check_get_numerical_option(argv, "min-search-depth", &min_search_depth) != 0) {
+        return 1;
+    }
+    if ((min_search_depth == 0) || (min_search_depth > search_depth)) {
+        fprintf(stderr, "%s: minimum search depth(=%d) is out of range (%d,%d]. \n",
+                argv[0], min_search_depth, 0, search_depth);
+        return 1;
+    }
+
+    /* 時間予算を取得 */
+    if (check_get_numerical_option(argv, "time-budget", &time_budget) != 0) {
+        return 1;
+    }
+
+    /* 2パス符号化で探索するブロックの割合を取得 */
+    if (check_get_numerical_option(argv, "refine-percent", &refine_percent) != 0) {
+        return 1;
+    }
+    if (refine_percent > 100) {
+        fprintf(stderr, "%s: refine percent(=%d) is out of range [%d,%d]. \n",
+                argv[0], refine_percent, 0, 100);
+        return 1;
+    }
+
+    /* 2パス符号化で探索するブロックの誤差の閾値を取得 */
+    if (check_get_numerical_option(argv, "refine-threshold", &refine_threshold) != 0) {
+        return 1;
+    }
+
+    /* 初期ステップサイズインデックスの探索範囲を取得 */
+    if (check_get_numerical_option(argv, "init-search-window", &init_search_window) != 0) {
+        return 1;
+    }
+
+    /* 局所探索の最大反復回数を取得 */
+    if (check_get_numerical_option(argv, "local-search-sweeps", &local_search_sweeps) != 0) {
+        return 1;
+    }
+
+    /* ブロックキャッシュサイズを取得 */
+    if (check_get_numerical_option(argv, "block-cache-size", &block_cache_size) != 0) {
+        return 1;
+    }
+    if (block_cache_size > (MOI_MAX_BLOCK_CACHE_SIZE / 1024)) {
+        fprintf(stderr, "%s: block cache size(=%d) is out of range [%d,%lu]. \n",
+                argv[0], block_cache_size, 0, MOI_MAX_BLOCK_CACHE_SIZE / 1024);
+        return 1;
+    }
+    block_cache_size *= 1024;
+
+    /* スレッド数を取得 */
+    if (check_get_numerical_option(argv, "num-threads", &num_threads) != 0) {
+        return 1;
+    }
+    if ((num_threads == 0) || (num_threads > MOI_MAX_NUM_THREADS)) {
+        fprintf(stderr, "%s: number of threads(=%d) is out of range (%d,%d]. \n",
+                argv[0], num_threads, 0, MOI_MAX_NUM_THREADS);
+        return 1;
+    }
+
+    /* 探索手法を取得 */
+    search_method = CommandLineParser_GetArgumentString(command_line_spec, "search-method");
+    if (strcmp(search_method, "beam") == 0) {
+        enc_param.search_method = MOI_SEARCH_METHOD_BEAM;
+    } else if (strcmp(search_method, "trellis") == 0) {
+        enc_param.search_method = MOI_SEARCH_METHOD_TRELLIS;
+    } else {
+        fprintf(stderr, "%s: unknown search method %s. \n", argv[0], search_method);
+        return 1;
+    }
+
+    /* ポートフォリオ符号化の探索設定を取得 */
+    if (check_get_portfolio_option(argv, &enc_param) != 0) {
+        return 1;
+    }
+
+    /* トレリス探索の状態数を取得 */
+    if (check_get_numerical_option(argv, "trellis-num-states", &trellis_num_states) != 0) {
+        return 1;
+    }
+    if ((trellis_num_states == 0) || (trellis_num_states > MOI_MAX_TRELLIS_NUM_STATES)) {
+        fprintf(stderr, "%s: number of trellis states(=%d) is out of range (%d,%d]. \n",
+                argv[0], trellis_num_states, 0, MOI_MAX_TRELLIS_NUM_STATES);
+        return 1;
+    }
+
+    /* エンコードパラメータの設定 */
+    enc_param.block_size = (uint16_t)block_size;
+    enc_param.search_beam_width = search_beam_width;
+    enc_param.search_depth = search_depth;
+    enc_param.search_use_lower_bound
+        = (CommandLineParser_GetOptionAcquired(command_line_spec, "lower-bound") == COMMAND_LINE_PARSER_TRUE) ? 1 : 0;
+    enc_param.search_adaptive
+        = (CommandLineParser_GetOptionAcquired(command_line_spec, "adaptive-search") == COMMAND_LINE_PARSER_TRUE) ? 1 : 0;
+    enc_param.min_search_beam_width = min_search_beam_width;
+    enc_param.min_search_depth = min_search_depth;
+    enc_param.time_budget = time_budget;
+    enc_param.refine_percent = refine_percent;
+    enc_param.refine_threshold = refine_threshold;
+    enc_param.init_search_window = init_search_window;
+    enc_param.local_search_sweeps = local_search_sweeps;
+    enc_param.trellis_num_states = trellis_num_states;
+    enc_param.num_threads = num_threads;
+
     if (CommandLineParser_GetOptionAcquired(command_line_spec, "decode") == COMMAND_LINE_PARSER_TRUE) {
         /* 一括デコード実行 */
         if (do_decode(input_file, output_file) != 0) {
@@ -474,13 +736,13 @@ int main(int argc, char **argv)
         }
     } else if (CommandLineParser_GetOptionAcquired(command_line_spec, "encode") == COMMAND_LINE_PARSER_TRUE) {
         /* 一括エンコード実行 */
-        if (do_encode(input_file, output_file, (uint16_t)block_size, search_beam_width, search_depth) != 0) {
+        if (do_encode(input_file, output_file, &enc_param, block_cache_size) != 0) {
             fprintf(stderr, "%s: failed to encode %s. \n", argv[0], input_file);
             return 1;
         }
     } else if (CommandLineParser_GetOptionAcquired(command_line_spec, "calculate-stats") == COMMAND_LINE_PARSER_TRUE) {
         /* 統計出力処理実行 */
-        if (do_calculate_statistics(input_file, (uint16_t)block_size, search_beam_width, search_depth) != 0) {
+        if (do_calculate_statistics(input_file, &enc_param, block_cache_size) != 0) {
             fprintf(stderr, "%s: failed to calculate statistics %s. \n", argv[0], input_file);
             return 1;
         }
@@ -0,0 +1,249 @@
+/* clock_gettimeを使うため */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "moi.h"
+#include "command_line_parser.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* ベンチマークのサンプリングレート */
+#define MOIBENCH_SAMPLING_RATE 44100
+/* ベンチマークのチャンネル数 */
+#define MOIBENCH_NUM_CHANNELS 2
+/* ベンチマークのブロックサイズ */
+#define MOIBENCH_BLOCK_SIZE 1024
+/* スレッドあたりの先読み探索キャッシュサイズ[byte]（moiコマンドの既定値と同じ） */
+#define MOIBENCH_SEARCH_CACHE_SIZE (1UL << 20)
+
+/* 計測する探索設定 */
+struct MOIBenchSetting {
+    const char *name; /* 表示名 */
+    MOISearchMethod search_method; /* 探索手法 */
+    uint32_t search_beam_width; /* 探索ビーム幅 */
+    uint32_t search_depth; /* 探索深さ */
+    uint32_t trellis_num_states; /* トレリス探索の状態数 */
+};
+
+/* 計測する探索設定の一覧 */
+static const struct MOIBenchSetting bench_settings[] = {
+    { "W4 D3",       MOI_SEARCH_METHOD_BEAM,     4, 3,  0 },
+    { "W8 D5",       MOI_SEARCH_METHOD_BEAM,     8, 5,  0 },
+    { "W16 D2",      MOI_SEARCH_METHOD_BEAM,    16, 2,  0 },
+    { "trellis S16", MOI_SEARCH_METHOD_TRELLIS,  0, 0, 16 },
+};
+
+/* コマンドライン仕様 */
+static struct CommandLineParserSpecification command_line_spec[] = {
+    { 's', "seconds", "Specify length of the generated input in seconds (default:4)",
+        COMMAND_LINE_PARSER_TRUE, "4", COMMAND_LINE_PARSER_FALSE },
+    { 'n', "num-repeats", "Specify number of runs per setting, the fastest is reported (default:5)",
+        COMMAND_LINE_PARSER_TRUE, "5", COMMAND_LINE_PARSER_FALSE },
+    { 'T', "num-threads", "Specify number of threads in the multi-threaded runs (default:4)",
+        COMMAND_LINE_PARSER_TRUE, "4", COMMAND_LINE_PARSER_FALSE },
+    { 'h', "help", "Show command help message",
+        COMMAND_LINE_PARSER_FALSE, NULL, COMMAND_LINE_PARSER_FALSE },
+    { 0, }
+};
+
+/* 現在時刻[us]を取得（差分のみ意味を持つ） */
+static uint64_t get_time_microseconds(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000
+        + (uint64_t)((counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart);
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+#else
+    return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+/* 入力の生成: 正弦波・チャープに擬似乱数を重畳
+* 処理系のrandに依らず同じ入力になるようxorshiftを使う */
+static void generate_input(int16_t **input, uint32_t num_samples)
+{
+    uint32_t ch, smpl, seed = 2463534242UL;
+
+    for (ch = 0; ch < MOIBENCH_NUM_CHANNELS; ch++) {
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            const double t = (double)smpl / MOIBENCH_SAMPLING_RATE;
+            double val;
+            seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+            if (ch == 0) {
+                val = 12000.0 * sin(2.0 * 3.14159265358979 * 440.0 * t);
+            } else {
+                val = 12000.0 * sin(2.0 * 3.14159265358979 * (100.0 + 1000.0 * t) * t);
+            }
+            input[ch][smpl] = (int16_t)(val + (double)(seed % 1024) - 512.0);
+        }
+    }
+}
+
+/* 符号化結果のハッシュ（FNV-1a）: ビルド間で出力が一致するかの確認用 */
+static uint32_t calculate_hash(const uint8_t *data, uint32_t size)
+{
+    uint32_t i, hash = 2166136261UL;
+
+    for (i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619UL;
+    }
+
+    return hash;
+}
+
+/* 1設定の計測: 最速の所要時間[us]を返す（失敗時は0） */
+static uint64_t measure_setting(
+        const struct MOIBenchSetting *setting, uint32_t num_threads, uint32_t num_repeats,
+        const int16_t *const *input, uint32_t num_samples,
+        uint8_t *buffer, uint32_t buffer_size, uint32_t *output_size)
+{
+    uint32_t i;
+    uint64_t best = 0;
+    struct MOIEncoder *encoder;
+    struct MOIEncoderConfig config;
+    struct MOIEncodeParameter param;
+
+    config.max_block_size = MOIBENCH_BLOCK_SIZE;
+    config.max_num_threads = num_threads;
+    config.max_search_cache_size = MOIBENCH_SEARCH_CACHE_SIZE;
+    config.max_block_cache_size = 0;
+    if ((encoder = MOIEncoder_Create(&config, NULL, 0)) == NULL) {
+        return 0;
+    }
+
+    memset(&param, 0, sizeof(struct MOIEncodeParameter));
+    param.num_channels = MOIBENCH_NUM_CHANNELS;
+    param.sampling_rate = MOIBENCH_SAMPLING_RATE;
+    param.bits_per_sample = MOI_BITS_PER_SAMPLE;
+    param.block_size = MOIBENCH_BLOCK_SIZE;
+    param.search_method = setting->search_method;
+    param.search_beam_width = setting->search_beam_width;
+    param.search_depth = setting->search_depth;
+    param.trellis_num_states = setting->trellis_num_states;
+    param.num_threads = num_threads;
+    if (MOIEncoder_SetEncodeParameter(encoder, &param) != MOI_APIRESULT_OK) {
+        MOIEncoder_Destroy(encoder);
+        return 0;
+    }
+
+    for (i = 0; i < num_repeats; i++) {
+        const uint64_t start = get_time_microseconds();
+        uint64_t elapsed;
+        if (MOIEncoder_EncodeWhole(encoder, input, num_samples, buffer, buffer_size, output_size)
+                != MOI_APIRESULT_OK) {
+            MOIEncoder_Destroy(encoder);
+            return 0;
+        }
+        /* 0は失敗を表すので1us未満は1usとする */
+        elapsed = get_time_microseconds() - start;
+        elapsed = (elapsed > 0) ? elapsed : 1;
+        if ((best == 0) || (elapsed < best)) {
+            best = elapsed;
+        }
+    }
+
+    MOIEncoder_Destroy(encoder);
+    return best;
+}
+
+/* 数値オプションを取得 */
+static int32_t check_get_numerical_option(char **argv, const char *option, uint32_t *result)
+{
+    char *e;
+    uint32_t tmp;
+    const char *lstr = CommandLineParser_GetArgumentString(command_line_spec, option);
+
+    tmp = (uint32_t)strtol(lstr, &e, 10);
+    if ((*e != '\0') || (tmp == 0)) {
+        fprintf(stderr, "%s: invalid %s. (%s)\n", argv[0], option, lstr);
+        return 1;
+    }
+
+    (*result) = tmp;
+    return 0;
+}
+
+/* メインエントリ */
+int main(int argc, char **argv)
+{
+    int16_t *input[MOIBENCH_NUM_CHANNELS];
+    uint8_t *buffer;
+    uint32_t i, j, ch, seconds, num_repeats, num_threads, num_samples, buffer_size;
+    const char *filename_ptr[1] = { NULL };
+
+    /* コマンドライン解析 */
+    if (CommandLineParser_ParseArguments(command_line_spec,
+                argc, (const char* const *)argv, filename_ptr, sizeof(filename_ptr) / sizeof(filename_ptr[0]))
+            != COMMAND_LINE_PARSER_RESULT_OK) {
+        return 1;
+    }
+    if (CommandLineParser_GetOptionAcquired(command_line_spec, "help") == COMMAND_LINE_PARSER_TRUE) {
+        printf("Usage: %s [options] \n", argv[0]);
+        printf("options: \n");
+        CommandLineParser_PrintDescription(command_line_spec);
+        return 0;
+    }
+    if ((check_get_numerical_option(argv, "seconds", &seconds) != 0)
+            || (check_get_numerical_option(argv, "num-repeats", &num_repeats) != 0)
+            || (check_get_numerical_option(argv, "num-threads", &num_threads) != 0)) {
+        return 1;
+    }
+    if (num_threads > MOI_MAX_NUM_THREADS) {
+        fprintf(stderr, "%s: number of threads(=%d) is out of range (%d,%d]. \n",
+                argv[0], num_threads, 0, MOI_MAX_NUM_THREADS);
+        return 1;
+    }
+
+    /* 入力と出力領域の準備（出力は入力の16bit PCMより大きくならない） */
+    num_samples = seconds * MOIBENCH_SAMPLING_RATE;
+    for (ch = 0; ch < MOIBENCH_NUM_CHANNELS; ch++) {
+        input[ch] = (int16_t *)malloc(sizeof(int16_t) * num_samples);
+    }
+    buffer_size = (uint32_t)(MOIBENCH_NUM_CHANNELS * num_samples * sizeof(int16_t)) + MOIBENCH_BLOCK_SIZE;
+    buffer = (uint8_t *)malloc(buffer_size);
+    generate_input(input, num_samples);
+
+    printf("input: %d ch, %d Hz, %d sec, block size %d, best of %d runs \n",
+            MOIBENCH_NUM_CHANNELS, MOIBENCH_SAMPLING_RATE, seconds, MOIBENCH_BLOCK_SIZE, num_repeats);
+
+    /* 各設定を1スレッドと指定スレッド数で計測 */
+    for (i = 0; i < sizeof(bench_settings) / sizeof(bench_settings[0]); i++) {
+        uint32_t threads[2];
+        threads[0] = 1;
+        threads[1] = num_threads;
+        for (j = 0; j < ((num_threads > 1) ? 2 : 1); j++) {
+            uint32_t output_size = 0;
+            const uint64_t best = measure_setting(&bench_settings[i], threads[j], num_repeats,
+                    (const int16_t *const *)input, num_samples, buffer, buffer_size, &output_size);
+            if (best == 0) {
+                fprintf(stderr, "%s: failed to encode with %s. \n", argv[0], bench_settings[i].name);
+                return 1;
+            }
+            printf("%-12s threads:%2d time:%9.3f ms speed:%7.2fx realtime hash:%08lx \n",
+                    bench_settings[i].name, threads[j], (double)best / 1000.0,
+                    ((double)seconds * 1000000.0) / (double)best,
+                    (unsigned long)calculate_hash(buffer, output_size));
+        }
+    }
+
+    free(buffer);
+    for (ch = 0; ch < MOIBENCH_NUM_CHANNELS; ch++) {
+        free(input[ch]);
+    }
+
+    return 0;
+}